@@ -1,15 +1,13 @@
 #pragma once
 
-#include <memory>
-
 #include "compiler/analysis/print/details/codegen-ast-printer.h"
-#include "compiler/compilation-structures/ast/codegen/ast.h"
+#include "compiler/compilation-structures/ast/codegen/flat-ast.h"
 
 namespace analysis {
 
-void print_codegen_ast(std::unique_ptr<codegen::ast::program>& program) noexcept {
-    details::codegen_ast_printer printer;
-    program->accept(printer);
+void print_codegen_ast(const codegen::ast::flat::program& program) noexcept {
+    details::codegen_ast_printer printer{program};
+    printer.print();
 }
 
 } // namespace analysis
@@ -1,303 +1,332 @@
 #include "compiler/analysis/print/details/codegen-ast-printer.h"
 
-#include "compiler/common/variant-helper.h"
-
 namespace analysis::details {
 
+namespace flat = codegen::ast::flat;
+using codegen::ast::node_kind;
+
 void codegen_ast_printer::print_indent() {
     for (int i = 0; i < indent; ++i) {
         std::cout << "  ";
     }
 }
 
-void codegen_ast_printer::visit(codegen::ast::program& node) {
+void codegen_ast_printer::print_child(flat::node_index node) {
+    print_indent();
+    print_node(node);
+}
+
+void codegen_ast_printer::print() {
     std::cout << "Program:\n";
     indent++;
-    if (!node.internal_classes.empty()) {
+    if (program.internal_class_count != 0) {
         print_indent();
         std::cout << "InternalClasses:\n";
         indent++;
-        for (auto& cls : node.internal_classes) {
+        for (uint32_t cls = 0; cls < program.internal_class_count; ++cls) {
             print_indent();
-            cls->accept(*this);
+            print_class(cls);
         }
         indent--;
     }
-    for (auto& cls : node.classes) {
+    for (auto cls = program.internal_class_count; cls < program.classes.size(); ++cls) {
         print_indent();
-        cls->accept(*this);
+        print_class(cls);
     }
     indent--;
 }
 
-void codegen_ast_printer::visit(codegen::ast::block& node) {
-    std::cout << "Block:\n";
-    indent++;
-    for (auto& item : node.items) {
-        print_indent();
-        item->accept(*this);
-    }
-    indent--;
-}
-
-void codegen_ast_printer::visit(codegen::ast::class_declaration& node) {
+void codegen_ast_printer::print_class(uint32_t cls) {
+    const auto& entry = program.classes[cls];
+    const auto& node = *entry.declaration;
     std::cout << "ClassDeclaration: name=" << node.name;
     if (node.base_class) {
         std::cout << ", extends=" << node.base_class->name;
     }
     std::cout << "\n";
     indent++;
-    for (auto& field : node.fields) {
+    for (size_t i = 0; i < node.fields.size(); ++i) {
         print_indent();
-        field->accept(*this);
+        print_field(entry.first_field + i);
     }
-    for (auto& method : node.methods) {
+    for (size_t i = 0; i < node.methods.size(); ++i) {
         print_indent();
-        method->accept(*this);
+        print_method(entry.first_method + i);
     }
-    for (auto& ctor : node.constructors) {
+    for (size_t i = 0; i < node.constructors.size(); ++i) {
         print_indent();
-        ctor->accept(*this);
+        print_constructor(entry.first_constructor + i);
     }
     indent--;
 }
 
-void codegen_ast_printer::visit(codegen::ast::field_declaration& node) {
-    std::cout << "FieldDeclaration: name=" << node.name;
-    if (node.type) {
-        std::cout << ", type=" << node.type->name;
+void codegen_ast_printer::print_field(uint32_t field) {
+    const auto& entry = program.fields[field];
+    std::cout << "FieldDeclaration: name=" << entry.declaration->name;
+    if (entry.declaration->type) {
+        std::cout << ", type=" << entry.declaration->type->name;
     }
     std::cout << "\n";
-    if (node.initializer) {
+    if (entry.initializer != flat::none) {
         indent++;
-        print_indent();
-        node.initializer->accept(*this);
+        print_child(entry.initializer);
         indent--;
     }
 }
 
-void codegen_ast_printer::visit(codegen::ast::variable_declaration& node) {
-    std::cout << "VariableDeclaration: name=" << node.name;
-    if (node.type) {
-        std::cout << ", type=" << node.type->name;
-    }
-    std::cout << "\n";
-    if (node.initializer) {
-        indent++;
+void codegen_ast_printer::print_parameters(uint32_t first, size_t count) {
+    print_indent();
+    std::cout << "Parameters:\n";
+    indent++;
+    for (size_t i = 0; i < count; ++i) {
+        const auto& parameter = *program.parameters[first + i];
         print_indent();
-        node.initializer->accept(*this);
-        indent--;
-    }
-}
-
-void codegen_ast_printer::visit(codegen::ast::parameter_declaration& node) {
-    std::cout << "ParameterDeclaration: name=" << node.name;
-    if (node.type) {
-        std::cout << ", type=" << node.type->name;
+        std::cout << "ParameterDeclaration: name=" << parameter.name;
+        if (parameter.type) {
+            std::cout << ", type=" << parameter.type->name;
+        }
+        std::cout << "\n";
     }
-    std::cout << "\n";
+    indent--;
 }
 
-void codegen_ast_printer::visit(codegen::ast::method_declaration& node) {
+void codegen_ast_printer::print_method(uint32_t method) {
+    const auto& entry = program.methods[method];
+    const auto& node = *entry.declaration;
     std::cout << "MethodDeclaration: name=" << node.name;
     if (node.return_type) {
         std::cout << ", return_type=" << node.return_type->name;
     }
     std::cout << "\n";
     indent++;
-    print_indent();
-    std::cout << "Parameters:\n";
-    indent++;
-    for (auto& param : node.parameters) {
-        print_indent();
-        param->accept(*this);
-    }
-    indent--;
-    if (node.body) {
+    print_parameters(entry.first_parameter, node.parameters.size());
+    if (entry.body != flat::none) {
         print_indent();
         std::cout << "Body:\n";
         indent++;
-        print_indent();
-        std::visit([this](auto& body) { body->accept(*this); }, *node.body);
+        print_child(entry.body);
         indent--;
     }
     indent--;
 }
 
-void codegen_ast_printer::visit(codegen::ast::constructor_declaration& node) {
+void codegen_ast_printer::print_constructor(uint32_t ctor) {
+    const auto& entry = program.constructors[ctor];
     std::cout << "ConstructorDeclaration:\n";
     indent++;
-    print_indent();
-    std::cout << "Parameters:\n";
-    indent++;
-    for (auto& param : node.parameters) {
-        print_indent();
-        param->accept(*this);
-    }
-    indent--;
-    if (node.super_constructor) {
+    print_parameters(entry.first_parameter, entry.declaration->parameters.size());
+    if (entry.super_call != flat::none) {
         print_indent();
         std::cout << "Super constructor call:\n";
         indent++;
-        print_indent();
-        node.super_constructor->accept(*this);
+        print_child(entry.super_call);
         indent--;
     }
-    if (node.body) {
+    if (entry.body != flat::none) {
         print_indent();
         std::cout << "Body:\n";
         indent++;
-        print_indent();
-        node.body->accept(*this);
+        print_child(entry.body);
         indent--;
     }
     indent--;
 }
 
-void codegen_ast_printer::visit(codegen::ast::variable_assignment& node) {
-    std::visit(overloaded{[](codegen::ast::variable_declaration* decl) { std::cout << "VariableAssignment: target=" << decl->name << "\n"; },
-                          [](codegen::ast::parameter_declaration* decl) { std::cout << "VariableAssignment: target=" << decl->name << "\n"; },
-                          [](codegen::ast::field_declaration* decl) { std::cout << "VariableAssignment: target=" << decl->name << "\n"; }},
-               node.target);
-    indent++;
-    print_indent();
-    node.value->accept(*this);
-    indent--;
-}
+void codegen_ast_printer::print_node(flat::node_index node) {
+    auto lhs = program.lhs[node];
+    auto rhs = program.rhs[node];
+    auto target_name = [this](uint32_t target) {
+        auto index = flat::index_of_target(target);
+        switch (flat::kind_of_target(target)) {
+        case flat::target_kind::variable:
+            return program.variables[index]->name;
+        case flat::target_kind::parameter:
+            return program.parameters[index]->name;
+        case flat::target_kind::field:
+            return program.fields[index].declaration->name;
+        }
+        return common::symbol_id{};
+    };
 
-void codegen_ast_printer::visit(codegen::ast::field_assignment& node) {
-    std::cout << "FieldAssignment: target=" << node.target->member->name << "\n";
-    indent++;
-    print_indent();
-    node.value->accept(*this);
-    indent--;
-}
+    switch (program.kinds[node]) {
+    case node_kind::block:
+        std::cout << "Block:\n";
+        indent++;
+        for (auto item : program.list(lhs)) {
+            print_child(item);
+        }
+        indent--;
+        break;
 
-void codegen_ast_printer::visit(codegen::ast::while_statement& node) {
-    std::cout << "WhileStatement:\n";
-    indent++;
-    print_indent();
-    std::cout << "Condition:\n";
-    indent++;
-    print_indent();
-    node.condition->accept(*this);
-    indent--;
-    print_indent();
-    std::cout << "Body:\n";
-    indent++;
-    print_indent();
-    node.body->accept(*this);
-    indent -= 2;
-}
+    case node_kind::variable_declaration: {
+        const auto& variable = *program.variables[lhs];
+        std::cout << "VariableDeclaration: name=" << variable.name;
+        if (variable.type) {
+            std::cout << ", type=" << variable.type->name;
+        }
+        std::cout << "\n";
+        if (rhs != flat::none) {
+            indent++;
+            print_child(rhs);
+            indent--;
+        }
+        break;
+    }
 
-void codegen_ast_printer::visit(codegen::ast::if_statement& node) {
-    std::cout << "IfStatement:\n";
-    indent++;
-    print_indent();
-    std::cout << "Condition:\n";
-    indent++;
-    print_indent();
-    node.condition->accept(*this);
-    indent--;
-    print_indent();
-    std::cout << "TrueBranch:\n";
-    indent++;
-    print_indent();
-    node.true_branch->accept(*this);
-    indent--;
-    if (node.false_branch) {
-        print_indent();
-        std::cout << "FalseBranch:\n";
+    case node_kind::variable_assignment:
+        std::cout << "VariableAssignment: target=" << target_name(lhs) << "\n";
+        indent++;
+        print_child(rhs);
+        indent--;
+        break;
+
+    case node_kind::field_assignment:
+        std::cout << "FieldAssignment: target=" << program.fields[program.rhs[lhs]].declaration->name << "\n";
+        indent++;
+        print_child(rhs);
+        indent--;
+        break;
+
+    case node_kind::while_statement:
+        std::cout << "WhileStatement:\n";
         indent++;
         print_indent();
-        node.false_branch->accept(*this);
+        std::cout << "Condition:\n";
+        indent++;
+        print_child(lhs);
         indent--;
-    }
-    indent--;
-}
+        print_indent();
+        std::cout << "Body:\n";
+        indent++;
+        print_child(rhs);
+        indent -= 2;
+        break;
 
-void codegen_ast_printer::visit(codegen::ast::return_statement& node) {
-    std::cout << "ReturnStatement:\n";
-    if (node.value) {
+    case node_kind::if_statement: {
+        auto false_branch = program.extra[rhs + 1];
+        std::cout << "IfStatement:\n";
         indent++;
         print_indent();
-        node.value->accept(*this);
+        std::cout << "Condition:\n";
+        indent++;
+        print_child(lhs);
         indent--;
+        print_indent();
+        std::cout << "TrueBranch:\n";
+        indent++;
+        print_child(program.extra[rhs]);
+        indent--;
+        if (false_branch != flat::none) {
+            print_indent();
+            std::cout << "FalseBranch:\n";
+            indent++;
+            print_child(false_branch);
+            indent--;
+        }
+        indent--;
+        break;
     }
-}
 
-void codegen_ast_printer::visit(codegen::ast::literal_expression& node) {
-    std::cout << "LiteralExpression: ";
-    std::visit([](auto&& val) { std::cout << val << "\n"; }, node.value);
-}
+    case node_kind::return_statement:
+        std::cout << "ReturnStatement:\n";
+        if (lhs != flat::none) {
+            indent++;
+            print_child(lhs);
+            indent--;
+        }
+        break;
 
-void codegen_ast_printer::visit(codegen::ast::this_expression& node) {
-    std::cout << "ThisExpression";
-    if (node.type) {
-        std::cout << ": type=" << node.type->name;
-    }
-    std::cout << "\n";
-}
+    case node_kind::literal_expression:
+        std::cout << "LiteralExpression: ";
+        switch (static_cast<flat::literal_kind>(lhs)) {
+        case flat::literal_kind::integer:
+            std::cout << program.integers[rhs] << "\n";
+            break;
+        case flat::literal_kind::real:
+            std::cout << program.reals[rhs] << "\n";
+            break;
+        case flat::literal_kind::boolean:
+            std::cout << (rhs != 0) << "\n";
+            break;
+        }
+        break;
 
-void codegen_ast_printer::visit(codegen::ast::identifier_expression& node) {
-    std::visit(overloaded{[](codegen::ast::variable_declaration* decl) { std::cout << "IdentifierExpression: variable name=" << decl->name << "\n"; },
-                          [](codegen::ast::parameter_declaration* decl) { std::cout << "IdentifierExpression: parameter target=" << decl->name << "\n"; },
-                          [](codegen::ast::field_declaration* decl) { std::cout << "IdentifierExpression: field target=" << decl->name << "\n"; }},
-               node.target);
-}
+    case node_kind::this_expression:
+        std::cout << "ThisExpression";
+        if (auto* type = program.type(node)) {
+            std::cout << ": type=" << type->name;
+        }
+        std::cout << "\n";
+        break;
 
-void codegen_ast_printer::visit(codegen::ast::method_call_expression& node) {
-    std::cout << "MethodCallExpression: method=" << node.method->name;
-    if (node.return_type) {
-        std::cout << ", return_type=" << node.return_type->name;
+    case node_kind::identifier_expression: {
+        auto index = flat::index_of_target(lhs);
+        switch (flat::kind_of_target(lhs)) {
+        case flat::target_kind::variable:
+            std::cout << "IdentifierExpression: variable name=" << program.variables[index]->name << "\n";
+            break;
+        case flat::target_kind::parameter:
+            std::cout << "IdentifierExpression: parameter target=" << program.parameters[index]->name << "\n";
+            break;
+        case flat::target_kind::field:
+            std::cout << "IdentifierExpression: field target=" << program.fields[index].declaration->name << "\n";
+            break;
+        }
+        break;
     }
-    std::cout << "\n";
-    indent++;
-    print_indent();
-    std::cout << "Object:\n";
-    indent++;
-    print_indent();
-    node.object->accept(*this);
-    indent--;
-    print_indent();
-    std::cout << "Arguments:\n";
-    indent++;
-    for (auto& arg : node.arguments) {
+
+    case node_kind::method_call_expression:
+        std::cout << "MethodCallExpression: method=" << program.methods[program.extra[rhs]].declaration->name;
+        if (auto* type = program.type(node)) {
+            std::cout << ", return_type=" << type->name;
+        }
+        std::cout << "\n";
+        indent++;
         print_indent();
-        arg->accept(*this);
-    }
-    indent -= 2;
-}
+        std::cout << "Object:\n";
+        indent++;
+        print_child(lhs);
+        indent--;
+        print_indent();
+        std::cout << "Arguments:\n";
+        indent++;
+        for (auto argument : program.list(rhs + 1)) {
+            print_child(argument);
+        }
+        indent -= 2;
+        break;
 
-void codegen_ast_printer::visit(codegen::ast::constructor_call_expression& node) {
-    std::cout << "ConstructorCallExpression:\n";
-    indent++;
-    print_indent();
-    std::cout << "Class: " << node.constructor->class_owner->name << "\n";
-    print_indent();
-    std::cout << "Arguments:\n";
-    indent++;
-    for (auto& arg : node.arguments) {
+    case node_kind::constructor_call_expression:
+        std::cout << "ConstructorCallExpression:\n";
+        indent++;
         print_indent();
-        arg->accept(*this);
-    }
-    indent -= 2;
-}
+        std::cout << "Class: " << program.constructors[lhs].declaration->class_owner->name << "\n";
+        print_indent();
+        std::cout << "Arguments:\n";
+        indent++;
+        for (auto argument : program.list(rhs)) {
+            print_child(argument);
+        }
+        indent -= 2;
+        break;
 
-void codegen_ast_printer::visit(codegen::ast::member_expression& node) {
-    std::cout << "MemberExpression: member=" << node.member->name << "\n";
-    indent++;
-    print_indent();
-    node.object->accept(*this);
-    indent--;
-}
+    case node_kind::member_expression:
+        std::cout << "MemberExpression: member=" << program.fields[rhs].declaration->name << "\n";
+        indent++;
+        print_child(lhs);
+        indent--;
+        break;
 
-void codegen_ast_printer::visit(codegen::ast::grouping_expression& node) {
-    std::cout << "GroupingExpression:\n";
-    indent++;
-    print_indent();
-    node.inner->accept(*this);
-    indent--;
+    case node_kind::grouping_expression:
+        std::cout << "GroupingExpression:\n";
+        indent++;
+        print_child(lhs);
+        indent--;
+        break;
+
+    default:
+        break;
+    }
 }
 
 } // namespace analysis::details
@@ -1,39 +1,31 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 
-#include "compiler/compilation-structures/ast/codegen/ast-visitor.h"
-#include "compiler/compilation-structures/ast/codegen/ast.h"
+#include "compiler/compilation-structures/ast/codegen/flat-ast.h"
 
 namespace analysis::details {
 
-class codegen_ast_printer : public codegen::ast::visitor {
+class codegen_ast_printer {
 public:
-    void visit(codegen::ast::program& node) override;
-    void visit(codegen::ast::block& node) override;
-    void visit(codegen::ast::class_declaration& node) override;
-    void visit(codegen::ast::field_declaration& node) override;
-    void visit(codegen::ast::variable_declaration& node) override;
-    void visit(codegen::ast::parameter_declaration& node) override;
-    void visit(codegen::ast::method_declaration& node) override;
-    void visit(codegen::ast::constructor_declaration& node) override;
-    void visit(codegen::ast::variable_assignment& node) override;
-    void visit(codegen::ast::field_assignment& node) override;
-    void visit(codegen::ast::while_statement& node) override;
-    void visit(codegen::ast::if_statement& node) override;
-    void visit(codegen::ast::return_statement& node) override;
-    void visit(codegen::ast::literal_expression& node) override;
-    void visit(codegen::ast::this_expression& node) override;
-    void visit(codegen::ast::identifier_expression& node) override;
-    void visit(codegen::ast::method_call_expression& node) override;
-    void visit(codegen::ast::constructor_call_expression& node) override;
-    void visit(codegen::ast::member_expression& node) override;
-    void visit(codegen::ast::grouping_expression& node) override;
+    explicit codegen_ast_printer(const codegen::ast::flat::program& program) : program(program) {}
+
+    void print();
 
 private:
+    const codegen::ast::flat::program& program;
     int indent = 0;
 
     void print_indent();
+    void print_class(uint32_t cls);
+    void print_field(uint32_t field);
+    void print_method(uint32_t method);
+    void print_constructor(uint32_t ctor);
+    void print_parameters(uint32_t first, size_t count);
+    void print_node(codegen::ast::flat::node_index node);
+    void print_child(codegen::ast::flat::node_index node);
 };
 
 } // namespace analysis::details
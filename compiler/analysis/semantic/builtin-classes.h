@@ -1,326 +1,307 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "compiler/common/arena.h"
 #include "compiler/compilation-structures/ast/codegen/ast.h"
 #include "compiler/compilation-structures/symbol-table.h"
 #include "compiler/compilation-structures/type-table.h"
 
 namespace analysis::semantic::builtin {
 
-inline void add_method(structures::class_symbol* cls,
-                       const std::string& name,
-                       const structures::type* return_type,
-                       std::vector<const structures::type*> param_types,
-                       structures::type_table& type_table) {
-    std::string mangled = structures::mangle_method_name(name, param_types);
-    auto method = std::make_unique<structures::method_symbol>(mangled, name, cls->class_scope.get(), return_type, std::move(param_types));
-    cls->methods.push_back(method.get());
-    cls->class_scope->add(std::move(method));
+// The prelude: built-in classes and their members as constant tables. The symbols, types and codegen declarations built
+// from them once are shared by every compilation, which only adds their names to its own tables.
+enum class class_id : uint8_t { Class, AnyValue, AnyRef, Integer, Real, Boolean, Unit, ArrayInteger, IO, none };
+
+struct class_entry {
+    std::string_view name;
+    class_id base;
+};
+
+// a base comes before its subclasses
+inline constexpr std::array<class_entry, 9> classes = {{
+    {"Class", class_id::none},
+    {"AnyValue", class_id::Class},
+    {"AnyRef", class_id::Class},
+    {"Integer", class_id::AnyValue},
+    {"Real", class_id::AnyValue},
+    {"Boolean", class_id::AnyValue},
+    {"Unit", class_id::AnyValue},
+    {"ArrayInteger", class_id::AnyRef},
+    {"IO", class_id::AnyValue},
+}};
+
+constexpr size_t index(class_id id) noexcept {
+    return static_cast<size_t>(id);
 }
 
-inline void add_constructor(structures::class_symbol* cls, std::vector<const structures::type*> param_types, structures::type_table& type_table) {
-    std::string mangled = structures::mangle_method_name(cls->name, param_types);
-    auto ctor =
-        std::make_unique<structures::method_symbol>(mangled, cls->name, cls->class_scope.get(), type_table.resolveType(cls->name), std::move(param_types));
-    cls->constructors.push_back(ctor.get());
-    cls->class_scope->add(std::move(ctor));
-}
-
-inline void add_field(structures::class_symbol* cls, const std::string& name, const structures::type* field_type) {
-    auto field = std::make_unique<structures::variable_symbol>(name, field_type);
-    cls->fields.push_back(field.get());
-    cls->class_scope->add(std::move(field));
-}
-
-inline void add_builtin_classes(structures::symbol_table& sym_table, structures::type_table& type_table) {
-    auto class_sym = std::make_unique<structures::class_symbol>("Class", &sym_table, nullptr);
-    type_table.addClass("Class", nullptr);
-    auto* class_ptr = class_sym.get();
-    sym_table.add(std::move(class_sym));
-
-    auto anyvalue_sym = std::make_unique<structures::class_symbol>("AnyValue", class_ptr->class_scope.get(), class_ptr);
-    type_table.addClass("AnyValue", nullptr);
-    auto* anyvalue_ptr = anyvalue_sym.get();
-    sym_table.add(std::move(anyvalue_sym));
-
-    auto anyref_sym = std::make_unique<structures::class_symbol>("AnyRef", class_ptr->class_scope.get(), class_ptr);
-    type_table.addClass("AnyRef", nullptr);
-    auto* anyref_ptr = anyref_sym.get();
-    sym_table.add(std::move(anyref_sym));
-
-    auto integer_sym = std::make_unique<structures::class_symbol>("Integer", anyvalue_ptr->class_scope.get(), anyvalue_ptr);
-    type_table.addClass("Integer", nullptr);
-    auto* integer_ptr = integer_sym.get();
-    sym_table.add(std::move(integer_sym));
-
-    auto real_sym = std::make_unique<structures::class_symbol>("Real", anyvalue_ptr->class_scope.get(), anyvalue_ptr);
-    type_table.addClass("Real", nullptr);
-    auto* real_ptr = real_sym.get();
-    sym_table.add(std::move(real_sym));
-
-    auto boolean_sym = std::make_unique<structures::class_symbol>("Boolean", anyvalue_ptr->class_scope.get(), anyvalue_ptr);
-    type_table.addClass("Boolean", nullptr);
-    auto* boolean_ptr = boolean_sym.get();
-    sym_table.add(std::move(boolean_sym));
-
-    auto unit_sym = std::make_unique<structures::class_symbol>("Unit", anyvalue_ptr->class_scope.get(), anyvalue_ptr);
-    type_table.addClass("Unit", nullptr);
-    auto* unit_ptr = unit_sym.get();
-    sym_table.add(std::move(unit_sym));
-
-    auto array_integer_sym = std::make_unique<structures::class_symbol>("ArrayInteger", anyref_ptr->class_scope.get(), anyref_ptr);
-    type_table.addClass("ArrayInteger", nullptr);
-    auto *array_integer_ptr = array_integer_sym.get();
-    sym_table.add(std::move(array_integer_sym));
-
-    auto io_sym = std::make_unique<structures::class_symbol>("IO", anyvalue_ptr->class_scope.get(), anyvalue_ptr);
-    type_table.addClass("IO", nullptr);
-    auto *io_ptr = io_sym.get();
-    sym_table.add(std::move(io_sym));
-
-    add_constructor(integer_ptr, {type_table.resolveType("Integer")}, type_table);
-    add_constructor(integer_ptr, {type_table.resolveType("Real")}, type_table);
-
-    add_field(integer_ptr, "Min", type_table.resolveType("Integer"));
-    add_field(integer_ptr, "Max", type_table.resolveType("Integer"));
-
-    add_method(integer_ptr, "toReal", type_table.resolveType("Real"), {}, type_table);
-    add_method(integer_ptr, "toBoolean", type_table.resolveType("Boolean"), {}, type_table);
-    add_method(integer_ptr, "UnaryMinus", type_table.resolveType("Integer"), {}, type_table);
-    add_method(integer_ptr, "Plus", type_table.resolveType("Integer"), {type_table.resolveType("Integer")}, type_table);
-    add_method(integer_ptr, "Plus", type_table.resolveType("Real"), {type_table.resolveType("Real")}, type_table);
-    add_method(integer_ptr, "Minus", type_table.resolveType("Integer"), {type_table.resolveType("Integer")}, type_table);
-    add_method(integer_ptr, "Minus", type_table.resolveType("Real"), {type_table.resolveType("Real")}, type_table);
-    add_method(integer_ptr, "Mult", type_table.resolveType("Integer"), {type_table.resolveType("Integer")}, type_table);
-    add_method(integer_ptr, "Mult", type_table.resolveType("Real"), {type_table.resolveType("Real")}, type_table);
-    add_method(integer_ptr, "Div", type_table.resolveType("Integer"), {type_table.resolveType("Integer")}, type_table);
-    add_method(integer_ptr, "Div", type_table.resolveType("Real"), {type_table.resolveType("Real")}, type_table);
-    add_method(integer_ptr, "Rem", type_table.resolveType("Integer"), {type_table.resolveType("Integer")}, type_table);
-    add_method(integer_ptr, "Less", type_table.resolveType("Boolean"), {type_table.resolveType("Integer")}, type_table);
-    add_method(integer_ptr, "Less", type_table.resolveType("Boolean"), {type_table.resolveType("Real")}, type_table);
-    add_method(integer_ptr, "LessEqual", type_table.resolveType("Boolean"), {type_table.resolveType("Integer")}, type_table);
-    add_method(integer_ptr, "LessEqual", type_table.resolveType("Boolean"), {type_table.resolveType("Real")}, type_table);
-    add_method(integer_ptr, "Greater", type_table.resolveType("Boolean"), {type_table.resolveType("Integer")}, type_table);
-    add_method(integer_ptr, "Greater", type_table.resolveType("Boolean"), {type_table.resolveType("Real")}, type_table);
-    add_method(integer_ptr, "GreaterEqual", type_table.resolveType("Boolean"), {type_table.resolveType("Integer")}, type_table);
-    add_method(integer_ptr, "GreaterEqual", type_table.resolveType("Boolean"), {type_table.resolveType("Real")}, type_table);
-    add_method(integer_ptr, "Equal", type_table.resolveType("Boolean"), {type_table.resolveType("Integer")}, type_table);
-    add_method(integer_ptr, "Equal", type_table.resolveType("Boolean"), {type_table.resolveType("Real")}, type_table);
-
-    add_constructor(real_ptr, {type_table.resolveType("Real")}, type_table);
-    add_constructor(real_ptr, {type_table.resolveType("Integer")}, type_table);
-
-    add_field(real_ptr, "Min", type_table.resolveType("Real"));
-    add_field(real_ptr, "Max", type_table.resolveType("Real"));
-    add_field(real_ptr, "Epsilon", type_table.resolveType("Real"));
-
-    add_method(real_ptr, "toInteger", type_table.resolveType("Integer"), {}, type_table);
-    add_method(real_ptr, "UnaryMinus", type_table.resolveType("Real"), {}, type_table);
-    add_method(real_ptr, "Plus", type_table.resolveType("Real"), {type_table.resolveType("Real")}, type_table);
-    add_method(real_ptr, "Plus", type_table.resolveType("Real"), {type_table.resolveType("Integer")}, type_table);
-    add_method(real_ptr, "Minus", type_table.resolveType("Real"), {type_table.resolveType("Real")}, type_table);
-    add_method(real_ptr, "Minus", type_table.resolveType("Real"), {type_table.resolveType("Integer")}, type_table);
-    add_method(real_ptr, "Mult", type_table.resolveType("Real"), {type_table.resolveType("Real")}, type_table);
-    add_method(real_ptr, "Mult", type_table.resolveType("Real"), {type_table.resolveType("Integer")}, type_table);
-    add_method(real_ptr, "Div", type_table.resolveType("Real"), {type_table.resolveType("Real")}, type_table);
-    add_method(real_ptr, "Div", type_table.resolveType("Real"), {type_table.resolveType("Integer")}, type_table);
-    add_method(real_ptr, "Rem", type_table.resolveType("Real"), {type_table.resolveType("Integer")}, type_table);
-    add_method(real_ptr, "Less", type_table.resolveType("Boolean"), {type_table.resolveType("Real")}, type_table);
-    add_method(real_ptr, "Less", type_table.resolveType("Boolean"), {type_table.resolveType("Integer")}, type_table);
-    add_method(real_ptr, "LessEqual", type_table.resolveType("Boolean"), {type_table.resolveType("Real")}, type_table);
-    add_method(real_ptr, "LessEqual", type_table.resolveType("Boolean"), {type_table.resolveType("Integer")}, type_table);
-    add_method(real_ptr, "Greater", type_table.resolveType("Boolean"), {type_table.resolveType("Real")}, type_table);
-    add_method(real_ptr, "Greater", type_table.resolveType("Boolean"), {type_table.resolveType("Integer")}, type_table);
-    add_method(real_ptr, "GreaterEqual", type_table.resolveType("Boolean"), {type_table.resolveType("Real")}, type_table);
-    add_method(real_ptr, "GreaterEqual", type_table.resolveType("Boolean"), {type_table.resolveType("Integer")}, type_table);
-    add_method(real_ptr, "Equal", type_table.resolveType("Boolean"), {type_table.resolveType("Real")}, type_table);
-    add_method(real_ptr, "Equal", type_table.resolveType("Boolean"), {type_table.resolveType("Integer")}, type_table);
-
-    add_constructor(boolean_ptr, {type_table.resolveType("Boolean")}, type_table);
-
-    add_method(boolean_ptr, "toInteger", type_table.resolveType("Integer"), {}, type_table);
-    add_method(boolean_ptr, "Or", type_table.resolveType("Boolean"), {type_table.resolveType("Boolean")}, type_table);
-    add_method(boolean_ptr, "And", type_table.resolveType("Boolean"), {type_table.resolveType("Boolean")}, type_table);
-    add_method(boolean_ptr, "Xor", type_table.resolveType("Boolean"), {type_table.resolveType("Boolean")}, type_table);
-    add_method(boolean_ptr, "Not", type_table.resolveType("Boolean"), {}, type_table);
-
-    add_constructor(unit_ptr, {}, type_table);
-
-    add_constructor(array_integer_ptr, {type_table.resolveType("Integer")}, type_table);
-    add_method(array_integer_ptr, "Len", type_table.resolveType("Integer"), {}, type_table);
-    add_method(array_integer_ptr, "Get", type_table.resolveType("Integer"), {type_table.resolveType("Integer")}, type_table);
-    add_method(array_integer_ptr, "Set", type_table.resolveType("Unit"), {type_table.resolveType("Integer"), type_table.resolveType("Integer")}, type_table);
-
-    add_constructor(io_ptr, {}, type_table);
-    add_method(io_ptr, "Print", type_table.resolveType("Unit"), {type_table.resolveType("Integer")}, type_table);
-    add_method(io_ptr, "Print", type_table.resolveType("Unit"), {type_table.resolveType("Real")}, type_table);
-    add_method(io_ptr, "Print", type_table.resolveType("Unit"), {type_table.resolveType("Boolean")}, type_table);
+struct parameter_entry {
+    std::string_view name;
+    class_id type;
+};
+
+struct field_entry {
+    class_id owner;
+    std::string_view name;
+    class_id type;
+};
+
+// A method, or a constructor when the name is the owner's; the mangled name is what structures::mangle_method_name
+// returns for it.
+struct method_entry {
+    class_id owner;
+    std::string_view name;
+    std::string_view mangled;
+    class_id return_type;
+    uint8_t arity;
+    std::array<parameter_entry, 2> parameters;
+};
+
+inline constexpr std::array<field_entry, 5> fields = {{
+    {class_id::Integer, "Min", class_id::Integer},
+    {class_id::Integer, "Max", class_id::Integer},
+    {class_id::Real, "Min", class_id::Real},
+    {class_id::Real, "Max", class_id::Real},
+    {class_id::Real, "Epsilon", class_id::Real},
+}};
+
+inline constexpr std::array<method_entry, 8> constructors = {{
+    {class_id::Integer, "Integer", "Integer(Integer)", class_id::Integer, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Integer, "Integer", "Integer(Real)", class_id::Integer, 1, {{{"p", class_id::Real}}}},
+    {class_id::Real, "Real", "Real(Real)", class_id::Real, 1, {{{"p", class_id::Real}}}},
+    {class_id::Real, "Real", "Real(Integer)", class_id::Real, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Boolean, "Boolean", "Boolean(Boolean)", class_id::Boolean, 1, {{{"p", class_id::Boolean}}}},
+    {class_id::Unit, "Unit", "Unit()", class_id::Unit, 0, {}},
+    {class_id::ArrayInteger, "ArrayInteger", "ArrayInteger(Integer)", class_id::ArrayInteger, 1, {{{"size", class_id::Integer}}}},
+    {class_id::IO, "IO", "IO()", class_id::IO, 0, {}},
+}};
+
+inline constexpr std::array<method_entry, 54> methods = {{
+    {class_id::Integer, "toReal", "toReal()", class_id::Real, 0, {}},
+    {class_id::Integer, "toBoolean", "toBoolean()", class_id::Boolean, 0, {}},
+    {class_id::Integer, "UnaryMinus", "UnaryMinus()", class_id::Integer, 0, {}},
+    {class_id::Integer, "Plus", "Plus(Integer)", class_id::Integer, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Integer, "Plus", "Plus(Real)", class_id::Real, 1, {{{"p", class_id::Real}}}},
+    {class_id::Integer, "Minus", "Minus(Integer)", class_id::Integer, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Integer, "Minus", "Minus(Real)", class_id::Real, 1, {{{"p", class_id::Real}}}},
+    {class_id::Integer, "Mult", "Mult(Integer)", class_id::Integer, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Integer, "Mult", "Mult(Real)", class_id::Real, 1, {{{"p", class_id::Real}}}},
+    {class_id::Integer, "Div", "Div(Integer)", class_id::Integer, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Integer, "Div", "Div(Real)", class_id::Real, 1, {{{"p", class_id::Real}}}},
+    {class_id::Integer, "Rem", "Rem(Integer)", class_id::Integer, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Integer, "Less", "Less(Integer)", class_id::Boolean, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Integer, "Less", "Less(Real)", class_id::Boolean, 1, {{{"p", class_id::Real}}}},
+    {class_id::Integer, "LessEqual", "LessEqual(Integer)", class_id::Boolean, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Integer, "LessEqual", "LessEqual(Real)", class_id::Boolean, 1, {{{"p", class_id::Real}}}},
+    {class_id::Integer, "Greater", "Greater(Integer)", class_id::Boolean, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Integer, "Greater", "Greater(Real)", class_id::Boolean, 1, {{{"p", class_id::Real}}}},
+    {class_id::Integer, "GreaterEqual", "GreaterEqual(Integer)", class_id::Boolean, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Integer, "GreaterEqual", "GreaterEqual(Real)", class_id::Boolean, 1, {{{"p", class_id::Real}}}},
+    {class_id::Integer, "Equal", "Equal(Integer)", class_id::Boolean, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Integer, "Equal", "Equal(Real)", class_id::Boolean, 1, {{{"p", class_id::Real}}}},
+
+    {class_id::Real, "toInteger", "toInteger()", class_id::Integer, 0, {}},
+    {class_id::Real, "UnaryMinus", "UnaryMinus()", class_id::Real, 0, {}},
+    {class_id::Real, "Plus", "Plus(Real)", class_id::Real, 1, {{{"p", class_id::Real}}}},
+    {class_id::Real, "Plus", "Plus(Integer)", class_id::Real, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Real, "Minus", "Minus(Real)", class_id::Real, 1, {{{"p", class_id::Real}}}},
+    {class_id::Real, "Minus", "Minus(Integer)", class_id::Real, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Real, "Mult", "Mult(Real)", class_id::Real, 1, {{{"p", class_id::Real}}}},
+    {class_id::Real, "Mult", "Mult(Integer)", class_id::Real, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Real, "Div", "Div(Real)", class_id::Real, 1, {{{"p", class_id::Real}}}},
+    {class_id::Real, "Div", "Div(Integer)", class_id::Real, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Real, "Rem", "Rem(Integer)", class_id::Real, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Real, "Less", "Less(Real)", class_id::Boolean, 1, {{{"p", class_id::Real}}}},
+    {class_id::Real, "Less", "Less(Integer)", class_id::Boolean, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Real, "LessEqual", "LessEqual(Real)", class_id::Boolean, 1, {{{"p", class_id::Real}}}},
+    {class_id::Real, "LessEqual", "LessEqual(Integer)", class_id::Boolean, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Real, "Greater", "Greater(Real)", class_id::Boolean, 1, {{{"p", class_id::Real}}}},
+    {class_id::Real, "Greater", "Greater(Integer)", class_id::Boolean, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Real, "GreaterEqual", "GreaterEqual(Real)", class_id::Boolean, 1, {{{"p", class_id::Real}}}},
+    {class_id::Real, "GreaterEqual", "GreaterEqual(Integer)", class_id::Boolean, 1, {{{"p", class_id::Integer}}}},
+    {class_id::Real, "Equal", "Equal(Real)", class_id::Boolean, 1, {{{"p", class_id::Real}}}},
+    {class_id::Real, "Equal", "Equal(Integer)", class_id::Boolean, 1, {{{"p", class_id::Integer}}}},
+
+    {class_id::Boolean, "toInteger", "toInteger()", class_id::Integer, 0, {}},
+    {class_id::Boolean, "Or", "Or(Boolean)", class_id::Boolean, 1, {{{"p", class_id::Boolean}}}},
+    {class_id::Boolean, "And", "And(Boolean)", class_id::Boolean, 1, {{{"p", class_id::Boolean}}}},
+    {class_id::Boolean, "Xor", "Xor(Boolean)", class_id::Boolean, 1, {{{"p", class_id::Boolean}}}},
+    {class_id::Boolean, "Not", "Not()", class_id::Boolean, 0, {}},
+
+    {class_id::ArrayInteger, "Len", "Len()", class_id::Integer, 0, {}},
+    {class_id::ArrayInteger, "Get", "Get(Integer)", class_id::Integer, 1, {{{"i", class_id::Integer}}}},
+    {class_id::ArrayInteger, "Set", "Set(Integer, Integer)", class_id::Unit, 2, {{{"i", class_id::Integer}, {"v", class_id::Integer}}}},
+
+    {class_id::IO, "Print", "Print(Integer)", class_id::Unit, 1, {{{"p", class_id::Integer}}}},
+    {class_id::IO, "Print", "Print(Real)", class_id::Unit, 1, {{{"p", class_id::Real}}}},
+    {class_id::IO, "Print", "Print(Boolean)", class_id::Unit, 1, {{{"p", class_id::Boolean}}}},
+}};
+
+// name(Type, Type), as structures::mangle_method_name spells it
+constexpr bool is_mangled_name(const method_entry& method) noexcept {
+    auto rest = method.mangled;
+    auto take = [&rest](std::string_view part) {
+        if (!rest.starts_with(part)) {
+            return false;
+        }
+        rest.remove_prefix(part.size());
+        return true;
+    };
+    if (!take(method.name) || !take("(")) {
+        return false;
+    }
+    for (size_t i = 0; i < method.arity; ++i) {
+        if ((i > 0 && !take(", ")) || !take(classes[index(method.parameters[i].type)].name)) {
+            return false;
+        }
+    }
+    return rest == ")";
 }
 
-inline void add_codegen_field(codegen::ast::class_declaration* cls, const std::string& name, codegen::ast::class_declaration* field_type) {
-    auto field = std::make_unique<codegen::ast::field_declaration>();
-    field->name = name;
-    field->type = field_type;
-    field->class_owner = cls;
-    cls->fields.push_back(std::move(field));
-}
+static_assert(std::ranges::all_of(methods, is_mangled_name), "a built-in method's mangled name doesn't match its signature");
+static_assert(std::ranges::all_of(constructors, is_mangled_name), "a built-in constructor's mangled name doesn't match its signature");
+static_assert(std::ranges::all_of(constructors, [](const method_entry& ctor) { return classes[index(ctor.owner)].name == ctor.name; }),
+              "a built-in constructor isn't named after its class");
+
+// The semantic side of the prelude, built the first time a compilation needs it and shared by every later one. It isn't
+// changed afterwards: the overload tables are indexed and the types numbered here, and the class scopes end at 'Class'
+// instead of leading on to a program's scope.
+struct semantic_prelude {
+    std::array<std::unique_ptr<structures::class_symbol>, classes.size()> symbols;
+    std::array<std::unique_ptr<structures::class_type>, classes.size()> types;
+
+    semantic_prelude() {
+        for (size_t i = 0; i < classes.size(); ++i) {
+            auto* base = classes[i].base == class_id::none ? nullptr : symbols[index(classes[i].base)].get();
+            common::symbol_id name{classes[i].name};
+            symbols[i] = std::make_unique<structures::class_symbol>(name, base ? base->class_scope.get() : nullptr, base);
+            types[i] = std::make_unique<structures::class_type>(name, nullptr);
+        }
+        number_types(index(class_id::Class));
+
+        auto add_overload = [&](const method_entry& entry, std::vector<structures::method_symbol*>& overloads) {
+            auto& cls = *symbols[index(entry.owner)];
+            std::vector<const structures::type*> param_types;
+            param_types.reserve(entry.arity);
+            for (size_t i = 0; i < entry.arity; ++i) {
+                param_types.push_back(types[index(entry.parameters[i].type)].get());
+            }
+            auto method = std::make_unique<structures::method_symbol>(common::symbol_id{entry.mangled},
+                                                                      common::symbol_id{entry.name},
+                                                                      cls.class_scope.get(),
+                                                                      types[index(entry.return_type)].get(),
+                                                                      std::move(param_types));
+            overloads.push_back(method.get());
+            cls.class_scope->add(std::move(method));
+        };
+        for (const auto& ctor : constructors) {
+            add_overload(ctor, symbols[index(ctor.owner)]->constructors);
+        }
+        for (const auto& method : methods) {
+            add_overload(method, symbols[index(method.owner)]->methods);
+        }
+        for (const auto& entry : fields) {
+            auto& cls = *symbols[index(entry.owner)];
+            auto field = std::make_unique<structures::variable_symbol>(common::symbol_id{entry.name}, types[index(entry.type)].get());
+            cls.fields.push_back(field.get());
+            cls.class_scope->add(std::move(field));
+        }
+        for (auto& cls : symbols) {
+            cls->index_members();
+        }
+    }
 
-inline void add_codegen_method(codegen::ast::class_declaration* cls,
-                               const std::string& name,
-                               codegen::ast::class_declaration* return_type,
-                               std::vector<std::pair<std::string, codegen::ast::class_declaration*>> params) {
-    auto method = std::make_unique<codegen::ast::method_declaration>();
-    method->name = name;
-    method->return_type = return_type;
-    method->class_owner = cls;
-
-    for (auto& [param_name, param_type] : params) {
-        auto param = std::make_unique<codegen::ast::parameter_declaration>();
-        param->name = param_name;
-        param->type = param_type;
-        method->parameters.push_back(std::move(param));
+private:
+    // depth-first, each class followed by the slots of the user classes derived from it, see class_type
+    uint32_t next_number = 0;
+
+    void number_types(size_t cls) {
+        types[cls]->preorder = next_number;
+        next_number += 1 + structures::class_type::builtin_subclass_slots;
+        for (size_t sub = 0; sub < classes.size(); ++sub) {
+            if (classes[sub].base != class_id::none && index(classes[sub].base) == cls) {
+                number_types(sub);
+            }
+        }
+        types[cls]->subtree_end = next_number;
     }
+};
 
-    cls->methods.push_back(std::move(method));
+inline const semantic_prelude& semantic_classes() {
+    static const semantic_prelude prelude;
+    return prelude;
 }
 
-inline void add_codegen_constructor(codegen::ast::class_declaration* cls, std::vector<std::pair<std::string, codegen::ast::class_declaration*>> params) {
-    auto ctor = std::make_unique<codegen::ast::constructor_declaration>();
-    ctor->class_owner = cls;
+inline bool is_builtin(const structures::class_symbol& cls) {
+    return std::ranges::any_of(semantic_classes().symbols, [&cls](const auto& symbol) { return symbol.get() == &cls; });
+}
 
-    for (auto& [param_name, param_type] : params) {
-        auto param = std::make_unique<codegen::ast::parameter_declaration>();
-        param->name = param_name;
-        param->type = param_type;
-        ctor->parameters.push_back(std::move(param));
+// the program scope and the type table refer to the prelude, a compilation only adds their names
+inline void add_builtin_classes(structures::symbol_table& sym_table, structures::type_table& type_table) {
+    const auto& prelude = semantic_classes();
+    for (size_t i = 0; i < classes.size(); ++i) {
+        sym_table.add_external(prelude.symbols[i].get());
+        type_table.addBuiltinClass(prelude.types[i].get());
     }
-
-    ctor->body = std::make_unique<codegen::ast::block>();
-
-    cls->constructors.push_back(std::move(ctor));
 }
 
-inline void add_builtin_classes_to_codegen(codegen::ast::program& program) {
-    auto create_builtin_class = [](const std::string& name, codegen::ast::class_declaration* base = nullptr) {
-        auto cls = std::make_unique<codegen::ast::class_declaration>();
-        cls->name = name;
-        cls->base_class = base;
-        return cls;
-    };
+// The codegen declarations of the prelude, in the order of `classes`, built once in their own arena. Like a program's
+// tree, the nodes are never destroyed one by one.
+struct codegen_prelude {
+    common::arena nodes;
+    std::array<codegen::ast::class_declaration*, classes.size()> declarations{};
+
+    codegen_prelude() {
+        common::arena::scope scope{nodes};
+        for (size_t i = 0; i < classes.size(); ++i) {
+            auto* cls = new codegen::ast::class_declaration();
+            cls->name = common::symbol_id{classes[i].name};
+            cls->base_class = classes[i].base == class_id::none ? nullptr : declarations[index(classes[i].base)];
+            declarations[i] = cls;
+        }
+
+        auto add_parameters = [&](const method_entry& entry, auto& parameters) {
+            for (size_t i = 0; i < entry.arity; ++i) {
+                auto param = std::make_unique<codegen::ast::parameter_declaration>();
+                param->name = common::symbol_id{entry.parameters[i].name};
+                param->type = declarations[index(entry.parameters[i].type)];
+                parameters.push_back(std::move(param));
+            }
+        };
+        for (const auto& entry : constructors) {
+            auto ctor = std::make_unique<codegen::ast::constructor_declaration>();
+            ctor->class_owner = declarations[index(entry.owner)];
+            add_parameters(entry, ctor->parameters);
+            ctor->body = std::make_unique<codegen::ast::block>();
+            ctor->class_owner->constructors.push_back(std::move(ctor));
+        }
+        for (const auto& entry : methods) {
+            auto method = std::make_unique<codegen::ast::method_declaration>();
+            method->name = common::symbol_id{entry.name};
+            method->return_type = declarations[index(entry.return_type)];
+            method->class_owner = declarations[index(entry.owner)];
+            add_parameters(entry, method->parameters);
+            method->class_owner->methods.push_back(std::move(method));
+        }
+        for (const auto& entry : fields) {
+            auto field = std::make_unique<codegen::ast::field_declaration>();
+            field->name = common::symbol_id{entry.name};
+            field->type = declarations[index(entry.type)];
+            field->class_owner = declarations[index(entry.owner)];
+            field->class_owner->fields.push_back(std::move(field));
+        }
+    }
+};
 
-    auto class_cls = create_builtin_class("Class");
-    auto* class_ptr = class_cls.get();
-    program.internal_classes.push_back(std::move(class_cls));
-
-    auto anyvalue_cls = create_builtin_class("AnyValue", class_ptr);
-    auto* anyvalue_ptr = anyvalue_cls.get();
-    program.internal_classes.push_back(std::move(anyvalue_cls));
-
-    auto anyref_cls = create_builtin_class("AnyRef", class_ptr);
-    auto* anyref_ptr = anyref_cls.get();
-    program.internal_classes.push_back(std::move(anyref_cls));
-
-    auto integer_cls = create_builtin_class("Integer", anyvalue_ptr);
-    auto* integer_ptr = integer_cls.get();
-    program.internal_classes.push_back(std::move(integer_cls));
-
-    auto real_cls = create_builtin_class("Real", anyvalue_ptr);
-    auto* real_ptr = real_cls.get();
-    program.internal_classes.push_back(std::move(real_cls));
-
-    auto boolean_cls = create_builtin_class("Boolean", anyvalue_ptr);
-    auto* boolean_ptr = boolean_cls.get();
-    program.internal_classes.push_back(std::move(boolean_cls));
-
-    auto unit_cls = create_builtin_class("Unit", anyvalue_ptr);
-    auto* unit_ptr = unit_cls.get();
-    program.internal_classes.push_back(std::move(unit_cls));
-
-    auto array_integer_cls = create_builtin_class("ArrayInteger", anyref_ptr);
-    auto *array_integer_ptr = array_integer_cls.get();
-    program.internal_classes.push_back(std::move(array_integer_cls));
-
-    auto io_cls = create_builtin_class("IO", anyvalue_ptr);
-    auto *io_ptr = io_cls.get();
-    program.internal_classes.push_back(std::move(io_cls));
-
-    // Add Inreger members
-    add_codegen_constructor(integer_ptr, {{"p", integer_ptr}});
-    add_codegen_constructor(integer_ptr, {{"p", real_ptr}});
-    add_codegen_field(integer_ptr, "Min", integer_ptr);
-    add_codegen_field(integer_ptr, "Max", integer_ptr);
-    add_codegen_method(integer_ptr, "toReal", real_ptr, {});
-    add_codegen_method(integer_ptr, "toBoolean", boolean_ptr, {});
-    add_codegen_method(integer_ptr, "UnaryMinus", integer_ptr, {});
-    add_codegen_method(integer_ptr, "Plus", integer_ptr, {{"p", integer_ptr}});
-    add_codegen_method(integer_ptr, "Plus", real_ptr, {{"p", real_ptr}});
-    add_codegen_method(integer_ptr, "Minus", integer_ptr, {{"p", integer_ptr}});
-    add_codegen_method(integer_ptr, "Minus", real_ptr, {{"p", real_ptr}});
-    add_codegen_method(integer_ptr, "Mult", integer_ptr, {{"p", integer_ptr}});
-    add_codegen_method(integer_ptr, "Mult", real_ptr, {{"p", real_ptr}});
-    add_codegen_method(integer_ptr, "Div", integer_ptr, {{"p", integer_ptr}});
-    add_codegen_method(integer_ptr, "Div", real_ptr, {{"p", real_ptr}});
-    add_codegen_method(integer_ptr, "Rem", integer_ptr, {{"p", integer_ptr}});
-    add_codegen_method(integer_ptr, "Less", boolean_ptr, {{"p", integer_ptr}});
-    add_codegen_method(integer_ptr, "Less", boolean_ptr, {{"p", real_ptr}});
-    add_codegen_method(integer_ptr, "LessEqual", boolean_ptr, {{"p", integer_ptr}});
-    add_codegen_method(integer_ptr, "LessEqual", boolean_ptr, {{"p", real_ptr}});
-    add_codegen_method(integer_ptr, "Greater", boolean_ptr, {{"p", integer_ptr}});
-    add_codegen_method(integer_ptr, "Greater", boolean_ptr, {{"p", real_ptr}});
-    add_codegen_method(integer_ptr, "GreaterEqual", boolean_ptr, {{"p", integer_ptr}});
-    add_codegen_method(integer_ptr, "GreaterEqual", boolean_ptr, {{"p", real_ptr}});
-    add_codegen_method(integer_ptr, "Equal", boolean_ptr, {{"p", integer_ptr}});
-    add_codegen_method(integer_ptr, "Equal", boolean_ptr, {{"p", real_ptr}});
-
-    // Add Real members
-    add_codegen_constructor(real_ptr, {{"p", real_ptr}});
-    add_codegen_constructor(real_ptr, {{"p", integer_ptr}});
-    add_codegen_field(real_ptr, "Min", real_ptr);
-    add_codegen_field(real_ptr, "Max", real_ptr);
-    add_codegen_field(real_ptr, "Epsilon", real_ptr);
-    add_codegen_method(real_ptr, "toInteger", integer_ptr, {});
-    add_codegen_method(real_ptr, "UnaryMinus", real_ptr, {});
-    add_codegen_method(real_ptr, "Plus", real_ptr, {{"p", real_ptr}});
-    add_codegen_method(real_ptr, "Plus", real_ptr, {{"p", integer_ptr}});
-    add_codegen_method(real_ptr, "Minus", real_ptr, {{"p", real_ptr}});
-    add_codegen_method(real_ptr, "Minus", real_ptr, {{"p", integer_ptr}});
-    add_codegen_method(real_ptr, "Mult", real_ptr, {{"p", real_ptr}});
-    add_codegen_method(real_ptr, "Mult", real_ptr, {{"p", integer_ptr}});
-    add_codegen_method(real_ptr, "Div", real_ptr, {{"p", real_ptr}});
-    add_codegen_method(real_ptr, "Div", real_ptr, {{"p", integer_ptr}});
-    add_codegen_method(real_ptr, "Rem", real_ptr, {{"p", integer_ptr}});
-    add_codegen_method(real_ptr, "Less", boolean_ptr, {{"p", real_ptr}});
-    add_codegen_method(real_ptr, "Less", boolean_ptr, {{"p", integer_ptr}});
-    add_codegen_method(real_ptr, "LessEqual", boolean_ptr, {{"p", real_ptr}});
-    add_codegen_method(real_ptr, "LessEqual", boolean_ptr, {{"p", integer_ptr}});
-    add_codegen_method(real_ptr, "Greater", boolean_ptr, {{"p", real_ptr}});
-    add_codegen_method(real_ptr, "Greater", boolean_ptr, {{"p", integer_ptr}});
-    add_codegen_method(real_ptr, "GreaterEqual", boolean_ptr, {{"p", real_ptr}});
-    add_codegen_method(real_ptr, "GreaterEqual", boolean_ptr, {{"p", integer_ptr}});
-    add_codegen_method(real_ptr, "Equal", boolean_ptr, {{"p", real_ptr}});
-    add_codegen_method(real_ptr, "Equal", boolean_ptr, {{"p", integer_ptr}});
-
-    // Add Boolean members
-    add_codegen_constructor(boolean_ptr, {{"p", boolean_ptr}});
-    add_codegen_method(boolean_ptr, "toInteger", integer_ptr, {});
-    add_codegen_method(boolean_ptr, "Or", boolean_ptr, {{"p", boolean_ptr}});
-    add_codegen_method(boolean_ptr, "And", boolean_ptr, {{"p", boolean_ptr}});
-    add_codegen_method(boolean_ptr, "Xor", boolean_ptr, {{"p", boolean_ptr}});
-    add_codegen_method(boolean_ptr, "Not", boolean_ptr, {});
-
-    // Add Unit constructor
-    add_codegen_constructor(unit_ptr, {});
-
-    // Add Array Integer members
-    add_codegen_constructor(array_integer_ptr, {{"size", integer_ptr}});
-    add_codegen_method(array_integer_ptr, "Len", integer_ptr, {});
-    add_codegen_method(array_integer_ptr, "Get", integer_ptr, {{"i", integer_ptr}});
-    add_codegen_method(array_integer_ptr, "Set", unit_ptr, {{"i", integer_ptr}, {"v", integer_ptr}});
-
-    // Add IO members
-    add_codegen_constructor(io_ptr, {});
-    add_codegen_method(io_ptr, "Print", unit_ptr, {{"p", integer_ptr}});
-    add_codegen_method(io_ptr, "Print", unit_ptr, {{"p", real_ptr}});
-    add_codegen_method(io_ptr, "Print", unit_ptr, {{"p", boolean_ptr}});
+inline std::span<codegen::ast::class_declaration* const> codegen_classes() {
+    static const codegen_prelude prelude;
+    return prelude.declarations;
 }
 
 } // namespace analysis::semantic::builtin
@@ -1,36 +1,35 @@
 #include "compiler/analysis/semantic/error.h"
 
+#include <format>
+
 namespace analysis::semantic {
 
 error_formatter::error_formatter(std::string_view file_name, std::string_view source)
     : file_name_(file_name), source_(source) {}
 
-std::string_view error_formatter::get_line(size_t line_num) const {
-    if (line_num == 0) {
-        return {};
-    }
-    size_t current_line = 1;
-    size_t pos = 0;
-    while (current_line < line_num && pos < source_.size()) {
-        if (source_[pos] == '\n') {
-            ++current_line;
+const std::vector<size_t>& error_formatter::line_starts() const {
+    if (line_starts_.empty()) {
+        line_starts_.push_back(0);
+        for (auto pos = source_.find('\n'); pos != std::string_view::npos; pos = source_.find('\n', pos + 1)) {
+            line_starts_.push_back(pos + 1);
         }
-        ++pos;
     }
-    if (current_line != line_num || pos > source_.size()) {
+    return line_starts_;
+}
+
+std::string_view error_formatter::get_line(size_t line_num) const {
+    const auto& starts = line_starts();
+    if (line_num == 0 || line_num > starts.size()) {
         return {};
     }
-    size_t end = pos;
-    while (end < source_.size() && source_[end] != '\n') {
-        ++end;
-    }
-    return source_.substr(pos, end - pos);
+    size_t start = starts[line_num - 1];
+    size_t end = line_num < starts.size() ? starts[line_num] - 1 : source_.size();
+    return source_.substr(start, end - start);
 }
 
-std::string error_formatter::format_with_location(common::span span, std::string_view description) const {
+void error_formatter::format_with_location(std::string& result, common::span span, std::string_view description) const {
     static constexpr std::string_view indent = "    ";
 
-    std::string result;
     result += std::format("{}:{}:{}: error: {}\n",
                           file_name_.empty() ? std::string_view{"<source_file>"} : file_name_,
                           span.line_num,
@@ -39,7 +38,7 @@ std::string error_formatter::format_with_location(common::span span, std::string
 
     auto line = get_line(span.line_num);
     if (line.empty() && span.line_num == 0) {
-        return result;
+        return;
     }
 
     result += indent;
@@ -57,7 +56,13 @@ std::string error_formatter::format_with_location(common::span span, std::string
         result += '^';
     }
     result += '\n';
+}
 
+std::string error_formatter::format(const std::vector<common::diagnostic>& diagnostics) const {
+    std::string result;
+    for (const auto& diagnostic : diagnostics) {
+        format_with_location(result, diagnostic.span, diagnostic.message);
+    }
     return result;
 }
 
@@ -1,29 +1,30 @@
 #pragma once
 
-#include <format>
+#include <cstddef>
 #include <string>
 #include <string_view>
-#include <utility>
+#include <vector>
 
 #include "compiler/compilation-structures/common.h"
 
 namespace analysis::semantic {
 
+// Formats the diagnostics of the semantic phases, each with its location and source line.
 class error_formatter {
 public:
     error_formatter(std::string_view file_name, std::string_view source);
 
-    template<typename... Args>
-    std::string format_error(common::span span, std::format_string<Args...> fmt, Args&&... args) const {
-        return format_with_location(span, std::format(fmt, std::forward<Args>(args)...));
-    }
+    std::string format(const std::vector<common::diagnostic>& diagnostics) const;
 
 private:
     std::string_view file_name_;
     std::string_view source_;
+    // offset where every line starts, built when the first diagnostic is formatted
+    mutable std::vector<size_t> line_starts_;
 
-    std::string format_with_location(common::span span, std::string_view description) const;
+    void format_with_location(std::string& result, common::span span, std::string_view description) const;
     std::string_view get_line(size_t line_num) const;
+    const std::vector<size_t>& line_starts() const;
 };
 
 } // namespace analysis::semantic
@@ -1,5 +1,7 @@
 #include "compiler/analysis/semantic/phases/class-body-collector.h"
 
+#include <format>
+
 #include "compiler/compilation-structures/ast/parsing/ast.h"
 
 namespace analysis::semantic::phases::details {
@@ -13,7 +15,7 @@ void class_body_collector::visit(ast::program& node) {
 void class_body_collector::visit(ast::class_declaration& node) {
     current_class = program_symbol_table.typed_lookup<structures::class_symbol>(node.name);
     if (current_class == nullptr) {
-        error_message += errors.format_error(node.span, "Internal error: class {} not found in symbol table", node.name);
+        diagnostics.push_back({node.span, std::format("Internal error: class {} not found in symbol table", node.name)});
         return;
     }
 
@@ -21,20 +23,16 @@ void class_body_collector::visit(ast::class_declaration& node) {
     constructor_names.clear();
     method_names.clear();
 
-    try {
-        for (auto& field : node.fields) {
-            field->accept(*this);
-        }
+    for (auto& field : node.fields) {
+        field->accept(*this);
+    }
 
-        for (auto& method : node.methods) {
-            method->accept(*this);
-        }
+    for (auto& method : node.methods) {
+        method->accept(*this);
+    }
 
-        for (auto& ctor : node.constructors) {
-            ctor->accept(*this);
-        }
-    } catch (std::exception & exception) {
-        error_message += exception.what();
+    for (auto& ctor : node.constructors) {
+        ctor->accept(*this);
     }
 
     current_class = nullptr;
@@ -42,7 +40,7 @@ void class_body_collector::visit(ast::class_declaration& node) {
 
 void class_body_collector::visit(ast::variable_declaration& node) {
     if (field_names.contains(node.name)) {
-        error_message += errors.format_error(node.span, "Duplicate field '{}' in class '{}'", node.name, current_class->name);
+        diagnostics.push_back({node.span, std::format("Duplicate field '{}' in class '{}'", node.name, current_class->name)});
         return;
     }
     field_names.insert(node.name);
@@ -52,28 +50,36 @@ void class_body_collector::visit(ast::variable_declaration& node) {
     current_class->class_scope->add(std::move(field));
 }
 
+const structures::type* class_body_collector::resolve_type(common::symbol_id name, common::span span) {
+    if (const auto* type = program_type_table.getClass(name)) {
+        return type;
+    }
+    diagnostics.push_back({span, std::format("Unknown type '{}'", name)});
+    return program_type_table.getError();
+}
+
 void class_body_collector::visit(ast::method_declaration& node) {
     std::optional<const structures::type*> return_type =
-        node.return_type.transform([this](const std::string& type_name) { return program_type_table.resolveType(type_name); });
+        node.return_type.transform([&](common::symbol_id type_name) { return resolve_type(type_name, node.span); });
     std::vector<const structures::type *> param_types;
     for (auto& param : node.parameters) {
-        param_types.push_back(program_type_table.resolveType(param->type_name));
+        param_types.push_back(resolve_type(param->type_name, param->span));
     }
 
-    std::string mangled = structures::mangle_method_name(node.name, param_types);
+    auto mangled = structures::mangle_method_name(node.name, param_types);
 
     if (method_names.contains(mangled)) {
-        error_message += errors.format_error(node.span, "Duplicate method '{}' with same parameters in class '{}'", node.name, current_class->name);
+        diagnostics.push_back({node.span, std::format("Duplicate method '{}' with same parameters in class '{}'", node.name, current_class->name)});
         return;
     }
     method_names.insert(mangled);
 
-    auto method = std::make_unique<structures::method_symbol>(mangled, node.name, current_class->class_scope.get(), return_type, std::move(param_types));
+    auto method = std::make_unique<structures::method_symbol>(mangled, node.name, current_class->class_scope.get(), return_type, param_types);
 
-    for (auto& param : node.parameters) {
-        auto param_sym = std::make_unique<structures::variable_symbol>(param->name, program_type_table.resolveType(param->type_name));
-        method->method_scope->add(std::move(param_sym));
+    for (size_t i = 0; i < node.parameters.size(); ++i) {
+        method->method_scope->add(std::make_unique<structures::variable_symbol>(node.parameters[i]->name, param_types[i]));
     }
+    node.symbol = method.get();
     current_class->methods.push_back(method.get());
     current_class->class_scope->add(std::move(method));
 }
@@ -81,22 +87,22 @@ void class_body_collector::visit(ast::method_declaration& node) {
 void class_body_collector::visit(ast::constructor_declaration& node) {
     std::vector<const structures::type *> param_types;
     for (auto& param : node.parameters) {
-        param_types.push_back(program_type_table.resolveType(param->type_name));
+        param_types.push_back(resolve_type(param->type_name, param->span));
     }
 
-    std::string mangled = structures::mangle_method_name(current_class->name, param_types);
+    auto mangled = structures::mangle_method_name(current_class->name, param_types);
     if (constructor_names.contains(mangled)) {
-        error_message += errors.format_error(node.span, "Duplicate constructor with same signature '{}' in class '{}'", current_class->name, current_class->name);
+        diagnostics.push_back({node.span, std::format("Duplicate constructor with same signature '{}' in class '{}'", current_class->name, current_class->name)});
         return;
     }
     constructor_names.insert(mangled);
 
-    auto ctor = std::make_unique<structures::method_symbol>(mangled, current_class->name, current_class->class_scope.get(), program_type_table.resolveType(current_class->name), std::move(param_types));
-    for (auto& param : node.parameters) {
-        auto param_sym = std::make_unique<structures::variable_symbol>(param->name, program_type_table.resolveType(param->type_name));
-        ctor->method_scope->add(std::move(param_sym));
+    auto ctor = std::make_unique<structures::method_symbol>(mangled, current_class->name, current_class->class_scope.get(), program_type_table.resolveType(current_class->name), param_types);
+    for (size_t i = 0; i < node.parameters.size(); ++i) {
+        ctor->method_scope->add(std::make_unique<structures::variable_symbol>(node.parameters[i]->name, param_types[i]));
     }
 
+    node.symbol = ctor.get();
     current_class->constructors.push_back(ctor.get());
     current_class->class_scope->add(std::move(ctor));
 }
@@ -1,10 +1,9 @@
 #pragma once
 
-#include <stdexcept>
-#include <string>
 #include <unordered_set>
+#include <vector>
 
-#include "compiler/analysis/semantic/error.h"
+#include "compiler/compilation-structures/common.h"
 #include "compiler/compilation-structures/ast/parsing/ast-visitor.h"
 #include "compiler/compilation-structures/ast/parsing/ast.h"
 #include "compiler/compilation-structures/symbol-table.h"
@@ -15,10 +14,10 @@ namespace details {
 
 class class_body_collector : public ast::visitor {
 public:
-    class_body_collector(structures::symbol_table& symbol_table, structures::type_table& type_table, const error_formatter& errors)
+    class_body_collector(structures::symbol_table& symbol_table, structures::type_table& type_table, std::vector<common::diagnostic>& diagnostics)
         : program_symbol_table(symbol_table),
           program_type_table(type_table),
-          errors(errors) {}
+          diagnostics(diagnostics) {}
 
     void visit(ast::program& node) override;
     void visit(ast::block& node) override;
@@ -38,22 +37,18 @@ public:
     void visit(ast::call_expression& node) override;
     void visit(ast::grouping_expression& node) override;
 
-    void get_result() {
-        if (!error_message.empty()) {
-            throw std::runtime_error{error_message};
-        }
-    }
-
 private:
     structures::symbol_table& program_symbol_table;
     structures::type_table& program_type_table;
-    const error_formatter& errors;
+    std::vector<common::diagnostic>& diagnostics;
     structures::class_symbol* current_class = nullptr;
-    std::string error_message{};
 
-    std::unordered_set<std::string> field_names;
-    std::unordered_set<std::string> method_names;
-    std::unordered_set<std::string> constructor_names;
+    std::unordered_set<common::symbol_id> field_names;
+    std::unordered_set<common::symbol_id> method_names;
+    std::unordered_set<common::symbol_id> constructor_names;
+
+    // a type named in a signature; an unknown name is reported and typed as an error
+    const structures::type* resolve_type(common::symbol_id name, common::span span);
 };
 
 } // namespace details
@@ -61,10 +56,15 @@ private:
 inline void process_classes_content(const std::unique_ptr<ast::program>& program,
                                                                 structures::symbol_table& program_symbol_table,
                                                                 structures::type_table& program_type_table,
-                                                                const error_formatter& errors) {
-    details::class_body_collector body_collector(program_symbol_table, program_type_table, errors);
+                                                                std::vector<common::diagnostic>& diagnostics) {
+    details::class_body_collector body_collector(program_symbol_table, program_type_table, diagnostics);
     program->accept(body_collector);
-    body_collector.get_result();
+    // every later phase resolves calls through the overload tables
+    for (auto& [name, symbol] : program_symbol_table) {
+        if (symbol->kind == structures::symbol_kind::class_symbol) {
+            static_cast<structures::class_symbol*>(symbol)->index_members();
+        }
+    }
 }
 
 } // namespace analysis::semantic::phases
@@ -1,5 +1,7 @@
 #include "compiler/analysis/semantic/phases/class-collector.h"
 
+#include <format>
+
 #include "compiler/compilation-structures/ast/parsing/ast.h"
 #include "compiler/compilation-structures/symbol-table.h"
 
@@ -13,25 +15,29 @@ void class_collector::visit(ast::program& node) {
 
 void class_collector::visit(ast::class_declaration& node) {
     if (program_symbol_table->lookup(node.name) != nullptr) {
-        error_message += errors.format_error(node.span, "Class redefinition: class '{}' is already defined", node.name);
+        diagnostics.push_back({node.span, std::format("Class redefinition: class '{}' is already defined", node.name)});
         return;
     }
     structures::class_symbol* base_class = nullptr;
     if (node.base_class.has_value()) {
         base_class = program_symbol_table->typed_lookup<structures::class_symbol>(*node.base_class);
         if (base_class == nullptr) {
-            error_message += errors.format_error(node.span, "Class '{}' inherits from undefined class '{}'", node.name, *node.base_class);
+            diagnostics.push_back({node.span, std::format("Class '{}' inherits from undefined class '{}'", node.name, *node.base_class)});
             return;
-        } else if (base_class->name == "Class") {
-            error_message += errors.format_error(node.span, "Class '{}' inherits from  class 'Class' which is prohibited. Look for 'AnyValue' or 'AnyRef'", node.name);
+        } else if (base_class->name == common::well_known::class_) {
+            diagnostics.push_back({node.span, std::format("Class '{}' inherits from  class 'Class' which is prohibited. Look for 'AnyValue' or 'AnyRef'", node.name)});
             return;
         }
     } else {
         // by default class user-defined classes extends AnyRef
-        base_class = program_symbol_table->typed_lookup<structures::class_symbol>("AnyRef");
-        node.base_class = "AnyRef";
+        base_class = program_symbol_table->typed_lookup<structures::class_symbol>(common::well_known::any_ref);
+        node.base_class = common::well_known::any_ref;
     }
-    auto sym{std::make_unique<structures::class_symbol>(node.name, base_class->class_scope.get(), base_class)};
+    // a built-in base's scope is shared by every compilation and doesn't lead on to this program's scope, so it is
+    // searched before the program scope instead of being the parent
+    auto sym = builtin::is_builtin(*base_class)
+                   ? std::make_unique<structures::class_symbol>(node.name, program_symbol_table.get(), base_class, base_class->class_scope.get())
+                   : std::make_unique<structures::class_symbol>(node.name, base_class->class_scope.get(), base_class);
     program_symbol_table->add(std::move(sym));
     program_type_table->addClass(node.name, &node);
 }
@@ -1,12 +1,11 @@
 #pragma once
 
-#include <stdexcept>
-#include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "compiler/analysis/semantic/builtin-classes.h"
-#include "compiler/analysis/semantic/error.h"
+#include "compiler/compilation-structures/common.h"
 #include "compiler/compilation-structures/ast/parsing/ast-visitor.h"
 #include "compiler/compilation-structures/ast/parsing/ast.h"
 #include "compiler/compilation-structures/symbol-table.h"
@@ -17,7 +16,7 @@ namespace details {
 
 class class_collector : public ast::visitor {
 public:
-    explicit class_collector(const error_formatter& errors) : errors(errors) {}
+    explicit class_collector(std::vector<common::diagnostic>& diagnostics) : diagnostics(diagnostics) {}
 
     void visit(ast::program& node) override;
     void visit(ast::block& node) override;
@@ -38,9 +37,6 @@ public:
     void visit(ast::grouping_expression& node) override;
 
     std::pair<std::unique_ptr<structures::symbol_table>, std::unique_ptr<structures::type_table>> get_result() {
-        if (!error_message.empty()) {
-            throw std::runtime_error{error_message};
-        }
         return std::pair<std::unique_ptr<structures::symbol_table>, std::unique_ptr<structures::type_table>>{std::move(program_symbol_table),
                                                                                                              std::move(program_type_table)};
     }
@@ -50,23 +46,25 @@ public:
     structures::type_table& type_table() { return *program_type_table; }
 
 private:
-    std::string error_message{};
     std::unique_ptr<structures::symbol_table> program_symbol_table{std::make_unique<structures::symbol_table>(nullptr)};
     std::unique_ptr<structures::type_table> program_type_table{std::make_unique<structures::type_table>()};
-    const error_formatter& errors;
+    std::vector<common::diagnostic>& diagnostics;
 };
 
 } // namespace details
 
 inline std::pair<std::unique_ptr<structures::symbol_table>, std::unique_ptr<structures::type_table>>
-collect_program_classes(const std::unique_ptr<ast::program>& program, const error_formatter& errors) {
-    details::class_collector class_collector{errors};
+collect_program_classes(const std::unique_ptr<ast::program>& program, std::vector<common::diagnostic>& diagnostics) {
+    details::class_collector class_collector{diagnostics};
 
     // Add built-in classes before processing user classes
     builtin::add_builtin_classes(class_collector.symbol_table(), class_collector.type_table());
 
     program->accept(class_collector);
 
-    return std::move(class_collector.get_result());
+    auto tables = class_collector.get_result();
+    // subtype tests of the later phases compare the numbers of the classes
+    tables.second->numberHierarchy(*tables.first);
+    return tables;
 }
 } // namespace analysis::semantic::phases
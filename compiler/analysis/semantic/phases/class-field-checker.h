@@ -1,9 +1,8 @@
 #pragma once
 
-#include <stdexcept>
-#include <string>
+#include <vector>
 
-#include "compiler/analysis/semantic/error.h"
+#include "compiler/compilation-structures/common.h"
 #include "compiler/compilation-structures/ast/parsing/ast-visitor.h"
 #include "compiler/compilation-structures/ast/parsing/ast.h"
 #include "compiler/compilation-structures/symbol-table.h"
@@ -14,8 +13,8 @@ namespace details {
 
 class class_field_checker : public ast::visitor {
 public:
-    class_field_checker(structures::symbol_table& symbol_table, structures::type_table& type_table, const error_formatter& errors)
-        : program_symbol_table(symbol_table), program_type_table(type_table), errors(errors) {}
+    class_field_checker(structures::symbol_table& symbol_table, structures::type_table& type_table, std::vector<common::diagnostic>& diagnostics)
+        : program_symbol_table(symbol_table), program_type_table(type_table), diagnostics(diagnostics) {}
 
     void visit(ast::program& node) override;
     void visit(ast::block& node) override;
@@ -35,26 +34,21 @@ public:
     void visit(ast::call_expression& node) override;
     void visit(ast::grouping_expression& node) override;
 
-    void get_result() {
-        if (!error_message.empty()) {
-            throw std::runtime_error{error_message};
-        }
-    }
-
 private:
-    std::string error_message{};
     structures::symbol_table& program_symbol_table;
     structures::type_table& program_type_table;
-    const error_formatter& errors;
+    std::vector<common::diagnostic>& diagnostics;
     structures::class_symbol* current_class_symbol = nullptr;
 };
 
 } // namespace details
 
-inline void check_field_content(const std::unique_ptr<ast::program>& program, structures::symbol_table& symbol_table, structures::type_table& type_table, const error_formatter& errors) {
-    details::class_field_checker class_content_checker(symbol_table, type_table, errors);
+inline void check_field_content(const std::unique_ptr<ast::program>& program,
+                                structures::symbol_table& symbol_table,
+                                structures::type_table& type_table,
+                                std::vector<common::diagnostic>& diagnostics) {
+    details::class_field_checker class_content_checker(symbol_table, type_table, diagnostics);
     program->accept(class_content_checker);
-    class_content_checker.get_result();
 }
 
 } // namespace analysis::semantic::phases
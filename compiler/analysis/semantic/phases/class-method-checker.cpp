@@ -2,6 +2,11 @@
 
 
 #include <cassert>
+#include <format>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <vector>
 
 #include "compiler/common/variant-helper.h"
 
@@ -16,223 +21,339 @@ void class_method_checker::visit(ast::program& node) {
 void class_method_checker::visit(ast::class_declaration& node) {
     auto* cls = program_symbol_table.typed_lookup<structures::class_symbol>(node.name);
     assert(cls != nullptr);
-    current_class_symbol = cls;
     for (const auto& method : node.methods) {
-        try {
-            method->accept(*this);
-        } catch (const std::exception& e) {
-            error_message += errors.format_error(method->span, "Semantic error checking method '{}': {}", method->name, e.what());
-        }
+        check_method(*cls, *method);
     }
     for (const auto& constructor : node.constructors) {
-        try {
-            constructor->accept(*this);
-        } catch (const std::exception& e) {
-            error_message += errors.format_error(constructor->span, "Semantic error checking constructor '{}': {}", cls->name, e.what());
-        }
+        check_constructor(*cls, *constructor);
     }
 }
 
+void class_method_checker::check_method(structures::class_symbol& cls, ast::method_declaration& method) {
+    current_class_symbol = &cls;
+    method.accept(*this);
+}
+
+void class_method_checker::check_constructor(structures::class_symbol& cls, ast::constructor_declaration& constructor) {
+    current_class_symbol = &cls;
+    constructor.accept(*this);
+}
+
+const structures::type* class_method_checker::infer(const ast::expression* expression) {
+    return structures::type::inferExpressionType(expression, {&program_type_table, current_class_symbol, current_symbol_table, &diagnostics});
+}
+
 void class_method_checker::visit(ast::method_declaration& node) {
     if (!node.body.has_value()) {
         return;
     }
     if (!node.return_type.has_value()) {
-        error_message += errors.format_error(node.span, "Methods without return type are forbidden");
+        diagnostics.push_back({node.span, std::format("Methods without return type are forbidden")});
         return;
     }
 
-    std::vector<const structures::type *> param_types;
-    for (auto& param : node.parameters) {
-        param_types.push_back(program_type_table.resolveType(param->type_name));
-    }
-
-    std::string mangled = structures::mangle_method_name(node.name, param_types);
-    auto *method_symbol = current_class_symbol->class_scope->typed_lookup<structures::method_symbol>(mangled);
+    auto *method_symbol = node.symbol;
     assert(method_symbol != nullptr);
+    auto* method = codegen.method_of(*method_symbol);
+    body_scope.owner = method->class_owner;
 
     current_symbol_table = method_symbol->method_scope.get();
-    for (const auto& param : node.parameters) {
-        const auto& param_name = param->name;
-        const auto* param_type = program_type_table.resolveType(param->type_name);
-        current_symbol_table->add(std::make_unique<structures::variable_symbol>(param_name, param_type));
-    }
+    add_parameters(node.parameters, method->parameters);
     const auto* return_type = program_type_table.resolveType(*node.return_type);
     const auto& method_body = *node.body;
 
-    auto err = std::visit(
+    std::visit(
         overloaded{
-            [&](const std::unique_ptr<ast::block>& body) -> std::optional<std::string> {
+            [&](const std::unique_ptr<ast::block>& body) {
                 method_return_type = return_type;
                 body->accept(*this);
+                method->body = std::move(last_block);
                 if (!std::exchange(definitely_returns, false)) {
-                    return errors.format_error(node.span, "Method '{}' does not return on all code paths", node.name);
+                    diagnostics.push_back({node.span, std::format("Method '{}' does not return on all code paths", node.name)});
                 }
-                return std::nullopt;
             },
-            [&](const std::unique_ptr<ast::expression>& body) -> std::optional<std::string> {
-                const auto* type = structures::type::inferExpressionType(body.get(), {&program_type_table, current_class_symbol, current_symbol_table});
+            [&](const std::unique_ptr<ast::expression>& body) {
+                const auto* type = infer(body.get());
+                method->body = lower(body.get());
                 if (!structures::type::isSubtype(type, return_type)) {
-                    return errors.format_error(body->span, "Expected return type '{}' but inferred type '{}' from expression", return_type->toString(), type->toString());
+                    diagnostics.push_back({body->span,
+                                           std::format("Expected return type '{}' but inferred type '{}' from expression",
+                                                       return_type->toString(),
+                                                       type->toString())});
                 }
-                return std::nullopt;
             }},
         method_body);
-    if (err.has_value()) {
-        error_message += *err;
-    }
 }
 
 void class_method_checker::visit(ast::constructor_declaration& node) {
-    std::vector<const structures::type *> param_types;
-    for (auto& param : node.parameters) {
-        param_types.push_back(program_type_table.resolveType(param->type_name));
-    }
-    std::string mangled = structures::mangle_method_name(current_class_symbol->name, param_types);
-    auto *method_symbol = current_class_symbol->class_scope->typed_lookup<structures::method_symbol>(mangled);
+    auto *method_symbol = node.symbol;
     assert(method_symbol != nullptr);
+    auto* ctor = codegen.constructor_of(*method_symbol);
+    body_scope.owner = ctor->class_owner;
 
     current_symbol_table = method_symbol->method_scope.get();
-    for (const auto& param : node.parameters) {
-        const auto& param_name = param->name;
-        const auto* param_type = program_type_table.resolveType(param->type_name);
-        current_symbol_table->add(std::make_unique<structures::variable_symbol>(param_name, param_type));
-    }
+    add_parameters(node.parameters, ctor->parameters);
 
     // check super class call
     auto * base_class = current_class_symbol->base_class;
     if (structures::type_table::isPrimitiveTypeName(base_class->name)) {
         if (node.super_parameters.has_value()) {
-            error_message += errors.format_error(node.span, "There is no super constructor to call");
+            diagnostics.push_back({node.span, std::format("There is no super constructor to call")});
             return;
         }
     } else {
         if (!node.super_parameters.has_value()) {
-            error_message += errors.format_error(node.span, "Class should explicitly call super constructor");
+            diagnostics.push_back({node.span, std::format("Class should explicitly call super constructor")});
             return;
         }
         auto &super_constructor_params = *node.super_parameters;
         std::vector<const structures::type *> super_constructor_param_types;
         super_constructor_param_types.reserve(super_constructor_params.size());
+        bool arguments_failed = false;
         for (auto &super_constructor_param : super_constructor_params) {
-            super_constructor_param_types.push_back(structures::type::inferExpressionType(super_constructor_param.get(), {&program_type_table, current_class_symbol, current_symbol_table}));
+            super_constructor_param_types.push_back(infer(super_constructor_param.get()));
+            arguments_failed |= super_constructor_param_types.back()->isError();
+        }
+        if (arguments_failed) {
+            return;
         }
 
-        bool matched = false;
-        for (auto &super_constructors : base_class->constructors) {
-            if (structures::type::isSubTypeList(super_constructor_param_types, super_constructors->parameter_types)) {
-                matched = true;
+        structures::method_symbol* matched = nullptr;
+        for (auto *super_constructor : base_class->constructor_overloads(super_constructor_param_types.size())) {
+            if (structures::type::isSubTypeList(super_constructor_param_types, super_constructor->parameter_types)) {
+                matched = super_constructor;
+                break;
             }
         }
 
-        if (!matched) {
-            std::string mangled_name = structures::mangle_method_name(base_class->name, super_constructor_param_types);
-            error_message += errors.format_error(node.span, "There is no such constructor in super class {}", mangled_name);
+        if (matched == nullptr) {
+            auto mangled_name = structures::mangle_method_name(base_class->name, super_constructor_param_types);
+            diagnostics.push_back({node.span, std::format("There is no such constructor in super class {}", mangled_name)});
             return;
         }
+
+        ctor->super_constructor = std::make_unique<codegen::ast::constructor_call_expression>();
+        for (auto &super_constructor_param : super_constructor_params) {
+            ctor->super_constructor->arguments.push_back(lower(super_constructor_param.get()));
+        }
+        ctor->super_constructor->constructor = codegen.constructor_of(*matched);
+        ctor->super_constructor->type = ctor->class_owner->base_class;
     }
 
     method_return_type = nullptr;
     node.body->accept(*this);
+    ctor->body = std::move(last_block);
     std::exchange(definitely_returns, false);
 }
 
+void class_method_checker::add_parameters(const common::arena_vector<std::unique_ptr<ast::parameter_declaration>>& parameters,
+                                          const common::arena_vector<std::unique_ptr<codegen::ast::parameter_declaration>>& declarations) {
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        const auto* param_type = program_type_table.resolveType(parameters[i]->type_name);
+        auto param_symbol = std::make_unique<structures::variable_symbol>(parameters[i]->name, param_type);
+        body_scope.locals[param_symbol.get()] = declarations[i].get();
+        current_symbol_table->add(std::move(param_symbol));
+    }
+}
+
 void class_method_checker::visit(ast::block& node) {
+    auto block = std::make_unique<codegen::ast::block>();
     for (auto& entity : node.items) {
         entity->accept(*this);
+        if (last_statement) {
+            block->items.push_back(std::move(last_statement));
+        } else if (last_expression) {
+            block->items.push_back(std::move(last_expression));
+        }
     }
+    last_block = std::move(block);
 }
 
 void class_method_checker::visit(ast::variable_declaration& node) {
     const auto* type_res =
-        structures::type::inferExpressionType(node.initializer.get(), {&program_type_table, current_class_symbol, current_symbol_table});
+        infer(node.initializer.get());
     if (current_symbol_table->typed_lookup<structures::variable_symbol>(node.name) != nullptr) {
-        throw std::runtime_error{std::format("variable {} is already defined", node.name)};
+        diagnostics.push_back({node.span, std::format("Variable '{}' is already defined", node.name)});
+        return;
     }
-    current_symbol_table->add(std::make_unique<structures::variable_symbol>(node.name, type_res));
+    auto var = std::make_unique<codegen::ast::variable_declaration>();
+    var->name = node.name;
+    var->initializer = lower(node.initializer.get());
+    var->type = codegen.resolveType(type_res);
+
+    auto symbol = std::make_unique<structures::variable_symbol>(node.name, type_res);
+    body_scope.locals[symbol.get()] = var.get();
+    current_symbol_table->add(std::move(symbol));
+    last_statement = std::move(var);
 }
 
 void class_method_checker::visit(ast::if_statement& node) {
     const auto* condition_type =
-        structures::type::inferExpressionType(node.condition.get(), {&program_type_table, current_class_symbol, current_symbol_table});
-    if (!structures::type::typesEqual(condition_type, program_type_table.resolveType("Boolean"))) {
-        error_message += errors.format_error(node.condition->span, "Expected 'Boolean' type for condition expression but inferred '{}'", condition_type->toString());
+        infer(node.condition.get());
+    if (!condition_type->isError() && !structures::type::typesEqual(condition_type, program_type_table.resolveType(common::well_known::boolean))) {
+        diagnostics.push_back({node.condition->span, std::format("Expected 'Boolean' type for condition expression but inferred '{}'", condition_type->toString())});
         return;
     }
+    auto if_stmt = std::make_unique<codegen::ast::if_statement>();
+    if_stmt->condition = lower(node.condition.get());
+
     node.true_branch->accept(*this);
+    if_stmt->true_branch = std::move(last_block);
     bool then_returns = std::exchange(definitely_returns, false);
 
     bool else_returns = false;
     if (node.false_branch != nullptr) {
         node.false_branch->accept(*this);
+        if_stmt->false_branch = std::move(last_block);
         else_returns = std::exchange(definitely_returns, false);
     }
 
     definitely_returns = then_returns && else_returns;
+    last_statement = std::move(if_stmt);
 }
 
 void class_method_checker::visit(ast::return_statement& node) {
     definitely_returns = true;
     if (method_return_type == nullptr) {
         if (node.value != nullptr) {
-            error_message += errors.format_error(node.span, "Constructors cannot return a value");
+            diagnostics.push_back({node.span, std::format("Constructors cannot return a value")});
         }
         // this is return in constructor definition, so just return
+        last_statement = std::make_unique<codegen::ast::return_statement>();
         return;
     }
 
     if (node.value == nullptr) {
-        error_message += errors.format_error(node.span, "Method must return a value of type '{}'", method_return_type->toString());
+        diagnostics.push_back({node.span, std::format("Method must return a value of type '{}'", method_return_type->toString())});
         return;
     }
 
-    const auto* return_type = structures::type::inferExpressionType(node.value.get(), {&program_type_table, current_class_symbol, current_symbol_table});
+    const auto* return_type = infer(node.value.get());
     if (!structures::type::isSubtype(return_type, method_return_type)) {
-        error_message += errors.format_error(node.value->span, "Expected return type '{}' but inferred type '{}' from expression", method_return_type->toString(), return_type->toString());
+        diagnostics.push_back({node.value->span, std::format("Expected return type '{}' but inferred type '{}' from expression", method_return_type->toString(), return_type->toString())});
     }
+    auto ret_stmt = std::make_unique<codegen::ast::return_statement>();
+    ret_stmt->value = lower(node.value.get());
+    ret_stmt->expression_type = codegen.resolveType(return_type);
+    last_statement = std::move(ret_stmt);
 }
 
 void class_method_checker::visit(ast::while_statement& node) {
     const auto* condition_type =
-        structures::type::inferExpressionType(node.condition.get(), {&program_type_table, current_class_symbol, current_symbol_table});
-    if (!structures::type::typesEqual(condition_type, program_type_table.resolveType("Boolean"))) {
-        error_message += errors.format_error(node.condition->span, "Expected 'Boolean' type for condition expression but inferred '{}'", condition_type->toString());
+        infer(node.condition.get());
+    if (!condition_type->isError() && !structures::type::typesEqual(condition_type, program_type_table.resolveType(common::well_known::boolean))) {
+        diagnostics.push_back({node.condition->span, std::format("Expected 'Boolean' type for condition expression but inferred '{}'", condition_type->toString())});
         return;
     }
+    auto while_stmt = std::make_unique<codegen::ast::while_statement>();
+    while_stmt->condition = lower(node.condition.get());
     node.body->accept(*this);
+    while_stmt->body = std::move(last_block);
+    last_statement = std::move(while_stmt);
 }
 
 void class_method_checker::visit(ast::assignment_statement& node) {
     const auto* target_symbol = current_symbol_table->typed_lookup<structures::variable_symbol>(node.target);
     if (target_symbol == nullptr) {
-        error_message += errors.format_error(node.span, "Unknown field or variable '{}'", node.target);
+        diagnostics.push_back({node.span, std::format("Unknown field or variable '{}'", node.target)});
         return;
     }
-    const auto* expr_type = structures::type::inferExpressionType(node.value.get(), {&program_type_table, current_class_symbol, current_symbol_table});
+    const auto* expr_type = infer(node.value.get());
     if (!structures::type::isSubtype(expr_type, target_symbol->type)) {
-        error_message += errors.format_error(node.span,
-                                              "Expected type '{}' for assignment to variable '{}' but inferred '{}'",
-                                              target_symbol->type->toString(),
-                                              target_symbol->name,
-                                              expr_type->toString());
+        diagnostics.push_back({node.span,
+                               std::format("Expected type '{}' for assignment to variable '{}' but inferred '{}'",
+                                           target_symbol->type->toString(),
+                                           target_symbol->name,
+                                           expr_type->toString())});
         return;
     }
+
+    auto value = lower(node.value.get());
+    auto target = codegen.target_of(*target_symbol, body_scope);
+    if (auto* field = std::get_if<codegen::ast::field_declaration*>(&target)) {
+        auto member = std::make_unique<codegen::ast::member_expression>();
+        member->object = std::make_unique<codegen::ast::this_expression>(body_scope.owner);
+        member->member = *field;
+        // the field's own type may not be collected yet when it belongs to a class declared further down
+        member->type = codegen.resolveType(target_symbol->type);
+
+        auto field_assign = std::make_unique<codegen::ast::field_assignment>();
+        field_assign->target = std::move(member);
+        field_assign->value = std::move(value);
+        field_assign->expression_type = codegen.resolveType(expr_type);
+        last_statement = std::move(field_assign);
+    } else {
+        auto var_assign = std::make_unique<codegen::ast::variable_assignment>();
+        var_assign->target = target;
+        var_assign->value = std::move(value);
+        var_assign->expression_type = codegen.resolveType(expr_type);
+        last_statement = std::move(var_assign);
+    }
+}
+
+void class_method_checker::check_expression_statement(ast::expression& node) {
+    infer(&node);
+    last_expression = lower(&node);
 }
 
 void class_method_checker::visit(ast::call_expression& node) {
-    try {
-        const auto* expressionType = structures::type::inferExpressionType(&node, {&program_type_table, current_class_symbol, current_symbol_table});
-        assert(expressionType != nullptr);
-    } catch (const std::exception & e) {
-        error_message += errors.format_error(node.span, "Cannot infer type due error : {}", e.what());
-    }
+    check_expression_statement(node);
+}
+void class_method_checker::visit(ast::literal_expression& node) {
+    check_expression_statement(node);
+}
+void class_method_checker::visit(ast::this_expression& node) {
+    check_expression_statement(node);
+}
+void class_method_checker::visit(ast::identifier_expression& node) {
+    check_expression_statement(node);
+}
+void class_method_checker::visit(ast::member_expression& node) {
+    check_expression_statement(node);
+}
+void class_method_checker::visit(ast::grouping_expression& node) {
+    check_expression_statement(node);
 }
 
 void class_method_checker::visit(ast::parameter_declaration& node) {}
-void class_method_checker::visit(ast::literal_expression& node) {}
-void class_method_checker::visit(ast::this_expression& node) {}
-void class_method_checker::visit(ast::identifier_expression& node) {}
-void class_method_checker::visit(ast::member_expression& node) {}
-void class_method_checker::visit(ast::grouping_expression& node) {}
 
 } // namespace analysis::semantic::phases::details
+
+namespace analysis::semantic::phases {
+
+void check_method_content(const std::unique_ptr<ast::program>& program,
+                          structures::symbol_table& symbol_table,
+                          structures::type_table& type_table,
+                          details::codegen_ast_collector& codegen,
+                          std::vector<common::diagnostic>& diagnostics,
+                          common::thread_pool& pool) {
+    std::vector<std::unique_ptr<details::class_method_checker>> checkers;
+    std::vector<std::function<void()>> tasks;
+    auto& nodes = codegen.program().nodes;
+    for (auto& cls : program->classes) {
+        auto* cls_symbol = symbol_table.lookup_class(cls->name);
+        assert(cls_symbol != nullptr);
+        for (auto& method : cls->methods) {
+            auto& checker = *checkers.emplace_back(std::make_unique<details::class_method_checker>(symbol_table, type_table, codegen));
+            tasks.emplace_back([&checker, &nodes, cls_symbol, &method] {
+                common::arena::scope scope{nodes};
+                checker.check_method(*cls_symbol, *method);
+            });
+        }
+        for (auto& constructor : cls->constructors) {
+            auto& checker = *checkers.emplace_back(std::make_unique<details::class_method_checker>(symbol_table, type_table, codegen));
+            tasks.emplace_back([&checker, &nodes, cls_symbol, &constructor] {
+                common::arena::scope scope{nodes};
+                checker.check_constructor(*cls_symbol, *constructor);
+            });
+        }
+    }
+    pool.run(std::move(tasks));
+
+    for (auto& checker : checkers) {
+        auto found = checker->take_diagnostics();
+        diagnostics.insert(diagnostics.end(), std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+    }
+}
+
+} // namespace analysis::semantic::phases
@@ -1,9 +1,11 @@
 #pragma once
 
-#include <stdexcept>
-#include <string>
+#include <vector>
 
-#include "compiler/analysis/semantic/error.h"
+#include "compiler/analysis/semantic/phases/codegen-ast-collector.h"
+#include "compiler/common/thread-pool.h"
+#include "compiler/compilation-structures/ast/codegen/ast.h"
+#include "compiler/compilation-structures/common.h"
 #include "compiler/compilation-structures/ast/parsing/ast-visitor.h"
 #include "compiler/compilation-structures/ast/parsing/ast.h"
 #include "compiler/compilation-structures/symbol-table.h"
@@ -12,10 +14,14 @@ namespace analysis::semantic::phases {
 
 namespace details {
 
+// Checks method and constructor bodies and lowers each statement to the codegen tree as it is checked; a body with
+// errors is left incomplete, the tree is dropped anyway.
 class class_method_checker : public ast::visitor {
 public:
-    class_method_checker(structures::symbol_table& symbol_table, structures::type_table& type_table, const error_formatter& errors)
-        : program_symbol_table(symbol_table), program_type_table(type_table), errors(errors) {}
+    class_method_checker(structures::symbol_table& symbol_table,
+                         structures::type_table& type_table,
+                         const codegen_ast_collector& codegen)
+        : program_symbol_table(symbol_table), program_type_table(type_table), codegen(codegen) {}
 
     void visit(ast::program& node) override;
     void visit(ast::block& node) override;
@@ -35,29 +41,55 @@ public:
     void visit(ast::call_expression& node) override;
     void visit(ast::grouping_expression& node) override;
 
-    void get_result() {
-        if (!error_message.empty()) {
-            throw std::runtime_error{error_message};
-        }
+    // check a single body; bodies only write their own method scope and codegen declaration, so separate checkers may
+    // run them concurrently
+    void check_method(structures::class_symbol& cls, ast::method_declaration& method);
+    void check_constructor(structures::class_symbol& cls, ast::constructor_declaration& constructor);
+
+    std::vector<common::diagnostic> take_diagnostics() {
+        return std::move(diagnostics);
     }
 
 private:
-    std::string error_message{};
+    // of this checker's bodies; the bodies are checked concurrently and their diagnostics joined in source order
+    std::vector<common::diagnostic> diagnostics;
     structures::symbol_table& program_symbol_table;
     structures::type_table& program_type_table;
-    const error_formatter& errors;
+    const codegen_ast_collector& codegen;
     structures::symbol_table *current_symbol_table = nullptr;
     structures::class_symbol* current_class_symbol = nullptr;
     const structures::type* method_return_type = nullptr;
     bool definitely_returns = false;
+
+    codegen_ast_collector::body_scope body_scope;
+    // codegen node of the statement or expression statement last checked, of the block last checked
+    std::unique_ptr<codegen::ast::statement> last_statement;
+    std::unique_ptr<codegen::ast::expression> last_expression;
+    std::unique_ptr<codegen::ast::block> last_block;
+
+    void add_parameters(const common::arena_vector<std::unique_ptr<ast::parameter_declaration>>& parameters,
+                        const common::arena_vector<std::unique_ptr<codegen::ast::parameter_declaration>>& declarations);
+    void check_expression_statement(ast::expression& node);
+    // a failed expression has the error type, inference has reported it
+    const structures::type* infer(const ast::expression* expression);
+    // a failed expression is not lowered, the body it is in won't reach codegen
+    std::unique_ptr<codegen::ast::expression> lower(const ast::expression* expression) const {
+        if (expression != nullptr && expression->inferred_type->isError()) {
+            return nullptr;
+        }
+        return codegen.lower(expression, body_scope);
+    }
 };
 
 } // namespace details
 
-inline void check_method_content(const std::unique_ptr<ast::program>& program, structures::symbol_table& symbol_table, structures::type_table& type_table, const error_formatter& errors) {
-    details::class_method_checker check_method_content(symbol_table, type_table, errors);
-    program->accept(check_method_content);
-    check_method_content.get_result();
-}
+// checks every method and constructor body as a separate task on the pool and fills in its codegen declaration,
+// diagnostics keep the source order
+void check_method_content(const std::unique_ptr<ast::program>& program,
+                          structures::symbol_table& symbol_table,
+                          structures::type_table& type_table,
+                          details::codegen_ast_collector& codegen,
+                          std::vector<common::diagnostic>& diagnostics,
+                          common::thread_pool& pool);
 
 } // namespace analysis::semantic::phases
@@ -2,9 +2,10 @@
 
 #include <memory>
 #include <unordered_map>
-#include <vector>
+#include <variant>
 
 #include "compiler/analysis/semantic/builtin-classes.h"
+#include "compiler/common/arena.h"
 #include "compiler/compilation-structures/ast/codegen/ast.h"
 #include "compiler/compilation-structures/ast/parsing/ast-visitor.h"
 #include "compiler/compilation-structures/ast/parsing/ast.h"
@@ -15,13 +16,25 @@ namespace analysis::semantic::phases {
 
 namespace details {
 
+// Collects the codegen classes and the declarations of their members. Method and constructor bodies are left empty:
+// the method checks lower each body as they check it, against these declarations.
 class codegen_ast_collector : public ast::visitor {
 public:
-    explicit codegen_ast_collector(structures::symbol_table& symbol_table, structures::type_table& type_table)
+    using variable_target = std::variant<codegen::ast::variable_declaration*, codegen::ast::parameter_declaration*, codegen::ast::field_declaration*>;
+
+    // what the names of one body refer to besides fields
+    struct body_scope {
+        codegen::ast::class_declaration* owner = nullptr;
+        std::unordered_map<const structures::variable_symbol*, variable_target> locals;
+    };
+
+    explicit codegen_ast_collector(structures::symbol_table& symbol_table)
         : program_symbol_table(symbol_table),
-          program_type_table(type_table) {}
+          result_program(std::make_unique<codegen::ast::program>()) {}
 
-    std::unique_ptr<codegen::ast::program> result_program;
+    codegen::ast::program& program() {
+        return *result_program;
+    }
     std::unique_ptr<codegen::ast::program> get_result() {
         return std::move(result_program);
     }
@@ -44,43 +57,41 @@ public:
     void visit(ast::call_expression& node) override;
     void visit(ast::grouping_expression& node) override;
 
+    // Lookups for the bodies; they only read the collected declarations, so bodies are lowered concurrently.
+    codegen::ast::class_declaration* resolveType(common::symbol_id type_name) const;
+    codegen::ast::class_declaration* resolveType(const structures::type* type) const;
+    codegen::ast::method_declaration* method_of(const structures::method_symbol& method) const;
+    codegen::ast::constructor_declaration* constructor_of(const structures::method_symbol& constructor) const;
+    variable_target target_of(const structures::variable_symbol& variable, const body_scope& scope) const;
+
+    // an expression the method checks inferred, with every call and name in it resolved
+    std::unique_ptr<codegen::ast::expression> lower(const ast::expression* expression, const body_scope& scope) const;
+
 private:
     structures::symbol_table& program_symbol_table;
-    structures::type_table& program_type_table;
+    std::unique_ptr<codegen::ast::program> result_program;
 
     // Current context
+    structures::class_symbol* current_class_symbol = nullptr;
     codegen::ast::class_declaration* current_class = nullptr;
-    bool inside_function_scope = false;
-    codegen::ast::method_declaration* current_method = nullptr;
-    structures::symbol_table* current_scope = nullptr;
-    size_t current_method_pass_index = 0;
-
-    // Mappings from parsing AST to codegen AST
-    std::unordered_map<ast::class_declaration*, codegen::ast::class_declaration*> class_map;
-    std::unordered_map<std::string, std::variant<codegen::ast::variable_declaration*, codegen::ast::parameter_declaration*, codegen::ast::field_declaration*>>
-        variable_map;
-
-    // Intermediate results for transformations
-    std::unique_ptr<codegen::ast::expression> last_expression;
-    std::unique_ptr<codegen::ast::statement> last_statement;
-    std::unique_ptr<codegen::ast::block> last_block;
-
-    // Helper methods
-    codegen::ast::class_declaration* resolveType(const std::string& type_name);
-    codegen::ast::class_declaration* resolveType(const structures::type* type);
-    std::unique_ptr<codegen::ast::expression> transformExpression(ast::expression* expr);
-    std::unique_ptr<codegen::ast::block> transformBlock(ast::block* block);
+    common::arena_vector<std::unique_ptr<codegen::ast::parameter_declaration>>* current_parameters = nullptr;
+
+    // every class of the program by name, filled as the classes are created
+    std::unordered_map<common::symbol_id, codegen::ast::class_declaration*> classes_by_name;
+    std::unordered_map<const structures::variable_symbol*, codegen::ast::field_declaration*> fields;
+
+    void add_fields(structures::class_symbol& symbol, codegen::ast::class_declaration& cls);
 };
 
 } // namespace details
 
-inline std::unique_ptr<codegen::ast::program>
-codegen_ast_collect(const std::unique_ptr<ast::program>& program, structures::symbol_table& symbol_table, structures::type_table& type_table) noexcept {
-    details::codegen_ast_collector transformer(symbol_table, type_table);
-    transformer.result_program = std::make_unique<codegen::ast::program>();
-    builtin::add_builtin_classes_to_codegen(*transformer.result_program);
-    program->accept(transformer);
-    return transformer.get_result();
+inline std::unique_ptr<details::codegen_ast_collector>
+collect_codegen_declarations(const std::unique_ptr<ast::program>& program, structures::symbol_table& symbol_table) {
+    auto collector = std::make_unique<details::codegen_ast_collector>(symbol_table);
+    common::arena::scope scope{collector->program().nodes};
+    collector->program().internal_classes = builtin::codegen_classes();
+    program->accept(*collector);
+    return collector;
 }
 
 } // namespace analysis::semantic::phases
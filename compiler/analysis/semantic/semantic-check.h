@@ -1,29 +1,54 @@
 #pragma once
 
 #include <memory>
-#include <stdexcept>
-#include <string_view>
+#include <vector>
 
-#include "compiler/analysis/semantic/error.h"
 #include "compiler/analysis/semantic/phases/class-body-collector.h"
 #include "compiler/analysis/semantic/phases/class-collector.h"
 #include "compiler/analysis/semantic/phases/class-field-checker.h"
 #include "compiler/analysis/semantic/phases/class-method-checker.h"
 #include "compiler/compilation-structures/ast/codegen/ast.h"
 #include "compiler/compilation-structures/ast/parsing/ast.h"
+#include "compiler/compilation-structures/common.h"
 #include "compiler/analysis/semantic/phases/codegen-ast-collector.h"
+#include "compiler/common/thread-pool.h"
 
 namespace analysis::semantic {
 
-inline std::unique_ptr<codegen::ast::program> check_program(const std::unique_ptr<ast::program>& program,
-                                                            std::string_view file_name,
-                                                            std::string_view source) {
-    error_formatter errors{file_name, source};
-    auto [program_symbol_table, program_type_table] = phases::collect_program_classes(program, errors);
-    phases::process_classes_content(program, *program_symbol_table, *program_type_table, errors);
-    phases::check_field_content(program, *program_symbol_table, *program_type_table, errors);
-    phases::check_method_content(program, *program_symbol_table, *program_type_table, errors);
-    return phases::codegen_ast_collect(program, *program_symbol_table, *program_type_table);
+struct check_result {
+    // null when there are diagnostics
+    std::unique_ptr<codegen::ast::program> program;
+    std::vector<common::diagnostic> diagnostics;
+};
+
+// Runs the phases until one of them reports a diagnostic. The diagnostics are records, the driver formats them with
+// error_formatter.
+inline check_result check_program(const std::unique_ptr<ast::program>& program, size_t threads = 1) {
+    check_result result;
+    auto& diagnostics = result.diagnostics;
+    // room for the diagnostics of any likely program, so reporting doesn't reallocate
+    diagnostics.reserve(256);
+
+    // the class-level phases stay serial, method bodies are checked and lowered on the pool
+    common::thread_pool pool{threads};
+    auto [program_symbol_table, program_type_table] = phases::collect_program_classes(program, diagnostics);
+    if (!diagnostics.empty()) {
+        return result;
+    }
+    phases::process_classes_content(program, *program_symbol_table, *program_type_table, diagnostics);
+    if (!diagnostics.empty()) {
+        return result;
+    }
+    phases::check_field_content(program, *program_symbol_table, *program_type_table, diagnostics);
+    if (!diagnostics.empty()) {
+        return result;
+    }
+    auto codegen = phases::collect_codegen_declarations(program, *program_symbol_table);
+    phases::check_method_content(program, *program_symbol_table, *program_type_table, *codegen, diagnostics, pool);
+    if (diagnostics.empty()) {
+        result.program = codegen->get_result();
+    }
+    return result;
 }
 
 } // namespace analysis::semantic
@@ -0,0 +1,121 @@
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "compiler/common/source-manager.h"
+#include "compiler/lexer/lexer.h"
+#include "compiler/lexer/reference-lexer.h"
+#include "compiler/parser/parser.h"
+
+// Lexer and parser throughput on the given sources, in MB of source per second.
+//   ./frontend-bench [--repeat=<n>] <file.po>...
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+size_t count_tokens(std::string_view source) {
+    lexer::token_stream stream{source};
+    size_t count = 0;
+    while (stream.at(count).type != lexer::token_type::tok_eof) {
+        ++count;
+    }
+    return count + 1;
+}
+
+size_t count_reference_tokens(std::string_view source) {
+    lexer::reference::lexeme_parser reference{source};
+    lexer::literal_value literal;
+    size_t count = 1;
+    while (reference.take_next_token(literal).type != lexer::token_type::tok_eof) {
+        ++count;
+    }
+    return count;
+}
+
+double megabytes_per_second(size_t bytes, bench_clock::duration elapsed) {
+    auto seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds > 0 ? static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds : 0.0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t repeat = 100;
+    common::source_manager files;
+    std::vector<std::string_view> sources;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg{argv[i]};
+        if (arg.starts_with("--repeat=")) {
+            auto value = arg.substr(std::string_view{"--repeat="}.size());
+            if (std::from_chars(value.data(), value.data() + value.size(), repeat).ec != std::errc{} || repeat == 0) {
+                std::cerr << "Invalid --repeat value '" << value << "'\n";
+                return 1;
+            }
+            continue;
+        }
+        try {
+            sources.push_back(files.load(std::string{arg}));
+        } catch (const std::exception& e) {
+            std::cerr << e.what();
+            return 1;
+        }
+    }
+    if (sources.empty()) {
+        std::cout << "Usage: ./frontend-bench [--repeat=<n>] <file.po>...\n";
+        return 1;
+    }
+
+    size_t bytes = 0;
+    size_t tokens = 0;
+    for (const auto& source : sources) {
+        bytes += source.size();
+        tokens += count_tokens(source);
+    }
+    bytes *= repeat;
+    tokens *= repeat;
+
+    auto lex_start = bench_clock::now();
+    size_t lexed = 0;
+    for (size_t i = 0; i < repeat; ++i) {
+        for (const auto& source : sources) {
+            lexed += count_tokens(source);
+        }
+    }
+    auto lex_time = bench_clock::now() - lex_start;
+
+    auto reference_start = bench_clock::now();
+    size_t reference_lexed = 0;
+    for (size_t i = 0; i < repeat; ++i) {
+        for (const auto& source : sources) {
+            reference_lexed += count_reference_tokens(source);
+        }
+    }
+    auto reference_time = bench_clock::now() - reference_start;
+
+    auto parse_start = bench_clock::now();
+    size_t classes = 0;
+    try {
+        for (size_t i = 0; i < repeat; ++i) {
+            for (const auto& source : sources) {
+                auto parser = parser::parser(lexer::token_stream{source});
+                classes += parser.parse()->classes.size();
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Parse error: " << e.what();
+        return 1;
+    }
+    auto parse_time = bench_clock::now() - parse_start;
+
+    std::cout << "sources: " << sources.size() << " file(s), " << bytes / repeat << " bytes, " << tokens / repeat << " tokens, "
+              << classes / repeat << " classes, x" << repeat << "\n"
+              << "lex:         " << megabytes_per_second(bytes, lex_time) << " MB/s\n"
+              << "lex (ref):   " << megabytes_per_second(bytes, reference_time) << " MB/s\n"
+              << "lex + parse: " << megabytes_per_second(bytes, parse_time) << " MB/s\n";
+    return lexed == tokens && reference_lexed == tokens ? 0 : 1;
+}
@@ -0,0 +1,594 @@
+#include "compiler/codegen/bytecode/bytecode-compiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <format>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#include "compiler/common/variant-helper.h"
+
+namespace {
+
+namespace well_known = common::well_known;
+
+bool is_value_type(const codegen::ast::class_declaration* decl) {
+    while (decl != nullptr) {
+        if (decl->name == well_known::any_value) {
+            return true;
+        }
+        decl = decl->base_class;
+    }
+    return false;
+}
+
+size_t align_to(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+namespace codegen::bytecode {
+
+bool bytecode_compiler::is_builtin_class(common::symbol_id name) {
+    using namespace common::well_known;
+    static const common::symbol_id builtin_names[] = {class_, any_value, any_ref, integer, real, boolean, unit, array_integer, io};
+    return std::ranges::find(builtin_names, name) != std::end(builtin_names);
+}
+
+size_t bytecode_compiler::field_size(const codegen::ast::class_declaration* type) {
+    // Boolean, Unit and IO are i1 in the native layout, everything else is an i64, a double or a pointer
+    if (type != nullptr && (type->name == well_known::boolean || type->name == well_known::unit || type->name == well_known::io)) {
+        return 1;
+    }
+    return 8;
+}
+
+std::vector<common::symbol_id> bytecode_compiler::param_type_names_of(
+    const common::arena_vector<std::unique_ptr<codegen::ast::parameter_declaration>>& params) {
+    std::vector<common::symbol_id> names;
+    names.reserve(params.size());
+    for (auto& p : params) {
+        names.push_back(p->type ? p->type->name : common::symbol_id{"void"});
+    }
+    return names;
+}
+
+bytecode_compiler::bytecode_compiler(std::string_view entry_class_name)
+    : entry_class_name(entry_class_name) {}
+
+std::unique_ptr<module> bytecode_compiler::compile(codegen::ast::program& program) {
+    result = std::make_unique<module>();
+    program.accept(*this);
+    return std::move(result);
+}
+
+void bytecode_compiler::define_class_layout(codegen::ast::class_declaration& cls) {
+    auto* runtime = classes.at(&cls);
+    if (runtime->size != 0) {
+        return;
+    }
+    // header pointer first, or the whole base class object, then the own fields with natural alignment
+    size_t offset = sizeof(void*);
+    if (cls.base_class && !is_builtin_class(cls.base_class->name)) {
+        define_class_layout(*cls.base_class);
+        runtime->base = classes.at(cls.base_class);
+        offset = runtime->base->size;
+    }
+    for (auto& field : cls.fields) {
+        auto size = field_size(field->type);
+        offset = align_to(offset, size);
+        field_offsets[field.get()] = static_cast<uint32_t>(offset);
+        offset += size;
+    }
+    runtime->size = align_to(offset, runtime->alignment);
+}
+
+void bytecode_compiler::build_vtable_for(codegen::ast::class_declaration& cls) {
+    if (vtable_entries.contains(&cls)) {
+        return;
+    }
+    std::vector<vtable_entry> entries;
+    if (cls.base_class && !is_builtin_class(cls.base_class->name)) {
+        build_vtable_for(*cls.base_class);
+        entries = vtable_entries.at(cls.base_class);
+    }
+    for (auto& m : cls.methods) {
+        auto params = param_type_names_of(m->parameters);
+        auto it = std::ranges::find_if(entries, [&](const vtable_entry& e) { return e.name == m->name && e.param_type_names == params; });
+        if (it != entries.end()) {
+            it->method = m.get();
+        } else {
+            entries.push_back({m->name, std::move(params), m.get()});
+        }
+    }
+
+    auto* runtime = classes.at(&cls);
+    runtime->dispatch.assign(entries.size() + 1, nullptr);
+    runtime->dispatch[0] = runtime;
+    for (auto& e : entries) {
+        runtime->vtable.push_back(result->functions[method_functions.at(e.method)].get());
+    }
+    vtable_entries[&cls] = std::move(entries);
+}
+
+uint32_t bytecode_compiler::method_vtable_slot(const codegen::ast::method_declaration& method) const {
+    const auto& entries = vtable_entries.at(method.class_owner);
+    auto params = param_type_names_of(method.parameters);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].name == method.name && entries[i].param_type_names == params) {
+            return static_cast<uint32_t>(i);
+        }
+    }
+    throw std::runtime_error(std::format("method '{}' is missing from the vtable of '{}'", method.name, method.class_owner->name));
+}
+
+void bytecode_compiler::visit(codegen::ast::program& node) {
+    for (auto& cls : node.classes) {
+        auto runtime = std::make_unique<runtime_class>();
+        runtime->name = cls->name.str();
+        classes[cls.get()] = runtime.get();
+        class_indices[cls.get()] = static_cast<uint32_t>(result->classes.size());
+        result->classes.push_back(std::move(runtime));
+    }
+    for (auto& cls : node.classes) {
+        define_class_layout(*cls);
+    }
+
+    // functions are named like their llvm_codegen counterparts, which lets the tiered mode find the native code
+    auto add_function = [this](std::string name, const common::arena_vector<std::unique_ptr<codegen::ast::parameter_declaration>>& params) {
+        auto fn = std::make_unique<function>();
+        fn->name = std::move(name);
+        for (auto& type_name : param_type_names_of(params)) {
+            fn->name += "_" + type_name.str();
+        }
+        fn->parameter_count = static_cast<uint32_t>(params.size());
+        result->functions.push_back(std::move(fn));
+        return static_cast<uint32_t>(result->functions.size() - 1);
+    };
+    for (auto& cls : node.classes) {
+        for (auto& method : cls->methods) {
+            method_functions[method.get()] = add_function(cls->name.str() + "_" + method->name.str(), method->parameters);
+        }
+        for (auto& ctor : cls->constructors) {
+            constructor_functions[ctor.get()] = add_function(cls->name.str() + "_ctor", ctor->parameters);
+        }
+    }
+    for (auto& cls : node.classes) {
+        build_vtable_for(*cls);
+    }
+
+    for (auto& cls : node.classes) {
+        for (auto& method : cls->methods) {
+            compile_method(*method);
+        }
+        for (auto& ctor : cls->constructors) {
+            compile_constructor(*ctor);
+        }
+    }
+
+    for (auto& cls : node.classes) {
+        if (cls->name != entry_class_name) {
+            continue;
+        }
+        for (auto& ctor : cls->constructors) {
+            if (ctor->parameters.empty()) {
+                result->entry_class = classes.at(cls.get());
+                result->entry_constructor = result->functions[constructor_functions.at(ctor.get())].get();
+            }
+        }
+    }
+}
+
+void bytecode_compiler::begin_function(uint32_t index, const common::arena_vector<std::unique_ptr<codegen::ast::parameter_declaration>>& params) {
+    current_function = result->functions[index].get();
+    variable_registers.clear();
+    parameter_registers.clear();
+    next_register = 1;
+    for (auto& p : params) {
+        parameter_registers[p.get()] = allocate_register();
+    }
+    current_function->register_count = next_register;
+}
+
+void bytecode_compiler::compile_method(codegen::ast::method_declaration& method) {
+    if (!method.body.has_value()) {
+        return;
+    }
+    begin_function(method_functions.at(&method), method.parameters);
+    std::visit(overloaded{
+                   [this](std::unique_ptr<codegen::ast::block>& b) { b->accept(*this); },
+                   [this](std::unique_ptr<codegen::ast::expression>& e) { emit(opcode::ret, compile_expression(*e)); }},
+               *method.body);
+    // jumps past the last statement land here, like the null return llvm_codegen appends
+    emit(opcode::ret, load_constant({.integer = 0}));
+    current_function = nullptr;
+}
+
+void bytecode_compiler::compile_constructor(codegen::ast::constructor_declaration& ctor) {
+    begin_function(constructor_functions.at(&ctor), ctor.parameters);
+    inside_constructor = true;
+
+    if (ctor.super_constructor) {
+        call_site site{.target = constructor_functions.at(ctor.super_constructor->constructor)};
+        compile_call(opcode::call, site, 0, ctor.super_constructor->arguments, false);
+        next_register = current_function->parameter_count + 1;
+    }
+    emit(opcode::set_vtable, 0, class_indices.at(ctor.class_owner));
+
+    for (auto& field : ctor.class_owner->fields) {
+        if (!field->initializer) {
+            continue;
+        }
+        auto value = compile_expression(*field->initializer);
+        emit(field_size(field->type) == 1 ? opcode::store_field_1 : opcode::store_field_8, 0, field_offsets.at(field.get()), value);
+        next_register = current_function->parameter_count + 1;
+    }
+
+    if (ctor.body) {
+        ctor.body->accept(*this);
+    }
+    emit(opcode::ret_void);
+    inside_constructor = false;
+    current_function = nullptr;
+}
+
+uint32_t bytecode_compiler::allocate_register() {
+    auto reg = next_register++;
+    current_function->register_count = std::max(current_function->register_count, next_register);
+    return reg;
+}
+
+uint32_t bytecode_compiler::load_constant(value constant) {
+    auto reg = allocate_register();
+    current_function->constants.push_back(constant);
+    emit(opcode::load_constant, reg, static_cast<uint32_t>(current_function->constants.size() - 1));
+    return reg;
+}
+
+size_t bytecode_compiler::emit(opcode op, uint32_t a, uint32_t b, uint32_t c) {
+    current_function->code.push_back({op, a, b, c});
+    return current_function->code.size() - 1;
+}
+
+void bytecode_compiler::patch_jump(size_t at, uint32_t target) {
+    auto& ins = current_function->code[at];
+    (ins.op == opcode::jump ? ins.a : ins.b) = target;
+}
+
+uint32_t bytecode_compiler::code_position() const {
+    return static_cast<uint32_t>(current_function->code.size());
+}
+
+uint32_t bytecode_compiler::compile_expression(codegen::ast::expression& expr) {
+    expr.accept(*this);
+    return current_register;
+}
+
+uint32_t bytecode_compiler::compile_value_or_ref(codegen::ast::expression& expr) {
+    auto reg = compile_expression(expr);
+    if (auto* type = expr.type; !is_builtin_class(type->name) && is_value_type(type)) {
+        auto copy = allocate_register();
+        emit(opcode::copy_object, copy, reg, class_indices.at(type));
+        return copy;
+    }
+    return reg;
+}
+
+uint32_t bytecode_compiler::compile_call(opcode op, call_site site, uint32_t receiver,
+                                         const common::arena_vector<std::unique_ptr<codegen::ast::expression>>& args, bool copy_values) {
+    // arguments are evaluated into a window at the top of the frame, which becomes the callee's first registers
+    auto base = next_register;
+    next_register += static_cast<uint32_t>(args.size()) + 1;
+    current_function->register_count = std::max(current_function->register_count, next_register);
+
+    emit(opcode::move, base, receiver);
+    for (size_t i = 0; i < args.size(); ++i) {
+        auto value = copy_values ? compile_value_or_ref(*args[i]) : compile_expression(*args[i]);
+        auto target = base + 1 + static_cast<uint32_t>(i);
+        if (value != target) {
+            emit(opcode::move, target, value);
+        }
+        next_register = base + static_cast<uint32_t>(args.size()) + 1;
+    }
+
+    current_function->call_sites.push_back(site);
+    emit(op, base, static_cast<uint32_t>(current_function->call_sites.size() - 1), base);
+    next_register = base + 1;
+    return base;
+}
+
+uint32_t bytecode_compiler::to_real(uint32_t reg, const codegen::ast::class_declaration* type) {
+    if (type == nullptr || type->name != well_known::integer) {
+        return reg;
+    }
+    auto converted = allocate_register();
+    emit(opcode::integer_to_real, converted, reg);
+    return converted;
+}
+
+void bytecode_compiler::visit(codegen::ast::block& node) {
+    for (auto& item : node.items) {
+        auto mark = next_register;
+        item->accept(*this);
+        if (item->kind != codegen::ast::node_kind::variable_declaration) {
+            next_register = mark;
+        }
+    }
+}
+
+void bytecode_compiler::visit(codegen::ast::class_declaration&) {}
+void bytecode_compiler::visit(codegen::ast::field_declaration&) {}
+void bytecode_compiler::visit(codegen::ast::method_declaration&) {}
+void bytecode_compiler::visit(codegen::ast::constructor_declaration&) {}
+void bytecode_compiler::visit(codegen::ast::parameter_declaration&) {}
+
+void bytecode_compiler::visit(codegen::ast::variable_declaration& node) {
+    auto reg = allocate_register();
+    variable_registers[&node] = reg;
+    if (node.initializer) {
+        auto value = compile_value_or_ref(*node.initializer);
+        if (value != reg) {
+            emit(opcode::move, reg, value);
+        }
+    }
+    next_register = reg + 1;
+}
+
+void bytecode_compiler::visit(codegen::ast::variable_assignment& node) {
+    auto value = compile_value_or_ref(*node.value);
+    std::visit(overloaded{
+                   [&](codegen::ast::variable_declaration* d) { emit(opcode::move, variable_registers.at(d), value); },
+                   [&](codegen::ast::parameter_declaration* d) { emit(opcode::move, parameter_registers.at(d), value); },
+                   [&](codegen::ast::field_declaration* d) {
+                       emit(field_size(d->type) == 1 ? opcode::store_field_1 : opcode::store_field_8, 0, field_offsets.at(d), value);
+                   }},
+               node.target);
+}
+
+void bytecode_compiler::visit(codegen::ast::field_assignment& node) {
+    auto value = compile_value_or_ref(*node.value);
+    auto object = compile_expression(*node.target->object);
+    auto* field = node.target->member;
+    emit(field_size(field->type) == 1 ? opcode::store_field_1 : opcode::store_field_8, object, field_offsets.at(field), value);
+}
+
+void bytecode_compiler::visit(codegen::ast::while_statement& node) {
+    auto mark = next_register;
+    auto condition_position = code_position();
+    auto condition = compile_expression(*node.condition);
+    auto exit_jump = emit(opcode::jump_if_false, condition);
+    next_register = mark;
+
+    node.body->accept(*this);
+    emit(opcode::jump, condition_position);
+    patch_jump(exit_jump, code_position());
+}
+
+void bytecode_compiler::visit(codegen::ast::if_statement& node) {
+    auto mark = next_register;
+    auto condition = compile_expression(*node.condition);
+    auto else_jump = emit(opcode::jump_if_false, condition);
+    next_register = mark;
+
+    node.true_branch->accept(*this);
+    if (!node.false_branch) {
+        patch_jump(else_jump, code_position());
+        return;
+    }
+    auto end_jump = emit(opcode::jump);
+    patch_jump(else_jump, code_position());
+    node.false_branch->accept(*this);
+    patch_jump(end_jump, code_position());
+}
+
+void bytecode_compiler::visit(codegen::ast::return_statement& node) {
+    auto value = node.value ? compile_expression(*node.value) : load_constant({.integer = 0});
+    if (inside_constructor) {
+        emit(opcode::ret_void);
+    } else {
+        emit(opcode::ret, value);
+    }
+}
+
+void bytecode_compiler::visit(codegen::ast::literal_expression& node) {
+    current_register = std::visit(overloaded{
+                                      [this](int64_t v) { return load_constant({.integer = v}); },
+                                      [this](double v) { return load_constant({.real = v}); },
+                                      [this](bool v) { return load_constant({.integer = v ? 1 : 0}); }},
+                                  node.value);
+}
+
+void bytecode_compiler::visit(codegen::ast::this_expression&) {
+    current_register = 0;
+}
+
+void bytecode_compiler::visit(codegen::ast::identifier_expression& node) {
+    current_register = std::visit(overloaded{
+                                      [this](codegen::ast::variable_declaration* d) { return variable_registers.at(d); },
+                                      [this](codegen::ast::parameter_declaration* d) { return parameter_registers.at(d); },
+                                      [this](codegen::ast::field_declaration* d) {
+                                          auto reg = allocate_register();
+                                          emit(field_size(d->type) == 1 ? opcode::load_field_1 : opcode::load_field_8, reg, 0, field_offsets.at(d));
+                                          return reg;
+                                      }},
+                                  node.target);
+}
+
+void bytecode_compiler::visit(codegen::ast::member_expression& node) {
+    auto* field = node.member;
+    auto offset = field_offsets.find(field);
+    if (offset == field_offsets.end()) {
+        throw std::runtime_error(std::format("field '{}' of builtin class '{}' is not supported", field->name, field->class_owner->name));
+    }
+    auto object = compile_expression(*node.object);
+    current_register = allocate_register();
+    emit(field_size(field->type) == 1 ? opcode::load_field_1 : opcode::load_field_8, current_register, object, offset->second);
+}
+
+void bytecode_compiler::visit(codegen::ast::grouping_expression& node) {
+    current_register = compile_expression(*node.inner);
+}
+
+void bytecode_compiler::visit(codegen::ast::method_call_expression& node) {
+    if (is_builtin_class(node.method->class_owner->name)) {
+        current_register = compile_builtin_method(node);
+        return;
+    }
+    auto receiver = compile_expression(*node.object);
+    current_register = compile_call(opcode::call_virtual, {.slot = method_vtable_slot(*node.method)}, receiver, node.arguments, true);
+}
+
+void bytecode_compiler::visit(codegen::ast::constructor_call_expression& node) {
+    if (is_builtin_class(node.constructor->class_owner->name)) {
+        current_register = compile_builtin_constructor(node);
+        return;
+    }
+    auto object = allocate_register();
+    emit(opcode::new_object, object, class_indices.at(node.constructor->class_owner));
+    compile_call(opcode::call, {.target = constructor_functions.at(node.constructor)}, object, node.arguments, true);
+    next_register = object + 1;
+    current_register = object;
+}
+
+uint32_t bytecode_compiler::compile_builtin_method(const codegen::ast::method_call_expression& node) {
+    const auto* owner = node.method->class_owner;
+    const auto& cls = owner->name;
+    const auto& name = node.method->name;
+
+    auto receiver = compile_expression(*node.object);
+    std::vector<uint32_t> args;
+    for (auto& arg : node.arguments) {
+        args.push_back(compile_expression(*arg));
+    }
+    auto unary = [&](opcode op, uint32_t operand) {
+        auto reg = allocate_register();
+        emit(op, reg, operand);
+        return reg;
+    };
+    auto binary = [&](opcode op, uint32_t lhs, uint32_t rhs) {
+        auto reg = allocate_register();
+        emit(op, reg, lhs, rhs);
+        return reg;
+    };
+
+    bool param_is_real = !node.method->parameters.empty() && node.method->parameters[0]->type->name == well_known::real;
+    bool returns_real = node.method->return_type && node.method->return_type->name == well_known::real;
+    bool uses_fp = (cls == well_known::real) || param_is_real || returns_real;
+
+    if (cls == well_known::integer || cls == well_known::real) {
+        if (name == well_known::unary_minus) {
+            return uses_fp ? unary(opcode::neg_real, to_real(receiver, owner)) : unary(opcode::neg_integer, receiver);
+        }
+        if (name == well_known::to_real) {
+            return unary(opcode::integer_to_real, receiver);
+        }
+        if (name == well_known::to_integer) {
+            return unary(opcode::real_to_integer, receiver);
+        }
+        if (name == well_known::to_boolean) {
+            return unary(opcode::integer_to_boolean, receiver);
+        }
+
+        auto lhs = receiver;
+        auto rhs = args[0];
+        if (uses_fp) {
+            lhs = to_real(lhs, owner);
+            rhs = to_real(rhs, node.method->parameters[0]->type);
+        }
+        static const std::pair<common::symbol_id, std::pair<opcode, opcode>> arithmetic[] = {
+            {well_known::plus, {opcode::add_integer, opcode::add_real}},
+            {well_known::minus, {opcode::sub_integer, opcode::sub_real}},
+            {well_known::mult, {opcode::mul_integer, opcode::mul_real}},
+            {well_known::div, {opcode::div_integer, opcode::div_real}},
+            {well_known::rem, {opcode::rem_integer, opcode::rem_real}},
+            {well_known::less, {opcode::less_integer, opcode::less_real}},
+            {well_known::less_equal, {opcode::less_equal_integer, opcode::less_equal_real}},
+            {well_known::greater, {opcode::greater_integer, opcode::greater_real}},
+            {well_known::greater_equal, {opcode::greater_equal_integer, opcode::greater_equal_real}},
+            {well_known::equal, {opcode::equal_integer, opcode::equal_real}},
+        };
+        for (auto& [op_name, ops] : arithmetic) {
+            if (name == op_name) {
+                return binary(uses_fp ? ops.second : ops.first, lhs, rhs);
+            }
+        }
+    }
+
+    if (cls == well_known::boolean) {
+        if (name == well_known::not_) {
+            return unary(opcode::not_boolean, receiver);
+        }
+        if (name == well_known::to_integer) {
+            return receiver;
+        }
+        if (name == well_known::and_) {
+            return binary(opcode::and_boolean, receiver, args[0]);
+        }
+        if (name == well_known::or_) {
+            return binary(opcode::or_boolean, receiver, args[0]);
+        }
+        if (name == well_known::xor_) {
+            return binary(opcode::xor_boolean, receiver, args[0]);
+        }
+    }
+
+    if (cls == well_known::array_integer) {
+        if (name == well_known::len) {
+            return unary(opcode::array_length, receiver);
+        }
+        if (name == well_known::get) {
+            return binary(opcode::array_get, receiver, args[0]);
+        }
+        if (name == well_known::set) {
+            emit(opcode::array_set, receiver, args[0], args[1]);
+            return load_constant({.integer = 0});
+        }
+    }
+
+    if (cls == well_known::io && name == well_known::print) {
+        const auto& arg_type = node.method->parameters[0]->type->name;
+        if (arg_type == well_known::integer) {
+            emit(opcode::print_integer, args[0]);
+        } else if (arg_type == well_known::real) {
+            emit(opcode::print_real, args[0]);
+        } else {
+            emit(opcode::print_boolean, args[0]);
+        }
+        return load_constant({.integer = 0});
+    }
+
+    throw std::runtime_error(std::format("built-in method '{}.{}' has no bytecode lowering", cls, name));
+}
+
+uint32_t bytecode_compiler::compile_builtin_constructor(const codegen::ast::constructor_call_expression& node) {
+    const auto& cls_name = node.constructor->class_owner->name;
+    std::vector<uint32_t> args;
+    for (auto& arg : node.arguments) {
+        args.push_back(compile_expression(*arg));
+    }
+
+    if (cls_name == well_known::array_integer) {
+        assert(args.size() == 1);
+        auto reg = allocate_register();
+        emit(opcode::new_array, reg, args[0]);
+        return reg;
+    }
+    if (args.empty() || cls_name == well_known::unit || cls_name == well_known::io) {
+        return load_constant({.integer = 0});
+    }
+
+    const auto& src_name = node.constructor->parameters[0]->type->name;
+    if (cls_name == well_known::integer && src_name == well_known::real) {
+        auto reg = allocate_register();
+        emit(opcode::real_to_integer, reg, args[0]);
+        return reg;
+    }
+    if (cls_name == well_known::real && src_name == well_known::integer) {
+        return to_real(args[0], node.constructor->parameters[0]->type);
+    }
+    return args[0];
+}
+
+} // namespace codegen::bytecode
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "compiler/codegen/bytecode/bytecode.h"
+#include "compiler/compilation-structures/ast/codegen/ast.h"
+#include "compiler/compilation-structures/ast/codegen/ast-visitor.h"
+
+namespace codegen::bytecode {
+
+class bytecode_compiler : public codegen::ast::visitor {
+public:
+    explicit bytecode_compiler(std::string_view entry_class_name = "Main");
+    ~bytecode_compiler() override = default;
+
+    std::unique_ptr<module> compile(codegen::ast::program& program);
+
+    void visit(codegen::ast::program& node) override;
+    void visit(codegen::ast::block& node) override;
+    void visit(codegen::ast::class_declaration& node) override;
+    void visit(codegen::ast::field_declaration& node) override;
+    void visit(codegen::ast::variable_declaration& node) override;
+    void visit(codegen::ast::parameter_declaration& node) override;
+    void visit(codegen::ast::method_declaration& node) override;
+    void visit(codegen::ast::constructor_declaration& node) override;
+    void visit(codegen::ast::variable_assignment& node) override;
+    void visit(codegen::ast::field_assignment& node) override;
+    void visit(codegen::ast::while_statement& node) override;
+    void visit(codegen::ast::if_statement& node) override;
+    void visit(codegen::ast::return_statement& node) override;
+    void visit(codegen::ast::literal_expression& node) override;
+    void visit(codegen::ast::this_expression& node) override;
+    void visit(codegen::ast::identifier_expression& node) override;
+    void visit(codegen::ast::method_call_expression& node) override;
+    void visit(codegen::ast::constructor_call_expression& node) override;
+    void visit(codegen::ast::member_expression& node) override;
+    void visit(codegen::ast::grouping_expression& node) override;
+
+private:
+    struct vtable_entry {
+        common::symbol_id name;
+        std::vector<common::symbol_id> param_type_names;
+        const codegen::ast::method_declaration* method;
+    };
+
+    common::symbol_id entry_class_name;
+    std::unique_ptr<module> result;
+
+    std::unordered_map<const codegen::ast::class_declaration*, runtime_class*> classes;
+    std::unordered_map<const codegen::ast::class_declaration*, uint32_t> class_indices;
+    std::unordered_map<const codegen::ast::class_declaration*, std::vector<vtable_entry>> vtable_entries;
+    std::unordered_map<const codegen::ast::field_declaration*, uint32_t> field_offsets;
+    std::unordered_map<const codegen::ast::method_declaration*, uint32_t> method_functions;
+    std::unordered_map<const codegen::ast::constructor_declaration*, uint32_t> constructor_functions;
+    std::unordered_map<const codegen::ast::variable_declaration*, uint32_t> variable_registers;
+    std::unordered_map<const codegen::ast::parameter_declaration*, uint32_t> parameter_registers;
+
+    function* current_function = nullptr;
+    bool inside_constructor = false;
+    uint32_t next_register = 0;
+    uint32_t current_register = 0;
+
+    void define_class_layout(codegen::ast::class_declaration& cls);
+    void build_vtable_for(codegen::ast::class_declaration& cls);
+    uint32_t method_vtable_slot(const codegen::ast::method_declaration& method) const;
+    void compile_method(codegen::ast::method_declaration& method);
+    void compile_constructor(codegen::ast::constructor_declaration& ctor);
+    void begin_function(uint32_t index, const common::arena_vector<std::unique_ptr<codegen::ast::parameter_declaration>>& params);
+
+    uint32_t compile_expression(codegen::ast::expression& expr);
+    uint32_t compile_value_or_ref(codegen::ast::expression& expr);
+    uint32_t compile_builtin_method(const codegen::ast::method_call_expression& call);
+    uint32_t compile_builtin_constructor(const codegen::ast::constructor_call_expression& call);
+    uint32_t compile_call(opcode op, call_site site, uint32_t receiver,
+                          const common::arena_vector<std::unique_ptr<codegen::ast::expression>>& args, bool copy_values);
+    uint32_t to_real(uint32_t reg, const codegen::ast::class_declaration* type);
+
+    uint32_t allocate_register();
+    uint32_t load_constant(value constant);
+    size_t emit(opcode op, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0);
+    void patch_jump(size_t at, uint32_t target);
+    uint32_t code_position() const;
+
+    static bool is_builtin_class(common::symbol_id name);
+    static size_t field_size(const codegen::ast::class_declaration* type);
+    static std::vector<common::symbol_id> param_type_names_of(
+        const common::arena_vector<std::unique_ptr<codegen::ast::parameter_declaration>>& params);
+};
+
+} // namespace codegen::bytecode
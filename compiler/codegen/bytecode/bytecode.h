@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace codegen::bytecode {
+
+// Registers are untagged: the compiler knows the static type of every register, so Integer, Real and Boolean
+// values live in them unboxed and objects are plain pointers.
+union value {
+    int64_t integer;
+    double real;
+    std::byte* object;
+};
+static_assert(sizeof(value) == 8);
+
+enum class opcode : uint8_t {
+    load_constant,  // a = constants[b]
+    move,           // a = b
+
+    add_integer,    // a = b + c
+    sub_integer,
+    mul_integer,
+    div_integer,
+    rem_integer,
+    neg_integer,    // a = -b
+    less_integer,
+    less_equal_integer,
+    greater_integer,
+    greater_equal_integer,
+    equal_integer,
+
+    add_real,
+    sub_real,
+    mul_real,
+    div_real,
+    rem_real,
+    neg_real,
+    less_real,
+    less_equal_real,
+    greater_real,
+    greater_equal_real,
+    equal_real,
+
+    integer_to_real,     // a = real(b)
+    real_to_integer,     // a = integer(b)
+    integer_to_boolean,  // a = b != 0
+
+    not_boolean,    // a = !b
+    and_boolean,    // a = b & c
+    or_boolean,
+    xor_boolean,
+
+    jump,           // pc = a
+    jump_if_false,  // if (!a) pc = b
+
+    load_field_8,   // a = *(b + c), 8 byte field
+    load_field_1,   // a = *(b + c), 1 byte field
+    store_field_8,  // *(a + b) = c
+    store_field_1,
+
+    new_object,     // a = new classes[b]
+    copy_object,    // a = copy of b with the layout of classes[c]
+    set_vtable,     // header of a = classes[b]
+
+    new_array,      // a = ArrayInteger(b)
+    array_length,   // a = b.Len()
+    array_get,      // a = b.Get(c)
+    array_set,      // a.Set(b, c)
+
+    print_integer,  // print a
+    print_real,
+    print_boolean,
+
+    call,           // a = functions[call_sites[b].target](registers c..), the callee frame starts at c
+    call_virtual,   // a = vtable(c)[call_sites[b].slot](registers c..), through the call site's inline cache
+    ret,            // return a
+    ret_void,
+};
+
+struct instruction {
+    opcode op;
+    uint32_t a = 0;
+    uint32_t b = 0;
+    uint32_t c = 0;
+};
+
+struct function;
+
+struct runtime_class {
+    std::string name;
+    const runtime_class* base = nullptr;
+    // object size and alignment, following the struct layout llvm_codegen emits for the same class
+    size_t size = 0;
+    size_t alignment = 8;
+    // function per vtable slot, in llvm_codegen slot order
+    std::vector<const function*> vtable;
+    // the object header points at dispatch[1]: native code indexes vtable slots from there, dispatch[0] leads back to this class
+    std::vector<const void*> dispatch;
+};
+
+struct call_site {
+    uint32_t target = 0;  // function index for direct calls
+    uint32_t slot = 0;    // vtable slot for virtual calls
+    // monomorphic inline cache of the last receiver class and its implementation
+    mutable const runtime_class* cached_class = nullptr;
+    mutable const function* cached_target = nullptr;
+};
+
+using native_entry = void (*)(value* registers);
+
+struct function {
+    // matches the symbol llvm_codegen emits for the same method or constructor
+    std::string name;
+    // `this` is register 0, parameters follow
+    uint32_t parameter_count = 0;
+    uint32_t register_count = 0;
+    std::vector<instruction> code;
+    std::vector<value> constants;
+    std::vector<call_site> call_sites;
+    // tiered execution: calls and loop back edges counted so far, and the native adapter once the function got hot
+    mutable uint32_t hotness = 0;
+    mutable native_entry native = nullptr;
+};
+
+struct module {
+    std::vector<std::unique_ptr<function>> functions;
+    std::vector<std::unique_ptr<runtime_class>> classes;
+    const runtime_class* entry_class = nullptr;
+    const function* entry_constructor = nullptr;
+};
+
+} // namespace codegen::bytecode
@@ -0,0 +1,428 @@
+#include "compiler/codegen/bytecode/interpreter.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+namespace codegen::bytecode {
+
+namespace {
+
+constexpr size_t chunk_size = 64 * 1024;
+
+struct array_object {
+    int64_t* data;
+    int64_t length;
+};
+
+void check_index(const array_object* array, int64_t index) {
+    if (index < 0 || index >= array->length) {
+        throw std::runtime_error(std::format("index {} is out of bounds for an array of length {}", index, array->length));
+    }
+}
+
+} // namespace
+
+interpreter::interpreter(module& program, native_tier* tier, uint32_t tier_threshold, size_t stack_registers)
+    : program(program),
+      tier(tier),
+      tier_threshold(tier_threshold),
+      register_stack(stack_registers) {}
+
+bool interpreter::is_hot(const function& fn) {
+    if (fn.native == nullptr && ++fn.hotness == tier_threshold) {
+        fn.native = tier->compile(fn);
+    }
+    return fn.native != nullptr;
+}
+
+std::byte* interpreter::allocate(size_t size) {
+    size = (size + 7) & ~size_t{7};
+    if (size > chunk_size / 4) {
+        chunks.push_back(std::make_unique<std::byte[]>(size));
+        return chunks.back().get();
+    }
+    if (size > chunk_left) {
+        chunks.push_back(std::make_unique<std::byte[]>(chunk_size));
+        chunk_cursor = chunks.back().get();
+        chunk_left = chunk_size;
+    }
+    auto* result = chunk_cursor;
+    chunk_cursor += size;
+    chunk_left -= size;
+    return result;
+}
+
+std::byte* interpreter::new_object(const runtime_class& cls) {
+    auto* object = allocate(cls.size);
+    const void* header = cls.dispatch.data() + 1;
+    std::memcpy(object, &header, sizeof(header));
+    return object;
+}
+
+const runtime_class& interpreter::class_of(const std::byte* object) {
+    const void* const* header;
+    std::memcpy(&header, object, sizeof(header));
+    return *static_cast<const runtime_class*>(header[-1]);
+}
+
+int interpreter::run() {
+    if (program.entry_class == nullptr || program.entry_constructor == nullptr) {
+        throw std::runtime_error("entry class has no parameterless constructor");
+    }
+    auto* registers = register_stack.data();
+    registers[0].object = new_object(*program.entry_class);
+    execute(*program.entry_constructor, registers);
+    return 0;
+}
+
+// With GCC and Clang every handler jumps straight to the next one through a label table (computed goto),
+// otherwise the loop falls back to a switch.
+#if defined(__GNUC__)
+#define VM_DISPATCH() goto* labels[static_cast<size_t>(pc->op)]
+#define VM_CASE(name) op_##name:
+#define VM_LOOP VM_DISPATCH();
+#define VM_LOOP_END
+#else
+#define VM_DISPATCH() continue
+#define VM_CASE(name) case opcode::name:
+#define VM_LOOP for (;;) switch (pc->op) {
+#define VM_LOOP_END }
+#endif
+
+#define VM_NEXT() \
+    ++pc;         \
+    VM_DISPATCH()
+
+void interpreter::execute(const function& entry, value* registers) {
+#if defined(__GNUC__)
+    static void* const labels[] = {
+        &&op_load_constant, &&op_move,
+        &&op_add_integer, &&op_sub_integer, &&op_mul_integer, &&op_div_integer, &&op_rem_integer, &&op_neg_integer,
+        &&op_less_integer, &&op_less_equal_integer, &&op_greater_integer, &&op_greater_equal_integer, &&op_equal_integer,
+        &&op_add_real, &&op_sub_real, &&op_mul_real, &&op_div_real, &&op_rem_real, &&op_neg_real,
+        &&op_less_real, &&op_less_equal_real, &&op_greater_real, &&op_greater_equal_real, &&op_equal_real,
+        &&op_integer_to_real, &&op_real_to_integer, &&op_integer_to_boolean,
+        &&op_not_boolean, &&op_and_boolean, &&op_or_boolean, &&op_xor_boolean,
+        &&op_jump, &&op_jump_if_false,
+        &&op_load_field_8, &&op_load_field_1, &&op_store_field_8, &&op_store_field_1,
+        &&op_new_object, &&op_copy_object, &&op_set_vtable,
+        &&op_new_array, &&op_array_length, &&op_array_get, &&op_array_set,
+        &&op_print_integer, &&op_print_real, &&op_print_boolean,
+        &&op_call, &&op_call_virtual, &&op_ret, &&op_ret_void,
+    };
+    static_assert(std::size(labels) == static_cast<size_t>(opcode::ret_void) + 1);
+#endif
+
+    const function* fn = &entry;
+    const instruction* pc = fn->code.data();
+    value* r = registers;
+    const value* stack_end = register_stack.data() + register_stack.size();
+    if (r + fn->register_count > stack_end) {
+        throw std::runtime_error("stack overflow");
+    }
+
+    auto enter = [&](const function* target, uint32_t base, uint32_t result) {
+        if (target->code.empty()) {
+            throw std::runtime_error(std::format("method '{}' has no body", target->name));
+        }
+        if (tier != nullptr && is_hot(*target)) {
+            // the adapter reads the argument window and leaves the result in its first register
+            target->native(r + base);
+            r[result] = r[base];
+            ++pc;
+            return;
+        }
+        if (r + base + target->register_count > stack_end) {
+            throw std::runtime_error("stack overflow");
+        }
+        frames.push_back({fn, pc + 1, r, result});
+        fn = target;
+        r += base;
+        pc = fn->code.data();
+    };
+
+    VM_LOOP
+    VM_CASE(load_constant) {
+        r[pc->a] = fn->constants[pc->b];
+        VM_NEXT();
+    }
+    VM_CASE(move) {
+        r[pc->a] = r[pc->b];
+        VM_NEXT();
+    }
+
+    VM_CASE(add_integer) {
+        r[pc->a].integer = static_cast<int64_t>(static_cast<uint64_t>(r[pc->b].integer) + static_cast<uint64_t>(r[pc->c].integer));
+        VM_NEXT();
+    }
+    VM_CASE(sub_integer) {
+        r[pc->a].integer = static_cast<int64_t>(static_cast<uint64_t>(r[pc->b].integer) - static_cast<uint64_t>(r[pc->c].integer));
+        VM_NEXT();
+    }
+    VM_CASE(mul_integer) {
+        r[pc->a].integer = static_cast<int64_t>(static_cast<uint64_t>(r[pc->b].integer) * static_cast<uint64_t>(r[pc->c].integer));
+        VM_NEXT();
+    }
+    VM_CASE(div_integer) {
+        auto divisor = r[pc->c].integer;
+        if (divisor == 0 || (divisor == -1 && r[pc->b].integer == std::numeric_limits<int64_t>::min())) {
+            throw std::runtime_error("integer division overflow");
+        }
+        r[pc->a].integer = r[pc->b].integer / divisor;
+        VM_NEXT();
+    }
+    VM_CASE(rem_integer) {
+        auto divisor = r[pc->c].integer;
+        if (divisor == 0 || (divisor == -1 && r[pc->b].integer == std::numeric_limits<int64_t>::min())) {
+            throw std::runtime_error("integer division overflow");
+        }
+        r[pc->a].integer = r[pc->b].integer % divisor;
+        VM_NEXT();
+    }
+    VM_CASE(neg_integer) {
+        r[pc->a].integer = static_cast<int64_t>(0 - static_cast<uint64_t>(r[pc->b].integer));
+        VM_NEXT();
+    }
+    VM_CASE(less_integer) {
+        r[pc->a].integer = r[pc->b].integer < r[pc->c].integer;
+        VM_NEXT();
+    }
+    VM_CASE(less_equal_integer) {
+        r[pc->a].integer = r[pc->b].integer <= r[pc->c].integer;
+        VM_NEXT();
+    }
+    VM_CASE(greater_integer) {
+        r[pc->a].integer = r[pc->b].integer > r[pc->c].integer;
+        VM_NEXT();
+    }
+    VM_CASE(greater_equal_integer) {
+        r[pc->a].integer = r[pc->b].integer >= r[pc->c].integer;
+        VM_NEXT();
+    }
+    VM_CASE(equal_integer) {
+        r[pc->a].integer = r[pc->b].integer == r[pc->c].integer;
+        VM_NEXT();
+    }
+
+    VM_CASE(add_real) {
+        r[pc->a].real = r[pc->b].real + r[pc->c].real;
+        VM_NEXT();
+    }
+    VM_CASE(sub_real) {
+        r[pc->a].real = r[pc->b].real - r[pc->c].real;
+        VM_NEXT();
+    }
+    VM_CASE(mul_real) {
+        r[pc->a].real = r[pc->b].real * r[pc->c].real;
+        VM_NEXT();
+    }
+    VM_CASE(div_real) {
+        r[pc->a].real = r[pc->b].real / r[pc->c].real;
+        VM_NEXT();
+    }
+    VM_CASE(rem_real) {
+        r[pc->a].real = std::fmod(r[pc->b].real, r[pc->c].real);
+        VM_NEXT();
+    }
+    VM_CASE(neg_real) {
+        r[pc->a].real = -r[pc->b].real;
+        VM_NEXT();
+    }
+    VM_CASE(less_real) {
+        r[pc->a].integer = r[pc->b].real < r[pc->c].real;
+        VM_NEXT();
+    }
+    VM_CASE(less_equal_real) {
+        r[pc->a].integer = r[pc->b].real <= r[pc->c].real;
+        VM_NEXT();
+    }
+    VM_CASE(greater_real) {
+        r[pc->a].integer = r[pc->b].real > r[pc->c].real;
+        VM_NEXT();
+    }
+    VM_CASE(greater_equal_real) {
+        r[pc->a].integer = r[pc->b].real >= r[pc->c].real;
+        VM_NEXT();
+    }
+    VM_CASE(equal_real) {
+        r[pc->a].integer = r[pc->b].real == r[pc->c].real;
+        VM_NEXT();
+    }
+
+    VM_CASE(integer_to_real) {
+        r[pc->a].real = static_cast<double>(r[pc->b].integer);
+        VM_NEXT();
+    }
+    VM_CASE(real_to_integer) {
+        r[pc->a].integer = static_cast<int64_t>(r[pc->b].real);
+        VM_NEXT();
+    }
+    VM_CASE(integer_to_boolean) {
+        r[pc->a].integer = r[pc->b].integer != 0;
+        VM_NEXT();
+    }
+
+    VM_CASE(not_boolean) {
+        r[pc->a].integer = r[pc->b].integer ^ 1;
+        VM_NEXT();
+    }
+    VM_CASE(and_boolean) {
+        r[pc->a].integer = r[pc->b].integer & r[pc->c].integer;
+        VM_NEXT();
+    }
+    VM_CASE(or_boolean) {
+        r[pc->a].integer = r[pc->b].integer | r[pc->c].integer;
+        VM_NEXT();
+    }
+    VM_CASE(xor_boolean) {
+        r[pc->a].integer = r[pc->b].integer ^ r[pc->c].integer;
+        VM_NEXT();
+    }
+
+    VM_CASE(jump) {
+        auto* target = fn->code.data() + pc->a;
+        if (tier != nullptr && target < pc) {
+            // a back edge only makes the next call native, the running loop stays in the interpreter
+            is_hot(*fn);
+        }
+        pc = target;
+        VM_DISPATCH();
+    }
+    VM_CASE(jump_if_false) {
+        if (r[pc->a].integer == 0) {
+            pc = fn->code.data() + pc->b;
+            VM_DISPATCH();
+        }
+        VM_NEXT();
+    }
+
+    VM_CASE(load_field_8) {
+        std::memcpy(&r[pc->a], r[pc->b].object + pc->c, 8);
+        VM_NEXT();
+    }
+    VM_CASE(load_field_1) {
+        r[pc->a].integer = static_cast<int64_t>(std::to_integer<uint8_t>(r[pc->b].object[pc->c]) & 1);
+        VM_NEXT();
+    }
+    VM_CASE(store_field_8) {
+        std::memcpy(r[pc->a].object + pc->b, &r[pc->c], 8);
+        VM_NEXT();
+    }
+    VM_CASE(store_field_1) {
+        r[pc->a].object[pc->b] = static_cast<std::byte>(r[pc->c].integer & 1);
+        VM_NEXT();
+    }
+
+    VM_CASE(new_object) {
+        r[pc->a].object = new_object(*program.classes[pc->b]);
+        VM_NEXT();
+    }
+    VM_CASE(copy_object) {
+        const auto& cls = *program.classes[pc->c];
+        auto* copy = allocate(cls.size);
+        std::memcpy(copy, r[pc->b].object, cls.size);
+        r[pc->a].object = copy;
+        VM_NEXT();
+    }
+    VM_CASE(set_vtable) {
+        const void* header = program.classes[pc->b]->dispatch.data() + 1;
+        std::memcpy(r[pc->a].object, &header, sizeof(header));
+        VM_NEXT();
+    }
+
+    VM_CASE(new_array) {
+        auto length = r[pc->b].integer;
+        if (length < 0) {
+            throw std::runtime_error(std::format("negative array length {}", length));
+        }
+        auto* array = reinterpret_cast<array_object*>(allocate(sizeof(array_object)));
+        array->data = reinterpret_cast<int64_t*>(allocate(static_cast<size_t>(length) * sizeof(int64_t)));
+        array->length = length;
+        r[pc->a].object = reinterpret_cast<std::byte*>(array);
+        VM_NEXT();
+    }
+    VM_CASE(array_length) {
+        r[pc->a].integer = reinterpret_cast<array_object*>(r[pc->b].object)->length;
+        VM_NEXT();
+    }
+    VM_CASE(array_get) {
+        auto* array = reinterpret_cast<array_object*>(r[pc->b].object);
+        auto index = r[pc->c].integer;
+        check_index(array, index);
+        r[pc->a].integer = array->data[index];
+        VM_NEXT();
+    }
+    VM_CASE(array_set) {
+        auto* array = reinterpret_cast<array_object*>(r[pc->a].object);
+        auto index = r[pc->b].integer;
+        check_index(array, index);
+        array->data[index] = r[pc->c].integer;
+        VM_NEXT();
+    }
+
+    VM_CASE(print_integer) {
+        std::printf("%lld\n", static_cast<long long>(r[pc->a].integer));
+        VM_NEXT();
+    }
+    VM_CASE(print_real) {
+        std::printf("%f\n", r[pc->a].real);
+        VM_NEXT();
+    }
+    VM_CASE(print_boolean) {
+        std::printf("%d\n", static_cast<int>(r[pc->a].integer));
+        VM_NEXT();
+    }
+
+    VM_CASE(call) {
+        enter(program.functions[fn->call_sites[pc->b].target].get(), pc->c, pc->a);
+        VM_DISPATCH();
+    }
+    VM_CASE(call_virtual) {
+        const auto& site = fn->call_sites[pc->b];
+        const auto& cls = class_of(r[pc->c].object);
+        if (site.cached_class != &cls) {
+            site.cached_class = &cls;
+            site.cached_target = cls.vtable[site.slot];
+        }
+        enter(site.cached_target, pc->c, pc->a);
+        VM_DISPATCH();
+    }
+    VM_CASE(ret) {
+        if (frames.empty()) {
+            return;
+        }
+        auto result = r[pc->a];
+        auto caller = frames.back();
+        frames.pop_back();
+        fn = caller.fn;
+        pc = caller.return_pc;
+        r = caller.registers;
+        r[caller.result_register] = result;
+        VM_DISPATCH();
+    }
+    VM_CASE(ret_void) {
+        if (frames.empty()) {
+            return;
+        }
+        auto caller = frames.back();
+        frames.pop_back();
+        fn = caller.fn;
+        pc = caller.return_pc;
+        r = caller.registers;
+        VM_DISPATCH();
+    }
+    VM_LOOP_END
+}
+
+#undef VM_NEXT
+#undef VM_LOOP_END
+#undef VM_LOOP
+#undef VM_CASE
+#undef VM_DISPATCH
+
+} // namespace codegen::bytecode
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "compiler/codegen/bytecode/bytecode.h"
+
+namespace codegen::bytecode {
+
+// compiles hot functions for tiered execution, nullptr keeps the function in the interpreter
+class native_tier {
+public:
+    virtual ~native_tier() = default;
+    virtual native_entry compile(const function& fn) = 0;
+};
+
+class interpreter {
+public:
+    explicit interpreter(module& program, native_tier* tier = nullptr, uint32_t tier_threshold = 0, size_t stack_registers = 1 << 20);
+
+    // constructs the entry class and returns the process exit code
+    int run();
+
+private:
+    struct frame {
+        const function* fn;
+        const instruction* return_pc;
+        value* registers;
+        uint32_t result_register;
+    };
+
+    module& program;
+    native_tier* tier;
+    uint32_t tier_threshold;
+    std::vector<value> register_stack;
+    std::vector<frame> frames;
+
+    // objects live until the interpreter is destroyed, there is no collector
+    std::vector<std::unique_ptr<std::byte[]>> chunks;
+    std::byte* chunk_cursor = nullptr;
+    size_t chunk_left = 0;
+
+    std::byte* allocate(size_t size);
+    std::byte* new_object(const runtime_class& cls);
+    void execute(const function& entry, value* registers);
+    bool is_hot(const function& fn);
+
+    static const runtime_class& class_of(const std::byte* object);
+};
+
+} // namespace codegen::bytecode
@@ -1,9 +1,13 @@
 #include "compiler/codegen/llvm/llvm-codegen.h"
 
+#include <algorithm>
+#include <span>
+#include <tuple>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
+#include <llvm/CodeGen/ParallelCG.h>
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/DerivedTypes.h>
 #include <llvm/IR/Function.h>
@@ -11,21 +15,29 @@
 #include <llvm/IR/Type.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/MC/TargetRegistry.h>
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/Passes/PassBuilder.h>
 #include <llvm/Support/CodeGen.h>
 #include <llvm/Support/FileSystem.h>
+#include <llvm/Support/PGOOptions.h>
+#include <llvm/Support/Program.h>
 #include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/VirtualFileSystem.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Target/TargetOptions.h>
 #include <llvm/TargetParser/Host.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/ValueMapper.h>
 
-#include "compiler/common/variant-helper.h"
 #include "compiler/compilation-structures/type-table.h"
 
 namespace {
 
+namespace well_known = common::well_known;
+
 bool is_value_type(codegen::ast::class_declaration * decl) {
     while (decl != nullptr) {
-        if (decl->name == "AnyValue") {
+        if (decl->name == well_known::any_value) {
             return true;
         }
         decl = decl->base_class;
@@ -33,44 +45,54 @@ bool is_value_type(codegen::ast::class_declaration * decl) {
     return false;
 }
 
-codegen::ast::class_declaration * expression_type(codegen::ast::expression * expr) {
-    if (auto literal = dynamic_cast<codegen::ast::literal_expression *>(expr)) {
-        return literal->type;
-    } else if (auto this_expr = dynamic_cast<codegen::ast::this_expression *>(expr)) {
-        return this_expr->type;
-    } else if (auto ident = dynamic_cast<codegen::ast::identifier_expression *>(expr)) {
-        return std::visit(overloaded{
-                       [](codegen::ast::variable_declaration* d) -> auto * { return d->type; },
-                       [](codegen::ast::parameter_declaration* d) -> auto * { return d->type; },
-                       [](codegen::ast::field_declaration* d) -> auto * { return d->type; }},
-                   ident->target);
-    } else if (auto method_call = dynamic_cast<codegen::ast::method_call_expression *>(expr)) {
-        return method_call->return_type;
-    } else if (auto ctor_call = dynamic_cast<codegen::ast::constructor_call_expression *>(expr)) {
-        return ctor_call->constructor->class_owner;
-    } else if (auto member = dynamic_cast<codegen::ast::member_expression *>(expr)) {
-        return member->member->type;
-    } else if (auto group = dynamic_cast<codegen::ast::grouping_expression *>(expr)) {
-        return expression_type(group->inner.get());
-    }
-    assert(false);
-    return nullptr;
+std::unique_ptr<::llvm::TargetMachine> create_target_machine(const std::string& triple) {
+    std::string err;
+    const auto* target = ::llvm::TargetRegistry::lookupTarget(triple, err);
+    if (!target) {
+        throw std::runtime_error("failed to lookup target: " + err);
+    }
+    ::llvm::TargetOptions opt;
+    return std::unique_ptr<::llvm::TargetMachine>(target->createTargetMachine(triple, "generic", "", opt, std::nullopt));
+}
+
+// the partition objects of a split emission, removed on every way out of write_split_object_file
+struct part_files {
+    std::vector<std::string> paths;
+
+    ~part_files() {
+        for (const auto& part : paths) {
+            ::llvm::sys::fs::remove(part);
+        }
+    }
+};
+
+bool is_this_expression(const codegen::ast::flat::program& program, codegen::ast::flat::node_index expr) {
+    while (program.kinds[expr] == codegen::ast::node_kind::grouping_expression) {
+        expr = program.lhs[expr];
+    }
+    return program.kinds[expr] == codegen::ast::node_kind::this_expression;
 }
 
 }
 
 namespace codegen::llvm_ir {
 
-bool llvm_codegen::is_builtin_class(const std::string& name) {
-    return name == "Class" || name == "AnyValue" || name == "AnyRef"
-        || name == "Integer" || name == "Real" || name == "Boolean" || name == "Unit"
-        || name == "ArrayInteger" || name == "IO";
+bool llvm_codegen::is_builtin_class(common::symbol_id name) {
+    using namespace common::well_known;
+    static const common::symbol_id builtin_names[] = {class_, any_value, any_ref, integer, real, boolean, unit, array_integer, io};
+    return std::ranges::find(builtin_names, name) != std::end(builtin_names);
 }
 
-llvm_codegen::llvm_codegen(const std::string& module_name, std::string entry_class_name)
-    : module(std::make_unique<::llvm::Module>(module_name, context)),
+llvm_codegen::llvm_codegen(const std::string& module_name,
+                           std::string_view entry_class_name,
+                           codegen_options options,
+                           ::llvm::LLVMContext* shared_context)
+    : context_owner(shared_context ? nullptr : std::make_unique<::llvm::LLVMContext>()),
+      context(shared_context ? *shared_context : *context_owner),
+      module(std::make_unique<::llvm::Module>(module_name, context)),
       builder(context),
-      entry_class_name(std::move(entry_class_name)) {
+      entry_class_name(entry_class_name),
+      options(std::move(options)) {
     // this ctor body only for setting default layout for target platform
     ::llvm::InitializeNativeTarget();
     ::llvm::InitializeNativeTargetAsmPrinter();
@@ -79,18 +101,129 @@ llvm_codegen::llvm_codegen(const std::string& module_name, std::string entry_cla
     auto triple = ::llvm::sys::getDefaultTargetTriple();
     module->setTargetTriple(triple);
 
-    std::string err;
-    const auto* target = ::llvm::TargetRegistry::lookupTarget(triple, err);
-    if (!target) {
-        throw std::runtime_error("failed to lookup target: " + err);
-    }
-    ::llvm::TargetOptions opt;
-    target_machine.reset(target->createTargetMachine(triple, "generic", "", opt, std::nullopt));
+    target_machine = create_target_machine(triple);
     module->setDataLayout(target_machine->createDataLayout());
 }
 
-void llvm_codegen::emit(codegen::ast::program& program) {
-    program.accept(*this);
+void llvm_codegen::emit(const codegen::ast::flat::program& program) {
+    declare(program);
+    auto user_classes = std::span{program.classes}.subspan(program.internal_class_count);
+
+    for (const auto& cls : user_classes) {
+        for (uint32_t i = 0; i < cls.declaration->methods.size(); ++i) {
+            emit_method_body(cls.first_method + i, method_functions.at(cls.declaration->methods[i].get()));
+        }
+        for (uint32_t i = 0; i < cls.declaration->constructors.size(); ++i) {
+            emit_constructor_body(cls.first_constructor + i);
+        }
+    }
+    if (options.customize_budget > 0 && !options.external_vtables) {
+        emit_customized_methods();
+    }
+    if (options.interpreter_adapters) {
+        for (const auto& cls : user_classes) {
+            for (auto& method : cls.declaration->methods) {
+                emit_interpreter_adapter(method_functions.at(method.get()));
+            }
+            for (auto& ctor : cls.declaration->constructors) {
+                emit_interpreter_adapter(constructor_functions.at(ctor.get()));
+            }
+        }
+    }
+
+    emit_main();
+    flat_program = nullptr;
+}
+
+void llvm_codegen::declare(const codegen::ast::flat::program& program) {
+    flat_program = &program;
+    variable_slots.assign(program.variables.size(), nullptr);
+    parameter_slots.assign(program.parameters.size(), nullptr);
+    auto user_classes = std::span{program.classes}.subspan(program.internal_class_count);
+
+    for (const auto& cls : std::span{program.classes}.first(program.internal_class_count)) {
+        declare_internal_class_type(*cls.declaration);
+    }
+    for (const auto& cls : user_classes) {
+        declare_class_type(*cls.declaration);
+    }
+    for (const auto& cls : user_classes) {
+        define_class_layout(*cls.declaration);
+    }
+
+    for (const auto& cls : user_classes) {
+        for (uint32_t i = 0; i < cls.declaration->methods.size(); ++i) {
+            declare_method(*cls.declaration->methods[i]);
+            function_bodies[method_functions.at(cls.declaration->methods[i].get())] = {false, cls.first_method + i};
+        }
+        for (uint32_t i = 0; i < cls.declaration->constructors.size(); ++i) {
+            declare_constructor(*cls.declaration->constructors[i]);
+            function_bodies[constructor_functions.at(cls.declaration->constructors[i].get())] = {true, cls.first_constructor + i};
+        }
+    }
+
+    for (const auto& cls : user_classes) {
+        if (cls.declaration->base_class && !is_builtin_class(cls.declaration->base_class->name)) {
+            direct_subclasses[cls.declaration->base_class].push_back(cls.declaration);
+        }
+        build_vtable_for(*cls.declaration);
+    }
+    for (const auto& cls : user_classes) {
+        emit_vtable_global(*cls.declaration);
+    }
+}
+
+std::vector<std::string> llvm_codegen::function_names() const {
+    std::vector<std::string> names;
+    names.reserve(function_bodies.size());
+    for (const auto& [fn, body] : function_bodies) {
+        names.push_back(fn->getName().str());
+    }
+    return names;
+}
+
+std::unique_ptr<::llvm::Module> llvm_codegen::emit_function(const std::string& name) {
+    auto* fn = module->getFunction(name);
+    auto body = function_bodies.at(fn);
+    if (body.constructor) {
+        emit_constructor_body(body.index);
+    } else {
+        emit_method_body(body.index, fn);
+    }
+    auto* adapter = options.interpreter_adapters ? emit_interpreter_adapter(fn) : nullptr;
+    // customization never sees these bodies
+    resolved_calls.clear();
+
+    // everything defined at this point is the new body, its adapter, their constants and the array helpers; the rest
+    // of the program goes over as declarations, and what the body doesn't refer to is dropped again
+    ::llvm::ValueToValueMapTy values;
+    auto part = ::llvm::CloneModule(*module, values, [](const ::llvm::GlobalValue* gv) { return !gv->isDeclaration(); });
+    for (auto& f : ::llvm::make_early_inc_range(part->functions())) {
+        if (f.getName() == name || (adapter != nullptr && f.getName() == adapter->getName())) {
+            continue;
+        }
+        if (f.use_empty()) {
+            f.eraseFromParent();
+        } else if (!f.isDeclaration()) {
+            f.setLinkage(::llvm::GlobalValue::InternalLinkage);
+        }
+    }
+    for (auto& gv : ::llvm::make_early_inc_range(part->globals())) {
+        if (gv.use_empty()) {
+            gv.eraseFromParent();
+        }
+    }
+
+    fn->deleteBody();
+    if (adapter != nullptr) {
+        adapter->eraseFromParent();
+    }
+    for (auto& gv : ::llvm::make_early_inc_range(module->globals())) {
+        if (gv.hasLocalLinkage() && gv.use_empty()) {
+            gv.eraseFromParent();
+        }
+    }
+    return part;
 }
 
 std::string llvm_codegen::ir_to_string() const {
@@ -110,10 +243,54 @@ bool llvm_codegen::write_ir_file(const std::string& path) const {
     return true;
 }
 
+std::pair<std::unique_ptr<::llvm::LLVMContext>, std::unique_ptr<::llvm::Module>> llvm_codegen::release_module() && {
+    run_optimization_pipeline();
+    return {std::move(context_owner), std::move(module)};
+}
+
+void llvm_codegen::run_optimization_pipeline() {
+    std::optional<::llvm::PGOOptions> pgo;
+    if (options.profile_generate.has_value()) {
+        // edge counters plus indirect-call target value profiling, flushed to *options.profile_generate by the profile runtime
+        pgo = ::llvm::PGOOptions(*options.profile_generate, "", "", "", ::llvm::vfs::getRealFileSystem(), ::llvm::PGOOptions::IRInstr);
+    } else if (options.profile_use.has_value()) {
+        // branch weights, function entry counts and value profiles feed inlining, block placement and indirect call promotion
+        pgo = ::llvm::PGOOptions(*options.profile_use, "", "", "", ::llvm::vfs::getRealFileSystem(), ::llvm::PGOOptions::IRUse);
+    } else {
+        return;
+    }
+
+    ::llvm::LoopAnalysisManager lam;
+    ::llvm::FunctionAnalysisManager fam;
+    ::llvm::CGSCCAnalysisManager cgam;
+    ::llvm::ModuleAnalysisManager mam;
+
+    ::llvm::PassBuilder pb(target_machine.get(), ::llvm::PipelineTuningOptions(), pgo);
+    pb.registerModuleAnalyses(mam);
+    pb.registerCGSCCAnalyses(cgam);
+    pb.registerFunctionAnalyses(fam);
+    pb.registerLoopAnalyses(lam);
+    pb.crossRegisterProxies(lam, fam, cgam, mam);
+
+    auto mpm = pb.buildPerModuleDefaultPipeline(::llvm::OptimizationLevel::O2);
+    mpm.run(*module, mam);
+}
+
 bool llvm_codegen::write_object_file(const std::string& path) {
     if (!target_machine) {
         return false;
     }
+    run_optimization_pipeline();
+    if (options.codegen_threads > 1) {
+        // the parts are merged with ld -r; without it the object is emitted on one thread
+        if (auto linker = ::llvm::sys::findProgramByName("ld")) {
+            return write_split_object_file(path, *linker);
+        }
+    }
+    return write_single_object_file(path);
+}
+
+bool llvm_codegen::write_single_object_file(const std::string& path) {
     std::error_code ec;
     ::llvm::raw_fd_ostream out(path, ec, ::llvm::sys::fs::OF_None);
     if (ec) {
@@ -128,6 +305,32 @@ bool llvm_codegen::write_object_file(const std::string& path) {
     return true;
 }
 
+bool llvm_codegen::write_split_object_file(const std::string& path, const std::string& linker) {
+    // declared before the streams, so they are closed before the files are removed
+    part_files files;
+    std::vector<std::unique_ptr<::llvm::raw_fd_ostream>> parts;
+    std::vector<::llvm::raw_pwrite_stream*> part_streams;
+    for (size_t i = 0; i < options.codegen_threads; ++i) {
+        files.paths.push_back(path + ".part" + std::to_string(i));
+        std::error_code ec;
+        parts.push_back(std::make_unique<::llvm::raw_fd_ostream>(files.paths.back(), ec, ::llvm::sys::fs::OF_None));
+        if (ec) {
+            return false;
+        }
+        part_streams.push_back(parts.back().get());
+    }
+
+    // every partition is cloned into its own LLVMContext and compiled on its own thread, with its own target machine
+    auto triple = module->getTargetTriple();
+    ::llvm::splitCodeGen(*module, part_streams, {}, [&triple] { return create_target_machine(triple); },
+                         ::llvm::CodeGenFileType::ObjectFile);
+    parts.clear();
+
+    std::vector<::llvm::StringRef> args{linker, "-r", "-o", path};
+    args.insert(args.end(), files.paths.begin(), files.paths.end());
+    return ::llvm::sys::ExecuteAndWait(linker, args) == 0;
+}
+
 ::llvm::Type* llvm_codegen::map_type(const codegen::ast::class_declaration* type) {
     if (!type) {
         return ::llvm::Type::getVoidTy(context);
@@ -145,30 +348,30 @@ bool llvm_codegen::write_object_file(const std::string& path) {
 
 ::llvm::Type* llvm_codegen::declare_internal_class_type(codegen::ast::class_declaration& cls) {
     ::llvm::Type* st;
-    if (cls.name == "Integer") {
+    if (cls.name == well_known::integer) {
         st = ::llvm::Type::getInt64Ty(context);
         internal_value_class_types[cls.name] = st;
-    } else if (cls.name == "Real") {
+    } else if (cls.name == well_known::real) {
         st = ::llvm::Type::getDoubleTy(context);
         internal_value_class_types[cls.name] = st;
-    } else if (cls.name == "Boolean") {
+    } else if (cls.name == well_known::boolean) {
         st = ::llvm::Type::getInt1Ty(context);
         internal_value_class_types[cls.name] = st;
-    } else if (cls.name == "Unit") {
+    } else if (cls.name == well_known::unit) {
         st = ::llvm::Type::getInt1Ty(context);
         internal_value_class_types[cls.name] = st;
-    } else if (cls.name == "IO") {
+    } else if (cls.name == well_known::io) {
         st = ::llvm::Type::getInt1Ty(context);
         internal_value_class_types[cls.name] = st;
-    } else if (cls.name == "ArrayInteger") {
-        auto* array_t = ::llvm::StructType::create(context, "class." + cls.name);
+    } else if (cls.name == well_known::array_integer) {
+        auto* array_t = ::llvm::StructType::create(context, "class." + cls.name.str());
         auto* ptr_ty = ::llvm::PointerType::get(context, 0);
         std::vector<::llvm::Type*> field_types{ptr_ty, ::llvm::Type::getInt64Ty(context)};
         array_t->setBody(field_types, false);
         st = array_t;
         internal_ref_class_types[cls.name] = st;
     } else {
-        st = ::llvm::StructType::create(context, "class." + cls.name);
+        st = ::llvm::StructType::create(context, "class." + cls.name.str());
         internal_value_class_types[cls.name] = st;
     }
     return st;
@@ -178,7 +381,7 @@ bool llvm_codegen::write_object_file(const std::string& path) {
     if (auto it = class_types.find(&cls); it != class_types.end()) {
         return it->second;
     }
-    auto* st = ::llvm::StructType::create(context, "class." + cls.name);
+    auto* st = ::llvm::StructType::create(context, "class." + cls.name.str());
     class_types[&cls] = st;
     return st;
 }
@@ -206,21 +409,21 @@ void llvm_codegen::define_class_layout(codegen::ast::class_declaration& cls) {
 }
 
 std::string llvm_codegen::param_type_name(const codegen::ast::class_declaration* type) {
-    return type ? type->name : "void";
+    return type ? type->name.str() : "void";
 }
 
-std::vector<std::string> llvm_codegen::param_type_names_of(
-    const std::vector<std::unique_ptr<codegen::ast::parameter_declaration>>& params) {
-    std::vector<std::string> names;
+std::vector<common::symbol_id> llvm_codegen::param_type_names_of(
+    const common::arena_vector<std::unique_ptr<codegen::ast::parameter_declaration>>& params) {
+    std::vector<common::symbol_id> names;
     names.reserve(params.size());
     for (auto& p : params) {
-        names.push_back(param_type_name(p->type));
+        names.push_back(p->type ? p->type->name : common::symbol_id{"void"});
     }
     return names;
 }
 
 std::string llvm_codegen::mangle_method(const codegen::ast::method_declaration& method) {
-    std::string out = method.class_owner->name + "_" + method.name;
+    std::string out = method.class_owner->name.str() + "_" + method.name.str();
     for (auto& p : method.parameters) {
         out += "_" + param_type_name(p->type);
     }
@@ -228,7 +431,7 @@ std::string llvm_codegen::mangle_method(const codegen::ast::method_declaration&
 }
 
 std::string llvm_codegen::mangle_constructor(const codegen::ast::constructor_declaration& ctor) {
-    std::string out = ctor.class_owner->name + "_ctor";
+    std::string out = ctor.class_owner->name.str() + "_ctor";
     for (auto& p : ctor.parameters) {
         out += "_" + param_type_name(p->type);
     }
@@ -247,7 +450,7 @@ void llvm_codegen::declare_method(codegen::ast::method_declaration& method) {
     fn->arg_begin()->setName("this");
     auto arg_it = std::next(fn->arg_begin());
     for (auto& p : method.parameters) {
-        arg_it->setName(p->name);
+        arg_it->setName(p->name.str());
         ++arg_it;
     }
     method_functions[&method] = fn;
@@ -265,7 +468,7 @@ void llvm_codegen::declare_constructor(codegen::ast::constructor_declaration& ct
     fn->arg_begin()->setName("this");
     auto arg_it = std::next(fn->arg_begin());
     for (auto& p : ctor.parameters) {
-        arg_it->setName(p->name);
+        arg_it->setName(p->name.str());
         ++arg_it;
     }
     constructor_functions[&ctor] = fn;
@@ -286,23 +489,21 @@ void llvm_codegen::build_vtable_for(codegen::ast::class_declaration& cls) {
         bool overridden = false;
         for (auto& e : entries) {
             if (e.name == m->name && e.param_type_names == params) {
+                e.method = m.get();
                 e.function = fn;
                 overridden = true;
                 break;
             }
         }
         if (!overridden) {
-            entries.push_back({m->name, std::move(params), fn});
+            entries.push_back({m->name, std::move(params), m.get(), fn});
         }
     }
     vtable_entries[&cls] = std::move(entries);
 }
 
-void llvm_codegen::emit_vtable_global(codegen::ast::class_declaration& cls) {
+::llvm::Constant* llvm_codegen::vtable_initializer(const codegen::ast::class_declaration& cls) {
     const auto& entries = vtable_entries.at(&cls);
-    if (entries.empty()) {
-        return;
-    }
     auto* ptr_ty = ::llvm::PointerType::get(context, 0);
     auto* arr_ty = ::llvm::ArrayType::get(ptr_ty, entries.size());
     std::vector<::llvm::Constant*> elements;
@@ -310,9 +511,21 @@ void llvm_codegen::emit_vtable_global(codegen::ast::class_declaration& cls) {
     for (auto& e : entries) {
         elements.push_back(e.function);
     }
-    auto* init = ::llvm::ConstantArray::get(arr_ty, elements);
+    return ::llvm::ConstantArray::get(arr_ty, elements);
+}
+
+void llvm_codegen::emit_vtable_global(codegen::ast::class_declaration& cls) {
+    if (vtable_entries.at(&cls).empty()) {
+        return;
+    }
+    auto* init = vtable_initializer(cls);
+    if (options.external_vtables) {
+        vtable_globals[&cls] = new ::llvm::GlobalVariable(
+            *module, init->getType(), true, ::llvm::GlobalValue::ExternalLinkage, nullptr, "vtable." + cls.name.str());
+        return;
+    }
     auto* gv = new ::llvm::GlobalVariable(
-        *module, arr_ty, true, ::llvm::GlobalValue::PrivateLinkage, init, "vtable." + cls.name);
+        *module, init->getType(), true, ::llvm::GlobalValue::PrivateLinkage, init, "vtable." + cls.name.str());
     vtable_globals[&cls] = gv;
 }
 
@@ -327,6 +540,137 @@ int llvm_codegen::method_vtable_slot(const codegen::ast::method_declaration& met
     return -1;
 }
 
+std::vector<codegen::ast::class_declaration*> llvm_codegen::receiver_classes(codegen::ast::class_declaration* static_class) const {
+    // the whole program is known here, so the static class and its subclasses are every possible receiver
+    std::vector<codegen::ast::class_declaration*> result{static_class};
+    for (size_t pos = 0; pos < result.size(); ++pos) {
+        if (auto it = direct_subclasses.find(result[pos]); it != direct_subclasses.end()) {
+            result.insert(result.end(), it->second.begin(), it->second.end());
+        }
+    }
+    return result;
+}
+
+::llvm::Value* llvm_codegen::emit_virtual_call(codegen::ast::flat::node_index call, const std::vector<::llvm::Value*>& call_args) {
+    const auto& program = *flat_program;
+    auto* method = program.methods[program.extra[program.rhs[call]]].declaration;
+    auto object = program.lhs[call];
+    auto* fn_type = method_functions.at(method)->getFunctionType();
+    int slot = method_vtable_slot(*method);
+
+    bool self_send = is_this_expression(program, object);
+    if (self_send && customized_class != nullptr) {
+        // inside a customized clone the receiver class of `this` is exact
+        return builder.CreateCall(fn_type, vtable_entries.at(customized_class)[slot].function, call_args);
+    }
+
+    auto* static_class = program.type(object);
+    if (static_class == nullptr || !vtable_entries.contains(static_class)) {
+        static_class = method->class_owner;
+    }
+
+    std::vector<std::pair<codegen::ast::class_declaration*, ::llvm::Function*>> candidates;
+    std::vector<::llvm::Function*> targets;
+    for (auto* cls : receiver_classes(static_class)) {
+        auto* target = vtable_entries.at(cls)[slot].function;
+        candidates.emplace_back(cls, target);
+        if (std::ranges::find(targets, target) == targets.end()) {
+            targets.push_back(target);
+        }
+    }
+
+    // class hierarchy analysis: every receiver shares one implementation
+    if (targets.size() == 1) {
+        auto* direct_call = builder.CreateCall(fn_type, targets.front(), call_args);
+        if (options.customize_budget > 0) {
+            resolved_calls.emplace_back(direct_call, static_class, slot);
+        }
+        return direct_call;
+    }
+    if (self_send) {
+        self_dispatching_functions.insert(current_function);
+    }
+
+    auto* ptr_ty = ::llvm::PointerType::get(context, 0);
+    auto* vtable = builder.CreateLoad(ptr_ty, call_args.front(), "vtable");
+
+    auto emit_indirect_call = [&]() -> ::llvm::Value* {
+        auto* slot_ptr = builder.CreateInBoundsGEP(ptr_ty, vtable, ::llvm::ConstantInt::get(::llvm::Type::getInt32Ty(context), slot), "vslot");
+        auto* fn_ptr = builder.CreateLoad(ptr_ty, slot_ptr, "vfn");
+        return builder.CreateCall(fn_type, fn_ptr, call_args);
+    };
+
+    // a small closed hierarchy is dispatched exhaustively: the most common implementation becomes the default case
+    // and only receivers overriding it are tested, so no indirect call remains
+    bool exhaustive = candidates.size() <= options.type_switch_threshold;
+    ::llvm::Function* default_target = nullptr;
+    if (exhaustive) {
+        size_t best_count = 0;
+        for (auto* target : targets) {
+            auto count = static_cast<size_t>(std::ranges::count(candidates, target, &std::pair<codegen::ast::class_declaration*, ::llvm::Function*>::second));
+            if (count > best_count) {
+                best_count = count;
+                default_target = target;
+            }
+        }
+        std::erase_if(candidates, [&](const auto& candidate) { return candidate.second == default_target; });
+    }
+
+    // static heuristic: the declared receiver class is the most likely one, then its subclasses in declaration order
+    size_t guards = exhaustive ? candidates.size() : std::min(options.max_devirt_guards, candidates.size());
+    if (guards == 0) {
+        return emit_indirect_call();
+    }
+
+    auto* merge_block = ::llvm::BasicBlock::Create(context, "devirt.end", current_function);
+    std::vector<std::pair<::llvm::Value*, ::llvm::BasicBlock*>> results;
+    std::vector<std::pair<::llvm::Function*, ::llvm::BasicBlock*>> direct_blocks;
+    auto direct_block_for = [&](::llvm::Function* target) {
+        auto it = std::ranges::find(direct_blocks, target, &std::pair<::llvm::Function*, ::llvm::BasicBlock*>::first);
+        if (it == direct_blocks.end()) {
+            direct_blocks.emplace_back(target, ::llvm::BasicBlock::Create(context, "devirt.direct", current_function, merge_block));
+            it = std::prev(direct_blocks.end());
+        }
+        return it->second;
+    };
+
+    for (size_t pos = 0; pos < guards; ++pos) {
+        auto [cls, target] = candidates[pos];
+        auto* matches = builder.CreateICmpEQ(vtable, vtable_globals.at(cls), "devirt.guard." + cls->name.str());
+        auto* match_block = direct_block_for(target);
+        if (exhaustive && pos + 1 == guards) {
+            builder.CreateCondBr(matches, match_block, direct_block_for(default_target));
+            break;
+        }
+        auto* next_block = ::llvm::BasicBlock::Create(context, "devirt.next", current_function, merge_block);
+        builder.CreateCondBr(matches, match_block, next_block);
+        builder.SetInsertPoint(next_block);
+    }
+
+    if (!exhaustive) {
+        auto* fallback_value = emit_indirect_call();
+        results.emplace_back(fallback_value, builder.GetInsertBlock());
+        builder.CreateBr(merge_block);
+    }
+
+    for (auto [target, block] : direct_blocks) {
+        builder.SetInsertPoint(block);
+        auto* value = builder.CreateCall(fn_type, target, call_args);
+        results.emplace_back(value, block);
+        builder.CreateBr(merge_block);
+    }
+
+    builder.SetInsertPoint(merge_block);
+    if (fn_type->getReturnType()->isVoidTy()) {
+        return nullptr;
+    }
+    auto* phi = builder.CreatePHI(fn_type->getReturnType(), results.size(), "devirt.result");
+    for (auto [value, block] : results) {
+        phi->addIncoming(value, block);
+    }
+    return phi;
+}
+
 ::llvm::AllocaInst* llvm_codegen::create_entry_alloca(::llvm::Type* type, const std::string& name) {
     auto& entry = current_function->getEntryBlock();
     ::llvm::IRBuilder<> tmp_builder(&entry, entry.begin());
@@ -346,7 +690,7 @@ int llvm_codegen::field_index(const codegen::ast::field_declaration& field) cons
 
 ::llvm::Value* llvm_codegen::emit_field_address(::llvm::Value* object, const codegen::ast::field_declaration& field) {
     auto* owner_struct = class_types.at(field.class_owner);
-    return builder.CreateStructGEP(owner_struct, object, field_index(field), "field." + field.name);
+    return builder.CreateStructGEP(owner_struct, object, field_index(field), "field." + field.name.str());
 }
 
 ::llvm::Function* llvm_codegen::get_or_declare_printf() {
@@ -391,7 +735,7 @@ int llvm_codegen::field_index(const codegen::ast::field_declaration& field) cons
     auto *array = fn->getArg(0);
     auto *index = fn->getArg(1);
 
-    auto *array_type = internal_ref_class_types["ArrayInteger"];
+    auto *array_type = internal_ref_class_types[well_known::array_integer];
 
     auto *len_ptr = builder.CreateStructGEP(array_type, array, 1, "len.ptr");
     auto *len = builder.CreateLoad(i64, len_ptr, "len");
@@ -428,7 +772,7 @@ int llvm_codegen::field_index(const codegen::ast::field_declaration& field) cons
     auto saved_ip = builder.GetInsertPoint();
 
     auto *i64 = ::llvm::Type::getInt64Ty(context);
-    auto *unit_t = internal_value_class_types["Unit"];
+    auto *unit_t = internal_value_class_types[well_known::unit];
     auto *ptr_ty = ::llvm::PointerType::get(context, 0);
     auto *fn_type = ::llvm::FunctionType::get(unit_t, {ptr_ty, i64, i64}, false);
     auto *fn = ::llvm::Function::Create(fn_type, ::llvm::Function::ExternalLinkage, "ArrayInteger_Set", module.get());
@@ -447,7 +791,7 @@ int llvm_codegen::field_index(const codegen::ast::field_declaration& field) cons
     auto *index = fn->getArg(1);
     auto *value = fn->getArg(2);
 
-    auto *array_type = internal_ref_class_types["ArrayInteger"];
+    auto *array_type = internal_ref_class_types[well_known::array_integer];
 
     auto *len_ptr = builder.CreateStructGEP(array_type, array, 1, "len.ptr");
     auto *len = builder.CreateLoad(i64, len_ptr, "len");
@@ -485,58 +829,49 @@ int llvm_codegen::field_index(const codegen::ast::field_declaration& field) cons
     return obj;
 }
 
-::llvm::Value* llvm_codegen::eval(codegen::ast::expression& expr) {
-    current_value = nullptr;
-    expr.accept(*this);
-    return current_value;
-}
-
-::llvm::Value* llvm_codegen::eval_value_or_ref(codegen::ast::expression& expr) {
-    current_value = nullptr;
-    expr.accept(*this);
-    if (auto * type = expression_type(&expr); !is_builtin_class(type->name) && is_value_type(type)) {
+::llvm::Value* llvm_codegen::eval_value_or_ref(codegen::ast::flat::node_index expr) {
+    auto* value = eval(expr);
+    if (auto * type = flat_program->type(expr); !is_builtin_class(type->name) && is_value_type(type)) {
         auto it = class_types.find(type); // not map_type to get real non-pointer type
         assert(it != class_types.end());
-        auto *copy = copy_value_on_heap(current_value, it->second);
+        auto *copy = copy_value_on_heap(value, it->second);
         return copy;
     } else {
-        return current_value;
+        return value;
     }
 }
 
-void llvm_codegen::emit_method_body(codegen::ast::method_declaration& method) {
-    if (!method.body.has_value()) {
+void llvm_codegen::emit_method_body(uint32_t method, ::llvm::Function* fn) {
+    const auto& entry = flat_program->methods[method];
+    if (entry.body == codegen::ast::flat::none) {
         return;
     }
-    auto* fn = method_functions.at(&method);
-    auto* entry = ::llvm::BasicBlock::Create(context, "entry", fn);
-    builder.SetInsertPoint(entry);
+    auto* bb = ::llvm::BasicBlock::Create(context, "entry", fn);
+    builder.SetInsertPoint(bb);
 
     current_function = fn;
     current_this = fn->getArg(0);
-    parameter_slots.clear();
-    variable_slots.clear();
 
     auto arg_it = std::next(fn->arg_begin());
-    for (auto& p : method.parameters) {
-        auto* slot = create_entry_alloca(map_type(p->type), p->name);
+    for (size_t i = 0; i < entry.declaration->parameters.size(); ++i) {
+        auto& p = entry.declaration->parameters[i];
+        auto* slot = create_entry_alloca(map_type(p->type), p->name.str());
         builder.CreateStore(&*arg_it, slot);
-        parameter_slots[p.get()] = slot;
+        parameter_slots[entry.first_parameter + i] = slot;
         ++arg_it;
     }
 
     auto* ret_ty = current_function->getReturnType();
-    std::visit(overloaded{
-                   [this](std::unique_ptr<codegen::ast::block>& b) { b->accept(*this); },
-                   [this, ret_ty](std::unique_ptr<codegen::ast::expression>& e) {
-                       auto* value = eval(*e);
-                       if (ret_ty->isVoidTy()) {
-                           builder.CreateRetVoid();
-                       } else {
-                           builder.CreateRet(value);
-                       }
-                   }},
-               *method.body);
+    if (flat_program->kinds[entry.body] == codegen::ast::node_kind::block) {
+        emit_block(entry.body);
+    } else {
+        auto* value = eval(entry.body);
+        if (ret_ty->isVoidTy()) {
+            builder.CreateRetVoid();
+        } else {
+            builder.CreateRet(value);
+        }
+    }
 
     if (!builder.GetInsertBlock()->getTerminator()) {
         if (ret_ty->isVoidTy()) {
@@ -550,49 +885,54 @@ void llvm_codegen::emit_method_body(codegen::ast::method_declaration& method) {
     current_this = nullptr;
 }
 
-void llvm_codegen::emit_constructor_body(codegen::ast::constructor_declaration& ctor) {
-    auto* fn = constructor_functions.at(&ctor);
-    auto* entry = ::llvm::BasicBlock::Create(context, "entry", fn);
-    builder.SetInsertPoint(entry);
+void llvm_codegen::emit_constructor_body(uint32_t ctor) {
+    const auto& program = *flat_program;
+    const auto& entry = program.constructors[ctor];
+    auto* fn = constructor_functions.at(entry.declaration);
+    auto* bb = ::llvm::BasicBlock::Create(context, "entry", fn);
+    builder.SetInsertPoint(bb);
 
     current_function = fn;
     current_this = fn->getArg(0);
-    parameter_slots.clear();
-    variable_slots.clear();
 
     auto arg_it = std::next(fn->arg_begin());
-    for (auto& p : ctor.parameters) {
-        auto* slot = create_entry_alloca(map_type(p->type), p->name);
+    for (size_t i = 0; i < entry.declaration->parameters.size(); ++i) {
+        auto& p = entry.declaration->parameters[i];
+        auto* slot = create_entry_alloca(map_type(p->type), p->name.str());
         builder.CreateStore(&*arg_it, slot);
-        parameter_slots[p.get()] = slot;
+        parameter_slots[entry.first_parameter + i] = slot;
         ++arg_it;
     }
 
-    if (ctor.super_constructor) {
+    if (auto super_call = entry.super_call; super_call != codegen::ast::flat::none) {
+        auto arguments = program.list(program.rhs[super_call]);
         std::vector<::llvm::Value *> args;
-        args.reserve(ctor.super_constructor->arguments.size() + 1);
+        args.reserve(arguments.size() + 1);
         args.push_back(current_this);
-        for (auto & arg : ctor.super_constructor->arguments) {
-            args.push_back(eval(*arg));
+        for (auto arg : arguments) {
+            args.push_back(eval(arg));
         }
-        builder.CreateCall(constructor_functions.at(ctor.super_constructor->constructor), args);
+        builder.CreateCall(constructor_functions.at(program.constructors[program.lhs[super_call]].declaration), args);
     }
 
-    if (auto it = vtable_globals.find(ctor.class_owner); it != vtable_globals.end()) {
+    auto* owner = entry.declaration->class_owner;
+    if (auto it = vtable_globals.find(owner); it != vtable_globals.end()) {
         builder.CreateStore(it->second, current_this);
     }
 
-    for (auto& field : ctor.class_owner->fields) {
-        if (!field->initializer) {
+    const auto& owner_entry = program.classes[entry.owner];
+    for (size_t i = 0; i < owner->fields.size(); ++i) {
+        auto initializer = program.fields[owner_entry.first_field + i].initializer;
+        if (initializer == codegen::ast::flat::none) {
             continue;
         }
-        auto* value = eval(*field->initializer);
-        auto* addr = emit_field_address(current_this, *field);
+        auto* value = eval(initializer);
+        auto* addr = emit_field_address(current_this, *owner->fields[i]);
         builder.CreateStore(value, addr);
     }
 
-    if (ctor.body) {
-        ctor.body->accept(*this);
+    if (entry.body != codegen::ast::flat::none) {
+        emit_block(entry.body);
     }
 
     if (!builder.GetInsertBlock()->getTerminator()) {
@@ -603,11 +943,11 @@ void llvm_codegen::emit_constructor_body(codegen::ast::constructor_declaration&
     current_this = nullptr;
 }
 
-void llvm_codegen::emit_main(codegen::ast::program& program) {
+void llvm_codegen::emit_main() {
     codegen::ast::class_declaration* entry_cls = nullptr;
-    for (auto& cls : program.classes) {
-        if (cls->name == entry_class_name) {
-            entry_cls = cls.get();
+    for (const auto& cls : std::span{flat_program->classes}.subspan(flat_program->internal_class_count)) {
+        if (cls.declaration->name == entry_class_name) {
+            entry_cls = cls.declaration;
             break;
         }
     }
@@ -638,105 +978,167 @@ void llvm_codegen::emit_main(codegen::ast::program& program) {
     builder.CreateRet(::llvm::ConstantInt::get(i32, 0));
 }
 
-void llvm_codegen::visit(codegen::ast::program& node) {
-    for (auto& cls : node.internal_classes) {
-        declare_internal_class_type(*cls);
-    }
-    for (auto& cls : node.classes) {
-        declare_class_type(*cls);
-    }
-    for (auto& cls : node.classes) {
-        define_class_layout(*cls);
-    }
-
-    for (auto& cls : node.classes) {
-        for (auto& method : cls->methods) {
-            declare_method(*method);
+void llvm_codegen::emit_customized_methods() {
+    // clone inherited methods that dispatch on `this` into every subclass, so the clone calls its siblings directly
+    size_t budget = options.customize_budget;
+    std::vector<std::tuple<codegen::ast::class_declaration*, codegen::ast::method_declaration*, ::llvm::Function*>> clones;
+    auto user_classes = std::span{flat_program->classes}.subspan(flat_program->internal_class_count);
+    for (const auto& user_class : user_classes) {
+        auto* cls = user_class.declaration;
+        if (!vtable_globals.contains(cls)) {
+            continue;
         }
-        for (auto& ctor : cls->constructors) {
-            declare_constructor(*ctor);
+        for (auto& entry : vtable_entries.at(cls)) {
+            if (entry.method->class_owner == cls || !self_dispatching_functions.contains(entry.function)) {
+                continue;
+            }
+            size_t size = entry.function->getInstructionCount();
+            if (size > budget) {
+                continue;
+            }
+            budget -= size;
+
+            auto* fn = ::llvm::Function::Create(entry.function->getFunctionType(),
+                                                ::llvm::Function::ExternalLinkage,
+                                                cls->name.str() + mangle_method(*entry.method).substr(entry.method->class_owner->name.view().size()),
+                                                module.get());
+            for (auto [from, to] = std::pair{entry.function->arg_begin(), fn->arg_begin()}; to != fn->arg_end(); ++from, ++to) {
+                to->setName(from->getName());
+            }
+            entry.function = fn;
+            clones.emplace_back(cls, entry.method, fn);
         }
     }
 
-    for (auto& cls : node.classes) {
-        build_vtable_for(*cls);
+    for (auto [cls, method, fn] : clones) {
+        customized_class = cls;
+        emit_method_body(flat_program->index_of(method), fn);
     }
-    for (auto& cls : node.classes) {
-        emit_vtable_global(*cls);
+    customized_class = nullptr;
+
+    for (const auto& user_class : user_classes) {
+        if (auto it = vtable_globals.find(user_class.declaration); it != vtable_globals.end()) {
+            it->second->setInitializer(vtable_initializer(*user_class.declaration));
+        }
     }
 
-    for (auto& cls : node.classes) {
-        for (auto& method : cls->methods) {
-            emit_method_body(*method);
+    // calls resolved by class hierarchy analysis move to the clone when their receivers still share one implementation
+    for (auto [call, static_class, slot] : resolved_calls) {
+        auto receivers = receiver_classes(static_class);
+        auto* target = vtable_entries.at(receivers.front())[slot].function;
+        bool shared = std::ranges::all_of(receivers, [&](auto* cls) { return vtable_entries.at(cls)[slot].function == target; });
+        if (shared) {
+            call->setCalledFunction(target);
         }
-        for (auto& ctor : cls->constructors) {
-            emit_constructor_body(*ctor);
+    }
+}
+
+::llvm::Function* llvm_codegen::emit_interpreter_adapter(::llvm::Function* fn) {
+    // interpreter registers are 8 bytes wide and hold Booleans as 0 or 1; `this` is register 0 and receives the result
+    auto* ptr_ty = ::llvm::PointerType::get(context, 0);
+    auto* i64 = ::llvm::Type::getInt64Ty(context);
+    auto* adapter_ty = ::llvm::FunctionType::get(::llvm::Type::getVoidTy(context), {ptr_ty}, false);
+    auto* adapter = ::llvm::Function::Create(adapter_ty, ::llvm::Function::ExternalLinkage, "adapter." + fn->getName(), module.get());
+    auto* registers = adapter->getArg(0);
+    registers->setName("registers");
+    builder.SetInsertPoint(::llvm::BasicBlock::Create(context, "entry", adapter));
+
+    std::vector<::llvm::Value*> args;
+    for (auto& arg : fn->args()) {
+        auto* slot = builder.CreateConstInBoundsGEP1_64(i64, registers, arg.getArgNo());
+        if (arg.getType()->isIntegerTy(1)) {
+            args.push_back(builder.CreateTrunc(builder.CreateLoad(i64, slot), arg.getType()));
+        } else {
+            args.push_back(builder.CreateLoad(arg.getType(), slot, arg.getName()));
         }
     }
+    auto* result = builder.CreateCall(fn, args);
+    if (auto* ret_ty = fn->getReturnType(); ret_ty->isIntegerTy(1)) {
+        builder.CreateStore(builder.CreateZExt(result, i64), registers);
+    } else if (!ret_ty->isVoidTy()) {
+        builder.CreateStore(result, registers);
+    }
+    builder.CreateRetVoid();
+    return adapter;
+}
 
-    emit_main(node);
+void llvm_codegen::emit_statement(codegen::ast::flat::node_index node) {
+    const auto& program = *flat_program;
+    switch (program.kinds[node]) {
+    case codegen::ast::node_kind::block:
+        emit_block(node);
+        break;
+    case codegen::ast::node_kind::variable_declaration:
+        emit_variable_declaration(node);
+        break;
+    case codegen::ast::node_kind::variable_assignment: {
+        auto* value = eval_value_or_ref(program.rhs[node]);
+        builder.CreateStore(value, target_address(program.lhs[node]));
+        break;
+    }
+    case codegen::ast::node_kind::field_assignment: {
+        auto* value = eval_value_or_ref(program.rhs[node]);
+        auto target = program.lhs[node];
+        auto* object = eval(program.lhs[target]);
+        auto* addr = emit_field_address(object, *program.fields[program.rhs[target]].declaration);
+        builder.CreateStore(value, addr);
+        break;
+    }
+    case codegen::ast::node_kind::while_statement:
+        emit_while(node);
+        break;
+    case codegen::ast::node_kind::if_statement:
+        emit_if(node);
+        break;
+    case codegen::ast::node_kind::return_statement:
+        emit_return(node);
+        break;
+    default:
+        // an expression statement
+        eval(node);
+        break;
+    }
 }
 
-void llvm_codegen::visit(codegen::ast::block& node) {
-    for (auto& item : node.items) {
-        item->accept(*this);
+void llvm_codegen::emit_block(codegen::ast::flat::node_index node) {
+    for (auto item : flat_program->list(flat_program->lhs[node])) {
+        emit_statement(item);
         if (builder.GetInsertBlock() && builder.GetInsertBlock()->getTerminator()) {
             break;
         }
     }
 }
 
-void llvm_codegen::visit(codegen::ast::class_declaration&) {}
-void llvm_codegen::visit(codegen::ast::field_declaration&) {}
-void llvm_codegen::visit(codegen::ast::method_declaration&) {}
-void llvm_codegen::visit(codegen::ast::constructor_declaration&) {}
-void llvm_codegen::visit(codegen::ast::parameter_declaration&) {}
-
-void llvm_codegen::visit(codegen::ast::variable_declaration& node) {
-    auto* var_ty = map_type(node.type);
+void llvm_codegen::emit_variable_declaration(codegen::ast::flat::node_index node) {
+    auto variable = flat_program->lhs[node];
+    auto initializer = flat_program->rhs[node];
+    auto* var_ty = map_type(flat_program->variables[variable]->type);
     if (var_ty->isVoidTy()) {
-        if (node.initializer) {
-            eval(*node.initializer);
+        if (initializer != codegen::ast::flat::none) {
+            eval(initializer);
         }
         return;
     }
-    auto* slot = create_entry_alloca(var_ty, node.name);
-    variable_slots[&node] = slot;
-    if (node.initializer) {
-        auto* value = eval_value_or_ref(*node.initializer);
+    auto* slot = create_entry_alloca(var_ty, flat_program->variables[variable]->name.str());
+    variable_slots[variable] = slot;
+    if (initializer != codegen::ast::flat::none) {
+        auto* value = eval_value_or_ref(initializer);
         builder.CreateStore(value, slot);
     }
 }
 
-void llvm_codegen::visit(codegen::ast::variable_assignment& node) {
-    auto* value = eval_value_or_ref(*node.value);
-    ::llvm::Value* slot = std::visit(overloaded{
-                                         [this](codegen::ast::variable_declaration* d) -> ::llvm::Value* { return variable_slots.at(d); },
-                                         [this](codegen::ast::parameter_declaration* d) -> ::llvm::Value* { return parameter_slots.at(d); },
-                                         [this](codegen::ast::field_declaration* d) -> ::llvm::Value* { return emit_field_address(current_this, *d); }},
-                                     node.target);
-    builder.CreateStore(value, slot);
-}
-
-void llvm_codegen::visit(codegen::ast::field_assignment& node) {
-    auto* value = eval_value_or_ref(*node.value);
-    auto* object = eval(*node.target->object);
-    auto* addr = emit_field_address(object, *node.target->member);
-    builder.CreateStore(value, addr);
-}
-
-void llvm_codegen::visit(codegen::ast::while_statement& node) {
+void llvm_codegen::emit_while(codegen::ast::flat::node_index node) {
     auto* cond_block = ::llvm::BasicBlock::Create(context, "while.cond", current_function);
     auto* body_block = ::llvm::BasicBlock::Create(context, "while.body", current_function);
     auto* end_block = ::llvm::BasicBlock::Create(context, "while.end", current_function);
 
     builder.CreateBr(cond_block);
     builder.SetInsertPoint(cond_block);
-    auto* cond = eval(*node.condition);
+    auto* cond = eval(flat_program->lhs[node]);
     builder.CreateCondBr(cond, body_block, end_block);
 
     builder.SetInsertPoint(body_block);
-    node.body->accept(*this);
+    emit_block(flat_program->rhs[node]);
     if (!builder.GetInsertBlock()->getTerminator()) {
         builder.CreateBr(cond_block);
     }
@@ -744,23 +1146,27 @@ void llvm_codegen::visit(codegen::ast::while_statement& node) {
     builder.SetInsertPoint(end_block);
 }
 
-void llvm_codegen::visit(codegen::ast::if_statement& node) {
-    auto* cond = eval(*node.condition);
+void llvm_codegen::emit_if(codegen::ast::flat::node_index node) {
+    auto true_branch = flat_program->extra[flat_program->rhs[node]];
+    auto false_branch = flat_program->extra[flat_program->rhs[node] + 1];
+    bool has_false_branch = false_branch != codegen::ast::flat::none;
+
+    auto* cond = eval(flat_program->lhs[node]);
     auto* then_block = ::llvm::BasicBlock::Create(context, "if.then", current_function);
     auto* else_block = ::llvm::BasicBlock::Create(context, "if.else", current_function);
     auto* end_block = ::llvm::BasicBlock::Create(context, "if.end", current_function);
 
-    builder.CreateCondBr(cond, then_block, node.false_branch ? else_block : end_block);
+    builder.CreateCondBr(cond, then_block, has_false_branch ? else_block : end_block);
 
     builder.SetInsertPoint(then_block);
-    node.true_branch->accept(*this);
+    emit_block(true_branch);
     if (!builder.GetInsertBlock()->getTerminator()) {
         builder.CreateBr(end_block);
     }
 
     builder.SetInsertPoint(else_block);
-    if (node.false_branch) {
-        node.false_branch->accept(*this);
+    if (has_false_branch) {
+        emit_block(false_branch);
         if (!builder.GetInsertBlock()->getTerminator()) {
             builder.CreateBr(end_block);
         }
@@ -771,73 +1177,106 @@ void llvm_codegen::visit(codegen::ast::if_statement& node) {
     builder.SetInsertPoint(end_block);
 }
 
-void llvm_codegen::visit(codegen::ast::return_statement& node) {
+void llvm_codegen::emit_return(codegen::ast::flat::node_index node) {
+    auto value_node = flat_program->lhs[node];
     if (current_function->getReturnType()->isVoidTy()) {
-        if (node.value) {
-            eval(*node.value);
+        if (value_node != codegen::ast::flat::none) {
+            eval(value_node);
         }
         builder.CreateRetVoid();
         return;
     }
-    if (node.value) {
-        auto* value = eval(*node.value);
+    if (value_node != codegen::ast::flat::none) {
+        auto* value = eval(value_node);
         builder.CreateRet(value);
     } else {
         builder.CreateRetVoid();
     }
 }
 
-void llvm_codegen::visit(codegen::ast::literal_expression& node) {
-    current_value = std::visit(overloaded{
-                                   [this](int64_t v) -> ::llvm::Value* { return ::llvm::ConstantInt::get(::llvm::Type::getInt64Ty(context), v, true); },
-                                   [this](double v) -> ::llvm::Value* { return ::llvm::ConstantFP::get(::llvm::Type::getDoubleTy(context), v); },
-                                   [this](bool v) -> ::llvm::Value* { return ::llvm::ConstantInt::get(::llvm::Type::getInt1Ty(context), v ? 1 : 0); }},
-                               node.value);
-}
-
-void llvm_codegen::visit(codegen::ast::this_expression&) {
-    current_value = current_this;
-}
-
-void llvm_codegen::visit(codegen::ast::identifier_expression& node) {
-    current_value = std::visit(overloaded{
-                                   [this](codegen::ast::variable_declaration* d) -> ::llvm::Value* {
-                                       auto* slot = variable_slots.at(d);
-                                       return builder.CreateLoad(map_type(d->type), slot, d->name);
-                                   },
-                                   [this](codegen::ast::parameter_declaration* d) -> ::llvm::Value* {
-                                       auto* slot = parameter_slots.at(d);
-                                       return builder.CreateLoad(map_type(d->type), slot, d->name);
-                                   },
-                                   [this](codegen::ast::field_declaration* d) -> ::llvm::Value* {
-                                       auto* addr = emit_field_address(current_this, *d);
-                                       return builder.CreateLoad(map_type(d->type), addr, d->name);
-                                   }},
-                               node.target);
+::llvm::Value* llvm_codegen::eval(codegen::ast::flat::node_index expr) {
+    const auto& program = *flat_program;
+    auto lhs = program.lhs[expr];
+    auto rhs = program.rhs[expr];
+    switch (program.kinds[expr]) {
+    case codegen::ast::node_kind::literal_expression:
+        switch (static_cast<codegen::ast::flat::literal_kind>(lhs)) {
+        case codegen::ast::flat::literal_kind::integer:
+            return ::llvm::ConstantInt::get(::llvm::Type::getInt64Ty(context), program.integers[rhs], true);
+        case codegen::ast::flat::literal_kind::real:
+            return ::llvm::ConstantFP::get(::llvm::Type::getDoubleTy(context), program.reals[rhs]);
+        case codegen::ast::flat::literal_kind::boolean:
+            return ::llvm::ConstantInt::get(::llvm::Type::getInt1Ty(context), rhs != 0 ? 1 : 0);
+        }
+        return nullptr;
+    case codegen::ast::node_kind::this_expression:
+        return current_this;
+    case codegen::ast::node_kind::identifier_expression:
+        return eval_identifier(lhs);
+    case codegen::ast::node_kind::member_expression: {
+        const auto& member = *program.fields[rhs].declaration;
+        auto* object = eval(lhs);
+        auto* addr = emit_field_address(object, member);
+        return builder.CreateLoad(map_type(member.type), addr, member.name.str());
+    }
+    case codegen::ast::node_kind::grouping_expression:
+        return eval(lhs);
+    case codegen::ast::node_kind::method_call_expression:
+        return eval_method_call(expr);
+    case codegen::ast::node_kind::constructor_call_expression:
+        return eval_constructor_call(expr);
+    default:
+        return nullptr;
+    }
 }
 
-void llvm_codegen::visit(codegen::ast::member_expression& node) {
-    auto* object = eval(*node.object);
-    auto* addr = emit_field_address(object, *node.member);
-    current_value = builder.CreateLoad(map_type(node.member->type), addr, node.member->name);
+::llvm::Value* llvm_codegen::target_address(uint32_t target) {
+    auto index = codegen::ast::flat::index_of_target(target);
+    switch (codegen::ast::flat::kind_of_target(target)) {
+    case codegen::ast::flat::target_kind::variable:
+        return variable_slots[index];
+    case codegen::ast::flat::target_kind::parameter:
+        return parameter_slots[index];
+    case codegen::ast::flat::target_kind::field:
+        return emit_field_address(current_this, *flat_program->fields[index].declaration);
+    }
+    return nullptr;
 }
 
-void llvm_codegen::visit(codegen::ast::grouping_expression& node) {
-    current_value = eval(*node.inner);
+::llvm::Value* llvm_codegen::eval_identifier(uint32_t target) {
+    auto index = codegen::ast::flat::index_of_target(target);
+    switch (codegen::ast::flat::kind_of_target(target)) {
+    case codegen::ast::flat::target_kind::variable: {
+        const auto& d = *flat_program->variables[index];
+        return builder.CreateLoad(map_type(d.type), variable_slots[index], d.name.str());
+    }
+    case codegen::ast::flat::target_kind::parameter: {
+        const auto& d = *flat_program->parameters[index];
+        return builder.CreateLoad(map_type(d.type), parameter_slots[index], d.name.str());
+    }
+    case codegen::ast::flat::target_kind::field: {
+        const auto& d = *flat_program->fields[index].declaration;
+        auto* addr = emit_field_address(current_this, d);
+        return builder.CreateLoad(map_type(d.type), addr, d.name.str());
+    }
+    }
+    return nullptr;
 }
 
-void llvm_codegen::visit(codegen::ast::method_call_expression& node) {
-    auto* receiver = eval(*node.object);
+::llvm::Value* llvm_codegen::eval_method_call(codegen::ast::flat::node_index call) {
+    const auto& program = *flat_program;
+    const auto& method = *program.methods[program.extra[program.rhs[call]]].declaration;
+    auto* receiver = eval(program.lhs[call]);
+    auto arguments = program.list(program.rhs[call] + 1);
     std::vector<::llvm::Value*> args;
-    args.reserve(node.arguments.size());
-    for (auto& arg : node.arguments) {
-        auto *value = eval_value_or_ref(*arg);
+    args.reserve(arguments.size());
+    for (auto arg : arguments) {
+        auto *value = eval_value_or_ref(arg);
         args.push_back(value);
     }
 
-    if (is_builtin_class(node.method->class_owner->name)) {
-        current_value = emit_builtin_method(node, receiver, args);
-        return;
+    if (is_builtin_class(method.class_owner->name)) {
+        return emit_builtin_method(method, receiver, args);
     }
 
     std::vector<::llvm::Value*> call_args;
@@ -847,30 +1286,25 @@ void llvm_codegen::visit(codegen::ast::method_call_expression& node) {
         call_args.push_back(a);
     }
 
-    auto* ptr_ty = ::llvm::PointerType::get(context, 0);
-    auto* vtable = builder.CreateLoad(ptr_ty, receiver, "vtable");
-    int slot = method_vtable_slot(*node.method);
-    auto* slot_ptr = builder.CreateInBoundsGEP(
-        ptr_ty, vtable, ::llvm::ConstantInt::get(::llvm::Type::getInt32Ty(context), slot), "vslot");
-    auto* fn_ptr = builder.CreateLoad(ptr_ty, slot_ptr, "vfn");
-    auto* fn_type = method_functions.at(node.method)->getFunctionType();
-    current_value = builder.CreateCall(fn_type, fn_ptr, call_args);
+    return emit_virtual_call(call, call_args);
 }
 
-void llvm_codegen::visit(codegen::ast::constructor_call_expression& node) {
+::llvm::Value* llvm_codegen::eval_constructor_call(codegen::ast::flat::node_index call) {
+    const auto& program = *flat_program;
+    const auto& ctor = *program.constructors[program.lhs[call]].declaration;
+    auto arguments = program.list(program.rhs[call]);
     std::vector<::llvm::Value*> args;
-    args.reserve(node.arguments.size());
-    for (auto& arg : node.arguments) {
-        auto *value = eval_value_or_ref(*arg);
+    args.reserve(arguments.size());
+    for (auto arg : arguments) {
+        auto *value = eval_value_or_ref(arg);
         args.push_back(value);
     }
 
-    if (is_builtin_class(node.constructor->class_owner->name)) {
-        current_value = emit_builtin_constructor(node, args);
-        return;
+    if (is_builtin_class(ctor.class_owner->name)) {
+        return emit_builtin_constructor(ctor, args);
     }
 
-    auto* struct_ty = class_types.at(node.constructor->class_owner);
+    auto* struct_ty = class_types.at(ctor.class_owner);
     auto* size = ::llvm::ConstantExpr::getSizeOf(struct_ty);
     auto* obj = builder.CreateCall(get_or_declare_allocator(), {size}, "obj");
 
@@ -880,26 +1314,26 @@ void llvm_codegen::visit(codegen::ast::constructor_call_expression& node) {
     for (auto* a : args) {
         call_args.push_back(a);
     }
-    builder.CreateCall(constructor_functions.at(node.constructor), call_args);
-    current_value = obj;
+    builder.CreateCall(constructor_functions.at(&ctor), call_args);
+    return obj;
 }
 
-::llvm::Value* llvm_codegen::emit_builtin_constructor(const codegen::ast::constructor_call_expression& node,
+::llvm::Value* llvm_codegen::emit_builtin_constructor(const codegen::ast::constructor_declaration& ctor,
                                                      const std::vector<::llvm::Value*>& args) {
-    const auto& cls_name = node.constructor->class_owner->name;
-    if (cls_name == "Unit") {
-        return ::llvm::Constant::getIntegerValue(map_type(node.constructor->class_owner), ::llvm::APInt(1, 0));
+    const auto& cls_name = ctor.class_owner->name;
+    if (cls_name == well_known::unit) {
+        return ::llvm::Constant::getIntegerValue(map_type(ctor.class_owner), ::llvm::APInt(1, 0));
     }
-    if (cls_name == "IO") {
-        return ::llvm::Constant::getIntegerValue(map_type(node.constructor->class_owner), ::llvm::APInt(1, 0));
+    if (cls_name == well_known::io) {
+        return ::llvm::Constant::getIntegerValue(map_type(ctor.class_owner), ::llvm::APInt(1, 0));
     }
-    if (cls_name == "ArrayInteger") {
+    if (cls_name == well_known::array_integer) {
         assert(args.size() == 1);
         auto* type_size = ::llvm::ConstantExpr::getSizeOf(::llvm::Type::getInt64Ty(context));
         auto *size = builder.CreateMul(args[0], type_size);
         auto* data = builder.CreateCall(get_or_declare_allocator(), {size}, "data");
 
-        auto *array_type = internal_ref_class_types[node.constructor->class_owner->name];
+        auto *array_type = internal_ref_class_types[ctor.class_owner->name];
         auto *array_type_sie = ::llvm::ConstantExpr::getSizeOf(array_type);
         auto* array = builder.CreateCall(get_or_declare_allocator(), {array_type_sie}, "array");
 
@@ -910,46 +1344,46 @@ void llvm_codegen::visit(codegen::ast::constructor_call_expression& node) {
         return array;
     }
     if (args.empty()) {
-        return ::llvm::Constant::getNullValue(map_type(node.constructor->class_owner));
+        return ::llvm::Constant::getNullValue(map_type(ctor.class_owner));
     }
     auto* value = args[0];
-    const auto& src_name = node.constructor->parameters[0]->type->name;
+    const auto& src_name = ctor.parameters[0]->type->name;
 
-    if (cls_name == "Integer" && src_name == "Real") {
+    if (cls_name == well_known::integer && src_name == well_known::real) {
         return builder.CreateFPToSI(value, ::llvm::Type::getInt64Ty(context), "to.int");
     }
-    if (cls_name == "Real" && src_name == "Integer") {
+    if (cls_name == well_known::real && src_name == well_known::integer) {
         return builder.CreateSIToFP(value, ::llvm::Type::getDoubleTy(context), "to.real");
     }
     return value;
 }
 
-::llvm::Value* llvm_codegen::emit_builtin_method(const codegen::ast::method_call_expression& node,
+::llvm::Value* llvm_codegen::emit_builtin_method(const codegen::ast::method_declaration& method,
                                                  ::llvm::Value* receiver,
                                                  const std::vector<::llvm::Value*>& args) {
-    const auto& cls = node.method->class_owner->name;
-    const auto& name = node.method->name;
+    const auto& cls = method.class_owner->name;
+    const auto& name = method.name;
     auto* i64 = ::llvm::Type::getInt64Ty(context);
     auto* f64 = ::llvm::Type::getDoubleTy(context);
     auto* i1 = ::llvm::Type::getInt1Ty(context);
 
     auto to_real = [&](::llvm::Value* v) { return v->getType()->isIntegerTy() ? builder.CreateSIToFP(v, f64) : v; };
 
-    bool param_is_real = !node.method->parameters.empty() && node.method->parameters[0]->type->name == "Real";
-    bool returns_real = node.method->return_type && node.method->return_type->name == "Real";
-    bool uses_fp = (cls == "Real") || param_is_real || returns_real;
+    bool param_is_real = !method.parameters.empty() && method.parameters[0]->type->name == well_known::real;
+    bool returns_real = method.return_type && method.return_type->name == well_known::real;
+    bool uses_fp = (cls == well_known::real) || param_is_real || returns_real;
 
-    if (cls == "Integer" || cls == "Real") {
-        if (name == "UnaryMinus") {
+    if (cls == well_known::integer || cls == well_known::real) {
+        if (name == well_known::unary_minus) {
             return uses_fp ? builder.CreateFNeg(to_real(receiver)) : builder.CreateNeg(receiver);
         }
-        if (name == "toReal") {
+        if (name == well_known::to_real) {
             return builder.CreateSIToFP(receiver, f64);
         }
-        if (name == "toInteger") {
+        if (name == well_known::to_integer) {
             return builder.CreateFPToSI(receiver, i64);
         }
-        if (name == "toBoolean") {
+        if (name == well_known::to_boolean) {
             return builder.CreateICmpNE(receiver, ::llvm::ConstantInt::get(i64, 0));
         }
 
@@ -959,79 +1393,79 @@ void llvm_codegen::visit(codegen::ast::constructor_call_expression& node) {
             lhs = to_real(lhs);
             rhs = to_real(rhs);
         }
-        if (name == "Plus") {
+        if (name == well_known::plus) {
             return uses_fp ? builder.CreateFAdd(lhs, rhs) : builder.CreateAdd(lhs, rhs);
         }
-        if (name == "Minus") {
+        if (name == well_known::minus) {
             return uses_fp ? builder.CreateFSub(lhs, rhs) : builder.CreateSub(lhs, rhs);
         }
-        if (name == "Mult") {
+        if (name == well_known::mult) {
             return uses_fp ? builder.CreateFMul(lhs, rhs) : builder.CreateMul(lhs, rhs);
         }
-        if (name == "Div") {
+        if (name == well_known::div) {
             return uses_fp ? builder.CreateFDiv(lhs, rhs) : builder.CreateSDiv(lhs, rhs);
         }
-        if (name == "Rem") {
+        if (name == well_known::rem) {
             return uses_fp ? builder.CreateFRem(lhs, rhs) : builder.CreateSRem(lhs, rhs);
         }
-        if (name == "Less") {
+        if (name == well_known::less) {
             return uses_fp ? builder.CreateFCmpOLT(lhs, rhs) : builder.CreateICmpSLT(lhs, rhs);
         }
-        if (name == "LessEqual") {
+        if (name == well_known::less_equal) {
             return uses_fp ? builder.CreateFCmpOLE(lhs, rhs) : builder.CreateICmpSLE(lhs, rhs);
         }
-        if (name == "Greater") {
+        if (name == well_known::greater) {
             return uses_fp ? builder.CreateFCmpOGT(lhs, rhs) : builder.CreateICmpSGT(lhs, rhs);
         }
-        if (name == "GreaterEqual") {
+        if (name == well_known::greater_equal) {
             return uses_fp ? builder.CreateFCmpOGE(lhs, rhs) : builder.CreateICmpSGE(lhs, rhs);
         }
-        if (name == "Equal") {
+        if (name == well_known::equal) {
             return uses_fp ? builder.CreateFCmpOEQ(lhs, rhs) : builder.CreateICmpEQ(lhs, rhs);
         }
     }
 
-    if (cls == "Boolean") {
-        if (name == "Not") {
+    if (cls == well_known::boolean) {
+        if (name == well_known::not_) {
             return builder.CreateXor(receiver, ::llvm::ConstantInt::get(i1, 1));
         }
-        if (name == "toInteger") {
+        if (name == well_known::to_integer) {
             return builder.CreateZExt(receiver, i64);
         }
-        if (name == "And") {
+        if (name == well_known::and_) {
             return builder.CreateAnd(receiver, args[0]);
         }
-        if (name == "Or") {
+        if (name == well_known::or_) {
             return builder.CreateOr(receiver, args[0]);
         }
-        if (name == "Xor") {
+        if (name == well_known::xor_) {
             return builder.CreateXor(receiver, args[0]);
         }
     }
 
-    if (cls == "ArrayInteger") {
-        if (name == "Len") {
-            auto * len_ptr = builder.CreateStructGEP(internal_ref_class_types[node.method->class_owner->name], receiver, 1, "array.len.ptr");
+    if (cls == well_known::array_integer) {
+        if (name == well_known::len) {
+            auto * len_ptr = builder.CreateStructGEP(internal_ref_class_types[method.class_owner->name], receiver, 1, "array.len.ptr");
             return builder.CreateLoad(::llvm::Type::getInt64Ty(context), len_ptr, "len");
         }
-        if (name == "Get") {
+        if (name == well_known::get) {
             return builder.CreateCall(get_or_create_array_get(), {receiver, args[0]});
         }
-        if (name == "Set") {
+        if (name == well_known::set) {
             return builder.CreateCall(get_or_create_array_set(), {receiver, args[0], args[1]});
         }
     }
-    if (cls == "IO") {
-        if (name == "Print") {
+    if (cls == well_known::io) {
+        if (name == well_known::print) {
             auto *printf_fn = get_or_declare_printf();
-            auto* arg_type = node.method->parameters[0]->type;
+            auto* arg_type = method.parameters[0]->type;
             std::string format_str;
 
-            if (arg_type->name == "Integer") {
+            if (arg_type->name == well_known::integer) {
                 format_str = "%lld\n";
-            } else if (arg_type->name == "Real") {
+            } else if (arg_type->name == well_known::real) {
                 format_str = "%f\n";
-            } else if (arg_type->name == "Boolean") {
+            } else if (arg_type->name == well_known::boolean) {
                 format_str = "%d\n";
             } else {
                 format_str = "%p\n";
@@ -1042,12 +1476,12 @@ void llvm_codegen::visit(codegen::ast::constructor_call_expression& node) {
             ::llvm::Value* arg_value = args[0];
             builder.CreateCall(printf_fn, {format_const, arg_value});
 
-            return ::llvm::Constant::getIntegerValue(internal_value_class_types["Unit"], ::llvm::APInt(1, 0));
+            return ::llvm::Constant::getIntegerValue(internal_value_class_types[well_known::unit], ::llvm::APInt(1, 0));
 
         }
     }
 
-    return ::llvm::Constant::getNullValue(map_type(node.method->return_type));
+    return ::llvm::Constant::getNullValue(map_type(method.return_type));
 }
 
 } // namespace codegen::llvm_ir
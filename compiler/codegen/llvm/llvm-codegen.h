@@ -1,8 +1,13 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <tuple>
 #include <unordered_map>
+#include <utility>
+#include <unordered_set>
 #include <vector>
 
 #include <llvm/IR/IRBuilder.h>
@@ -11,68 +16,97 @@
 #include <llvm/Target/TargetMachine.h>
 
 #include "compiler/compilation-structures/ast/codegen/ast.h"
-#include "compiler/compilation-structures/ast/codegen/ast-visitor.h"
+#include "compiler/compilation-structures/ast/codegen/flat-ast.h"
 
 namespace codegen::llvm_ir {
 
-class llvm_codegen : public codegen::ast::visitor {
-public:
-    explicit llvm_codegen(const std::string& module_name, std::string entry_class_name = "Main");
-    ~llvm_codegen() override = default;
+struct codegen_options {
+    // emit IR-level PGO instrumentation; the value is the .profraw path pattern written by the profile runtime at exit
+    std::optional<std::string> profile_generate;
+    // .profdata file used to annotate branch weights, entry counts and value profiles before object emission
+    std::optional<std::string> profile_use;
+    // number of receiver classes tested against the loaded vtable before falling back to an indirect call
+    size_t max_devirt_guards = 0;
+    // hierarchies with at most this many receiver classes are dispatched by comparing vtables, without an indirect call
+    size_t type_switch_threshold = 0;
+    // instructions that may be spent on cloning inherited methods per receiver class, 0 disables customization
+    size_t customize_budget = 0;
+    // declare vtable.<Class> without a definition, the runtime hosting the module provides them (tiered execution)
+    bool external_vtables = false;
+    // emit `void adapter.<function>(ptr registers)` for every method and constructor, reading the arguments from and
+    // writing the result to bytecode interpreter registers
+    bool interpreter_adapters = false;
+    // split the optimized module and emit the object file on this many threads, the parts are merged with `ld -r`
+    size_t codegen_threads = 1;
+};
 
-    void emit(codegen::ast::program& program);
+class llvm_codegen {
+public:
+    // `shared_context`, when given, belongs to the caller and has to outlive the codegen
+    explicit llvm_codegen(const std::string& module_name,
+                          std::string_view entry_class_name = "Main",
+                          codegen_options options = {},
+                          ::llvm::LLVMContext* shared_context = nullptr);
+    // lowers the bodies from the node columns of `program`; its declarations are read from the codegen tree
+    void emit(const codegen::ast::flat::program& program);
+    // declares the class types, vtables and functions of `program` without lowering a body; `program` has to outlive
+    // the codegen, which then lowers bodies one at a time with emit_function
+    void declare(const codegen::ast::flat::program& program);
+    // mangled names of the declared methods and constructors
+    std::vector<std::string> function_names() const;
+    // lowers one declared method or constructor, plus its adapter with interpreter_adapters, into a module of its own
+    // in which the rest of the program is only declared; needs external_vtables, so every part shares the vtables
+    std::unique_ptr<::llvm::Module> emit_function(const std::string& name);
 
     std::string ir_to_string() const;
     bool write_ir_file(const std::string& path) const;
     bool write_object_file(const std::string& path);
-
-    void visit(codegen::ast::program& node) override;
-    void visit(codegen::ast::block& node) override;
-    void visit(codegen::ast::class_declaration& node) override;
-    void visit(codegen::ast::field_declaration& node) override;
-    void visit(codegen::ast::variable_declaration& node) override;
-    void visit(codegen::ast::parameter_declaration& node) override;
-    void visit(codegen::ast::method_declaration& node) override;
-    void visit(codegen::ast::constructor_declaration& node) override;
-    void visit(codegen::ast::variable_assignment& node) override;
-    void visit(codegen::ast::field_assignment& node) override;
-    void visit(codegen::ast::while_statement& node) override;
-    void visit(codegen::ast::if_statement& node) override;
-    void visit(codegen::ast::return_statement& node) override;
-    void visit(codegen::ast::literal_expression& node) override;
-    void visit(codegen::ast::this_expression& node) override;
-    void visit(codegen::ast::identifier_expression& node) override;
-    void visit(codegen::ast::method_call_expression& node) override;
-    void visit(codegen::ast::constructor_call_expression& node) override;
-    void visit(codegen::ast::member_expression& node) override;
-    void visit(codegen::ast::grouping_expression& node) override;
+    // hands the finished module over (e.g. to the JIT); the context and builder leave with it, so only an expiring
+    // codegen can do this
+    std::pair<std::unique_ptr<::llvm::LLVMContext>, std::unique_ptr<::llvm::Module>> release_module() &&;
 
 private:
+    // flat method or constructor number of a declared function
+    struct function_body {
+        bool constructor;
+        uint32_t index;
+    };
+
     struct vtable_entry {
-        std::string name;
-        std::vector<std::string> param_type_names;
+        common::symbol_id name;
+        std::vector<common::symbol_id> param_type_names;
+        codegen::ast::method_declaration* method;
         ::llvm::Function* function;
     };
 
-    ::llvm::LLVMContext context;
+    std::unique_ptr<::llvm::LLVMContext> context_owner;
+    ::llvm::LLVMContext& context;
     std::unique_ptr<::llvm::Module> module;
     ::llvm::IRBuilder<> builder;
     std::unique_ptr<::llvm::TargetMachine> target_machine;
-    std::string entry_class_name;
+    common::symbol_id entry_class_name;
+    codegen_options options;
 
     std::unordered_map<const codegen::ast::class_declaration*, ::llvm::StructType*> class_types;
-    std::unordered_map<std::string, ::llvm::Type*> internal_value_class_types;
-    std::unordered_map<std::string, ::llvm::Type*> internal_ref_class_types;
+    std::unordered_map<common::symbol_id, ::llvm::Type*> internal_value_class_types;
+    std::unordered_map<common::symbol_id, ::llvm::Type*> internal_ref_class_types;
     std::unordered_map<const codegen::ast::method_declaration*, ::llvm::Function*> method_functions;
     std::unordered_map<const codegen::ast::constructor_declaration*, ::llvm::Function*> constructor_functions;
-    std::unordered_map<const codegen::ast::variable_declaration*, ::llvm::AllocaInst*> variable_slots;
-    std::unordered_map<const codegen::ast::parameter_declaration*, ::llvm::AllocaInst*> parameter_slots;
+    std::unordered_map<const ::llvm::Function*, function_body> function_bodies;
+    // indexed by variable and parameter number of the flat program
+    std::vector<::llvm::AllocaInst*> variable_slots;
+    std::vector<::llvm::AllocaInst*> parameter_slots;
     std::unordered_map<const codegen::ast::class_declaration*, std::vector<vtable_entry>> vtable_entries;
     std::unordered_map<const codegen::ast::class_declaration*, ::llvm::GlobalVariable*> vtable_globals;
+    std::unordered_map<const codegen::ast::class_declaration*, std::vector<codegen::ast::class_declaration*>> direct_subclasses;
+    std::unordered_set<const ::llvm::Function*> self_dispatching_functions;
+    std::vector<std::tuple<::llvm::CallInst*, codegen::ast::class_declaration*, int>> resolved_calls;
 
-    ::llvm::Value* current_value = nullptr;
+    const codegen::ast::flat::program* flat_program = nullptr;
     ::llvm::Value* current_this = nullptr;
     ::llvm::Function* current_function = nullptr;
+    // exact class of `this` while emitting a customized method clone
+    const codegen::ast::class_declaration* customized_class = nullptr;
 
     ::llvm::Type* map_type(const codegen::ast::class_declaration* type);
     ::llvm::Type* declare_internal_class_type(codegen::ast::class_declaration& cls);
@@ -80,17 +114,36 @@ private:
     void define_class_layout(codegen::ast::class_declaration& cls);
     void declare_method(codegen::ast::method_declaration& method);
     void declare_constructor(codegen::ast::constructor_declaration& ctor);
-    void emit_method_body(codegen::ast::method_declaration& method);
-    void emit_constructor_body(codegen::ast::constructor_declaration& ctor);
+    void emit_method_body(uint32_t method, ::llvm::Function* fn);
+    void emit_constructor_body(uint32_t ctor);
 
     void build_vtable_for(codegen::ast::class_declaration& cls);
+    ::llvm::Constant* vtable_initializer(const codegen::ast::class_declaration& cls);
     void emit_vtable_global(codegen::ast::class_declaration& cls);
+    void emit_customized_methods();
+    ::llvm::Function* emit_interpreter_adapter(::llvm::Function* fn);
     int method_vtable_slot(const codegen::ast::method_declaration& method) const;
-
-    void emit_main(codegen::ast::program& program);
-
-    ::llvm::Value* eval(codegen::ast::expression& expr);
-    ::llvm::Value* eval_value_or_ref(codegen::ast::expression& expr);
+    std::vector<codegen::ast::class_declaration*> receiver_classes(codegen::ast::class_declaration* static_class) const;
+    ::llvm::Value* emit_virtual_call(codegen::ast::flat::node_index call, const std::vector<::llvm::Value*>& call_args);
+
+    void emit_main();
+    void run_optimization_pipeline();
+    bool write_single_object_file(const std::string& path);
+    bool write_split_object_file(const std::string& path, const std::string& linker);
+
+    void emit_statement(codegen::ast::flat::node_index node);
+    void emit_block(codegen::ast::flat::node_index node);
+    void emit_variable_declaration(codegen::ast::flat::node_index node);
+    void emit_while(codegen::ast::flat::node_index node);
+    void emit_if(codegen::ast::flat::node_index node);
+    void emit_return(codegen::ast::flat::node_index node);
+
+    ::llvm::Value* eval(codegen::ast::flat::node_index expr);
+    ::llvm::Value* eval_value_or_ref(codegen::ast::flat::node_index expr);
+    ::llvm::Value* eval_identifier(uint32_t target);
+    ::llvm::Value* eval_method_call(codegen::ast::flat::node_index call);
+    ::llvm::Value* eval_constructor_call(codegen::ast::flat::node_index call);
+    ::llvm::Value* target_address(uint32_t target);
     ::llvm::AllocaInst* create_entry_alloca(::llvm::Type* type, const std::string& name);
     int field_index(const codegen::ast::field_declaration& field) const;
     ::llvm::Value* emit_field_address(::llvm::Value* object, const codegen::ast::field_declaration& field);
@@ -100,18 +153,18 @@ private:
     ::llvm::Function* get_or_create_array_set();
     ::llvm::Value* copy_value_on_heap(::llvm::Value* value, ::llvm::Type* type);
 
-    ::llvm::Value* emit_builtin_method(const codegen::ast::method_call_expression& call,
+    ::llvm::Value* emit_builtin_method(const codegen::ast::method_declaration& method,
                                        ::llvm::Value* receiver,
                                        const std::vector<::llvm::Value*>& args);
-    ::llvm::Value* emit_builtin_constructor(const codegen::ast::constructor_call_expression& call,
+    ::llvm::Value* emit_builtin_constructor(const codegen::ast::constructor_declaration& ctor,
                                             const std::vector<::llvm::Value*>& args);
 
-    static bool is_builtin_class(const std::string& name);
+    static bool is_builtin_class(common::symbol_id name);
     static std::string mangle_method(const codegen::ast::method_declaration& method);
     static std::string mangle_constructor(const codegen::ast::constructor_declaration& ctor);
     static std::string param_type_name(const codegen::ast::class_declaration* type);
-    static std::vector<std::string> param_type_names_of(
-        const std::vector<std::unique_ptr<codegen::ast::parameter_declaration>>& params);
+    static std::vector<common::symbol_id> param_type_names_of(
+        const common::arena_vector<std::unique_ptr<codegen::ast::parameter_declaration>>& params);
 };
 
 } // namespace codegen::llvm_ir
@@ -0,0 +1,175 @@
+#include "compiler/codegen/llvm/llvm-jit.h"
+
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include <llvm/ExecutionEngine/Orc/Core.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/IndirectionUtils.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/LazyReexports.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/Support/DynamicLibrary.h>
+#include <llvm/Support/Error.h>
+
+namespace {
+
+// used when the compiler is not linked against the Boehm GC: objects are never freed, which is fine for short runs
+void* fallback_gc_malloc(size_t size) {
+    return std::calloc(1, size);
+}
+
+template <typename T>
+T unwrap(::llvm::Expected<T> value, const std::string& what) {
+    if (!value) {
+        throw std::runtime_error(what + ": " + ::llvm::toString(value.takeError()));
+    }
+    return std::move(*value);
+}
+
+void check(::llvm::Error err, const std::string& what) {
+    if (err) {
+        throw std::runtime_error(what + ": " + ::llvm::toString(std::move(err)));
+    }
+}
+
+template <typename T>
+T lookup_symbol(::llvm::orc::LLJIT& jit, ::llvm::orc::JITDylib& dylib, const std::string& name) {
+    auto address = unwrap(jit.lookup(dylib, name), "failed to find '" + name + "'");
+    return address.toPtr<T>();
+}
+
+// resolves the module's external symbols in the compiler process, plus the given runtime-provided ones
+void add_runtime_symbols(::llvm::orc::LLJIT& jit, ::llvm::orc::SymbolMap runtime_symbols) {
+    auto& main_dylib = jit.getMainJITDylib();
+    auto process_symbols = unwrap(::llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(jit.getDataLayout().getGlobalPrefix()),
+                                  "failed to expose process symbols");
+    main_dylib.addGenerator(std::move(process_symbols));
+
+    if (::llvm::sys::DynamicLibrary::SearchForAddressOfSymbol("GC_malloc") == nullptr) {
+        runtime_symbols[jit.mangleAndIntern("GC_malloc")] =
+            ::llvm::orc::ExecutorSymbolDef(::llvm::orc::ExecutorAddr::fromPtr(&fallback_gc_malloc), ::llvm::JITSymbolFlags::Exported | ::llvm::JITSymbolFlags::Callable);
+    }
+    if (!runtime_symbols.empty()) {
+        check(main_dylib.define(::llvm::orc::absoluteSymbols(std::move(runtime_symbols))), "failed to define runtime symbols");
+    }
+}
+
+const auto function_flags = ::llvm::JITSymbolFlags::Exported | ::llvm::JITSymbolFlags::Callable;
+
+// the tier hosts the vtables and calls functions through adapters
+codegen::llvm_ir::codegen_options tier_options(codegen::llvm_ir::codegen_options options) {
+    options.external_vtables = true;
+    options.interpreter_adapters = true;
+    return options;
+}
+
+} // namespace
+
+namespace codegen::llvm_ir {
+
+// A method or constructor and its adapter; materializing them emits their IR and hands it to the compile layer.
+class tiered_jit::function_unit : public ::llvm::orc::MaterializationUnit {
+public:
+    function_unit(tiered_jit& tier, std::string name)
+        : MaterializationUnit(Interface({{tier.jit->mangleAndIntern(name), function_flags},
+                                         {tier.jit->mangleAndIntern("adapter." + name), function_flags}},
+                                        nullptr)),
+          tier(tier),
+          name(std::move(name)) {}
+
+    ::llvm::StringRef getName() const override {
+        return name;
+    }
+
+    void materialize(std::unique_ptr<::llvm::orc::MaterializationResponsibility> responsibility) override {
+        std::unique_ptr<::llvm::Module> part;
+        {
+            auto lock = tier.context.getLock();
+            part = tier.codegen->emit_function(name);
+        }
+        ++tier.lowered;
+        part->setDataLayout(tier.jit->getDataLayout());
+        tier.jit->getIRTransformLayer().emit(std::move(responsibility), ::llvm::orc::ThreadSafeModule(std::move(part), tier.context));
+    }
+
+private:
+    // every symbol of the unit is defined once, nothing ever overrides one
+    void discard(const ::llvm::orc::JITDylib&, const ::llvm::orc::SymbolStringPtr&) override {}
+
+    tiered_jit& tier;
+    std::string name;
+};
+
+int run_module(std::unique_ptr<::llvm::LLVMContext> context, std::unique_ptr<::llvm::Module> module) {
+    auto jit = unwrap(::llvm::orc::LLJITBuilder().create(), "failed to create JIT");
+    add_runtime_symbols(*jit, {});
+
+    module->setDataLayout(jit->getDataLayout());
+    check(jit->addIRModule(::llvm::orc::ThreadSafeModule(std::move(module), std::move(context))), "failed to add module to JIT");
+
+    auto* main_fn = lookup_symbol<int (*)()>(*jit, jit->getMainJITDylib(), "main");
+    return main_fn();
+}
+
+tiered_jit::tiered_jit(bytecode::module& program,
+                       codegen::ast::flat::program flat_program,
+                       const std::string& module_name,
+                       codegen_options options)
+    : context(std::make_unique<::llvm::LLVMContext>()),
+      flat_program(std::move(flat_program)),
+      codegen(std::make_unique<llvm_codegen>(module_name, "Main", tier_options(std::move(options)), context.getContext())),
+      jit(unwrap(::llvm::orc::LLJITBuilder().create(), "failed to create JIT")) {
+    codegen->declare(this->flat_program);
+
+    ::llvm::orc::SymbolMap vtables;
+    for (auto& cls : program.classes) {
+        if (!cls->vtable.empty()) {
+            const void* table = cls->dispatch.data() + 1;
+            vtables[jit->mangleAndIntern("vtable." + cls->name)] =
+                ::llvm::orc::ExecutorSymbolDef(::llvm::orc::ExecutorAddr::fromPtr(table), ::llvm::JITSymbolFlags::Exported);
+        }
+    }
+    add_runtime_symbols(*jit, std::move(vtables));
+
+    auto& session = jit->getExecutionSession();
+    call_through = unwrap(::llvm::orc::createLocalLazyCallThroughManager(jit->getTargetTriple(), session, ::llvm::orc::ExecutorAddr()),
+                          "failed to create lazy call-through manager");
+    stubs = ::llvm::orc::createLocalIndirectStubsManagerBuilder(jit->getTargetTriple())();
+
+    // bodies resolve their calls to the stubs in the main dylib, so a callee is lowered on its first call, not with
+    // its caller
+    auto& main_dylib = jit->getMainJITDylib();
+    auto bodies_dylib = jit->createJITDylib("bodies");
+    check(bodies_dylib.takeError(), "failed to create JIT dylib");
+    bodies = &*bodies_dylib;
+    bodies->setLinkOrder({{&main_dylib, ::llvm::orc::JITDylibLookupFlags::MatchAllSymbols}}, false);
+
+    ::llvm::orc::SymbolAliasMap aliases;
+    ::llvm::orc::SymbolLookupSet functions;
+    for (auto& name : codegen->function_names()) {
+        auto symbol = jit->mangleAndIntern(name);
+        check(bodies->define(std::make_unique<function_unit>(*this, name)), "failed to declare '" + name + "'");
+        aliases[symbol] = ::llvm::orc::SymbolAliasMapEntry(symbol, function_flags);
+        functions.add(symbol);
+    }
+    declared = aliases.size();
+    check(main_dylib.define(::llvm::orc::lazyReexports(*call_through, *stubs, *bodies, std::move(aliases))), "failed to define lazy stubs");
+
+    // native code dispatches through the same tables, a stub lowers and compiles its method on the first native call
+    auto addresses = unwrap(session.lookup(::llvm::orc::makeJITDylibSearchOrder(&main_dylib), std::move(functions)), "failed to create lazy stubs");
+    for (auto& cls : program.classes) {
+        for (size_t slot = 0; slot < cls->vtable.size(); ++slot) {
+            cls->dispatch[slot + 1] = addresses[jit->mangleAndIntern(cls->vtable[slot]->name)].getAddress().toPtr<const void*>();
+        }
+    }
+}
+
+tiered_jit::~tiered_jit() = default;
+
+bytecode::native_entry tiered_jit::compile(const bytecode::function& fn) {
+    return lookup_symbol<bytecode::native_entry>(*jit, *bodies, "adapter." + fn.name);
+}
+
+} // namespace codegen::llvm_ir
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+
+#include "compiler/codegen/bytecode/bytecode.h"
+#include "compiler/codegen/bytecode/interpreter.h"
+#include "compiler/codegen/llvm/llvm-codegen.h"
+#include "compiler/compilation-structures/ast/codegen/flat-ast.h"
+
+namespace llvm::orc {
+class IndirectStubsManager;
+class JITDylib;
+class LLJIT;
+class LazyCallThroughManager;
+} // namespace llvm::orc
+
+namespace codegen::llvm_ir {
+
+// Compiles the module in process with ORC LLJIT and calls its `main`, returning the exit code.
+// External symbols (printf, GC_malloc) are resolved against the running compiler.
+int run_module(std::unique_ptr<::llvm::LLVMContext> context, std::unique_ptr<::llvm::Module> module);
+
+// Native tier of the bytecode interpreter. Only the declarations of the program are lowered up front: the IR of a
+// method or constructor is emitted when the interpreter finds it hot, or when native code first calls it through its
+// lazy stub, and is compiled right away. The interpreter's dispatch tables are the vtable.<Class> symbols of the
+// native code, which keeps objects usable from both tiers.
+class tiered_jit : public bytecode::native_tier {
+public:
+    // the codegen tree behind `flat_program` has to outlive the tier
+    tiered_jit(bytecode::module& program,
+               codegen::ast::flat::program flat_program,
+               const std::string& module_name,
+               codegen_options options = {});
+    ~tiered_jit() override;
+
+    bytecode::native_entry compile(const bytecode::function& fn) override;
+
+    // methods and constructors whose IR has been emitted, out of all of them
+    size_t lowered_functions() const noexcept {
+        return lowered;
+    }
+    size_t declared_functions() const noexcept {
+        return declared;
+    }
+
+private:
+    class function_unit;
+
+    // declared first, so it outlives the codegen emitting into it
+    ::llvm::orc::ThreadSafeContext context;
+    codegen::ast::flat::program flat_program;
+    std::unique_ptr<llvm_codegen> codegen;
+    std::unique_ptr<::llvm::orc::LLJIT> jit;
+    std::unique_ptr<::llvm::orc::LazyCallThroughManager> call_through;
+    std::unique_ptr<::llvm::orc::IndirectStubsManager> stubs;
+    // holds the function bodies, the main dylib the stubs in front of them
+    ::llvm::orc::JITDylib* bodies = nullptr;
+    size_t lowered = 0;
+    size_t declared = 0;
+};
+
+} // namespace codegen::llvm_ir
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace common {
+
+// Bump allocator owning every node of one tree. Memory is only returned when the arena is destroyed, so nodes are
+// never freed one by one. Each thread allocating from the arena gets its own buffer, the parallel phases don't contend.
+class arena {
+public:
+    arena() = default;
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    // bytes taken from the system so far, buffers of all threads
+    size_t bytes_reserved() const noexcept {
+        return upstream.reserved.load(std::memory_order_relaxed);
+    }
+
+    // buffer of the calling thread, the thread keeps one per arena it works in
+    std::pmr::memory_resource* resource() {
+        thread_local std::vector<std::pair<uint64_t, std::pmr::memory_resource*>> cached;
+        for (const auto& [arena_id, cached_resource] : cached) {
+            if (arena_id == id) {
+                return cached_resource;
+            }
+        }
+
+        std::pmr::memory_resource* created;
+        {
+            std::lock_guard lock{mutex};
+            buffers.push_back(std::make_unique<std::pmr::monotonic_buffer_resource>(initial_buffer_size, &upstream));
+            created = buffers.back().get();
+        }
+        // entries of destroyed arenas never match again, the oldest is dropped to keep the lookup short
+        if (cached.size() == max_cached_arenas) {
+            cached.erase(cached.begin());
+        }
+        cached.emplace_back(id, created);
+        return created;
+    }
+
+    // arena of the calling thread's current scope, the global heap outside any scope
+    static std::pmr::memory_resource* current() noexcept {
+        return bound != nullptr ? bound : std::pmr::new_delete_resource();
+    }
+
+    static bool in_scope() noexcept {
+        return bound != nullptr;
+    }
+
+    // nodes and arena containers created by the calling thread while the scope is alive are placed in the arena
+    class scope {
+    public:
+        explicit scope(arena& memory) : previous(std::exchange(bound, memory.resource())) {}
+        ~scope() {
+            bound = previous;
+        }
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+
+    private:
+        std::pmr::memory_resource* previous;
+    };
+
+private:
+    static constexpr size_t initial_buffer_size = 64 * 1024;
+    static constexpr size_t max_cached_arenas = 8;
+
+    struct counting_resource : std::pmr::memory_resource {
+        std::atomic<size_t> reserved = 0;
+
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            reserved.fetch_add(bytes, std::memory_order_relaxed);
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* pointer, size_t bytes, size_t alignment) override {
+            std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+        }
+        bool do_is_equal(const memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    static uint64_t next_id() noexcept {
+        static std::atomic<uint64_t> ids = 0;
+        return ++ids;
+    }
+
+    static inline thread_local std::pmr::memory_resource* bound = nullptr;
+
+    // ids are never reused, so a thread's cached buffer can't outlive its arena
+    const uint64_t id = next_id();
+    counting_resource upstream;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource>> buffers;
+};
+
+// Allocates from the arena that was current when the container was created. Moves carry the arena along, so a list
+// built in a local and moved into a node stays in the node's arena.
+template<typename T>
+class arena_allocator {
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    arena_allocator() noexcept : memory(arena::current()) {}
+    explicit arena_allocator(std::pmr::memory_resource* memory) noexcept : memory(memory) {}
+    template<typename U>
+    arena_allocator(const arena_allocator<U>& other) noexcept : memory(other.resource()) {}
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(memory->allocate(count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* pointer, size_t count) noexcept {
+        memory->deallocate(pointer, count * sizeof(T), alignof(T));
+    }
+
+    std::pmr::memory_resource* resource() const noexcept {
+        return memory;
+    }
+
+    template<typename U>
+    friend bool operator==(const arena_allocator& lhs, const arena_allocator<U>& rhs) noexcept {
+        return lhs.memory == rhs.resource();
+    }
+
+private:
+    std::pmr::memory_resource* memory;
+};
+
+template<typename T>
+using arena_vector = std::vector<T, arena_allocator<T>>;
+
+// Class-level allocation for tree nodes: `new` places the node in the current arena and `delete` only runs the
+// destructor, the memory goes away with the arena.
+struct arena_node {
+    static void* operator new(size_t size) {
+        // outside a scope the node would land on the heap and never be freed, `delete` doesn't return memory
+        if (!arena::in_scope()) {
+            throw std::logic_error("tree nodes must be created inside an arena scope");
+        }
+        return arena::current()->allocate(size, alignof(std::max_align_t));
+    }
+    static void operator delete(void*) noexcept {}
+};
+
+} // namespace common
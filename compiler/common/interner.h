@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <format>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace common {
+
+class interner;
+
+// Interned identifier: equal names share one id, so comparing and hashing names is an integer operation. Converting from
+// text interns it, so it is explicit; names the compiler itself refers to are in well_known. view() returns the text,
+// which lives as long as the process.
+class symbol_id {
+public:
+    symbol_id() = default;
+    explicit symbol_id(std::string_view text);
+    explicit symbol_id(const std::string& text) : symbol_id(std::string_view{text}) {}
+    explicit symbol_id(const char* text) : symbol_id(std::string_view{text}) {}
+
+    uint32_t id() const noexcept {
+        return value;
+    }
+    std::string_view view() const {
+        return str();
+    }
+    const std::string& str() const;
+    bool empty() const noexcept {
+        return value == 0;
+    }
+
+    friend bool operator==(symbol_id lhs, symbol_id rhs) noexcept {
+        return lhs.value == rhs.value;
+    }
+
+private:
+    friend class interner;
+    explicit symbol_id(uint32_t value) : value(value) {}
+
+    // 0 is the empty string
+    uint32_t value = 0;
+};
+
+// Process-wide string table. The parser interns every name it puts in the tree, later phases only compare ids; interning
+// is thread safe, as the parallel method checks may intern mangled names.
+class interner {
+public:
+    static interner& global() {
+        static interner instance;
+        return instance;
+    }
+
+    symbol_id intern(std::string_view text) {
+        {
+            std::shared_lock lock{mutex};
+            if (auto it = ids.find(text); it != ids.end()) {
+                return symbol_id{it->second};
+            }
+        }
+        std::unique_lock lock{mutex};
+        if (auto it = ids.find(text); it != ids.end()) {
+            return symbol_id{it->second};
+        }
+        auto id = static_cast<uint32_t>(strings.size());
+        const auto& stored = strings.emplace_back(text);
+        ids.emplace(stored, id);
+        return symbol_id{id};
+    }
+
+    // the deque never moves its elements, the reference outlives the lock
+    const std::string& text(symbol_id id) const {
+        std::shared_lock lock{mutex};
+        return strings[id.value];
+    }
+
+private:
+    interner() {
+        strings.emplace_back();
+        ids.emplace(strings.back(), 0);
+    }
+
+    mutable std::shared_mutex mutex;
+    // deque keeps the stored strings in place, the map keys view them
+    std::deque<std::string> strings;
+    std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+inline symbol_id::symbol_id(std::string_view text) : value(interner::global().intern(text).value) {}
+
+inline const std::string& symbol_id::str() const {
+    return interner::global().text(*this);
+}
+
+inline std::ostream& operator<<(std::ostream& out, symbol_id symbol) {
+    return out << symbol.view();
+}
+
+// names the compiler itself refers to, interned once instead of at every comparison
+namespace well_known {
+inline const symbol_id class_{"Class"};
+inline const symbol_id any_value{"AnyValue"};
+inline const symbol_id any_ref{"AnyRef"};
+inline const symbol_id integer{"Integer"};
+inline const symbol_id real{"Real"};
+inline const symbol_id boolean{"Boolean"};
+inline const symbol_id unit{"Unit"};
+inline const symbol_id array_integer{"ArrayInteger"};
+inline const symbol_id io{"IO"};
+
+// built-in methods the backends lower inline
+inline const symbol_id unary_minus{"UnaryMinus"};
+inline const symbol_id to_real{"toReal"};
+inline const symbol_id to_integer{"toInteger"};
+inline const symbol_id to_boolean{"toBoolean"};
+inline const symbol_id plus{"Plus"};
+inline const symbol_id minus{"Minus"};
+inline const symbol_id mult{"Mult"};
+inline const symbol_id div{"Div"};
+inline const symbol_id rem{"Rem"};
+inline const symbol_id less{"Less"};
+inline const symbol_id less_equal{"LessEqual"};
+inline const symbol_id greater{"Greater"};
+inline const symbol_id greater_equal{"GreaterEqual"};
+inline const symbol_id equal{"Equal"};
+inline const symbol_id not_{"Not"};
+inline const symbol_id and_{"And"};
+inline const symbol_id or_{"Or"};
+inline const symbol_id xor_{"Xor"};
+inline const symbol_id len{"Len"};
+inline const symbol_id get{"Get"};
+inline const symbol_id set{"Set"};
+inline const symbol_id print{"Print"};
+} // namespace well_known
+
+} // namespace common
+
+template<>
+struct std::hash<common::symbol_id> {
+    size_t operator()(common::symbol_id symbol) const noexcept {
+        return std::hash<uint32_t>{}(symbol.id());
+    }
+};
+
+template<>
+struct std::formatter<common::symbol_id> {
+    template<typename ParseContext>
+    constexpr auto parse(ParseContext& ctx) const noexcept {
+        return ctx.begin();
+    }
+
+    template<typename FmtContext>
+    auto format(common::symbol_id symbol, FmtContext& ctx) const noexcept {
+        return std::format_to(ctx.out(), "{}", symbol.view());
+    }
+};
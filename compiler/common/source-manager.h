@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace common {
+
+// Input files of one compilation. Regular files are mapped read-only and never copied; pipes and other streams are read
+// into a buffer. The text keeps its address until the manager is destroyed, so every phase can hold views into it.
+class source_manager {
+public:
+    source_manager() = default;
+    source_manager(const source_manager&) = delete;
+    source_manager& operator=(const source_manager&) = delete;
+
+    ~source_manager() {
+        for (auto& file : files) {
+            if (file.mapped) {
+                ::munmap(const_cast<char*>(file.text.data()), file.text.size());
+            }
+        }
+    }
+
+    // throws std::runtime_error when the file can't be read
+    std::string_view load(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error{std::format("Cannot open '{}': {}\n", path, std::strerror(errno))};
+        }
+        auto& file = files.emplace_back();
+        file.path = path;
+
+        struct stat info{};
+        if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            auto size = static_cast<size_t>(info.st_size);
+            void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                // the lexer reads the file front to back once
+                ::madvise(data, size, MADV_SEQUENTIAL);
+                ::close(fd);
+                file.mapped = true;
+                file.text = std::string_view{static_cast<const char*>(data), size};
+                return file.text;
+            }
+        }
+
+        read_all(fd, path, file.buffer);
+        ::close(fd);
+        file.text = file.buffer;
+        return file.text;
+    }
+
+private:
+    struct source_file {
+        std::string path;
+        std::string_view text;
+        bool mapped = false;
+        // contents of a file that couldn't be mapped
+        std::string buffer;
+    };
+
+    static void read_all(int fd, const std::string& path, std::string& buffer) {
+        constexpr size_t chunk_size = 64 * 1024;
+        size_t size = 0;
+        while (true) {
+            buffer.resize(size + chunk_size);
+            auto count = ::read(fd, buffer.data() + size, chunk_size);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count < 0) {
+                auto error = errno;
+                ::close(fd);
+                throw std::runtime_error{std::format("Cannot read '{}': {}\n", path, std::strerror(error))};
+            }
+            if (count == 0) {
+                break;
+            }
+            size += static_cast<size_t>(count);
+        }
+        buffer.resize(size);
+    }
+
+    // deque: loading another file never moves the buffers of earlier ones
+    std::deque<source_file> files;
+};
+
+} // namespace common
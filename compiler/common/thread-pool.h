@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace common {
+
+// Fixed set of workers, each owning a task deque. run() deals a batch of tasks round-robin over the deques and blocks
+// until all of them finished; a worker takes its own tasks from the back and steals from the front of the others once
+// its deque is empty. With a single thread the tasks run inline, in order.
+class thread_pool {
+public:
+    explicit thread_pool(size_t threads) {
+        if (threads <= 1) {
+            return;
+        }
+        for (size_t i = 0; i < threads; ++i) {
+            queues.push_back(std::make_unique<worker_queue>());
+        }
+        for (size_t i = 0; i < threads; ++i) {
+            workers.emplace_back([this, i] { work(i); });
+        }
+    }
+
+    ~thread_pool() {
+        {
+            std::lock_guard lock{state_mutex};
+            stopping = true;
+        }
+        batch_started.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    size_t size() const {
+        return std::max<size_t>(workers.size(), 1);
+    }
+
+    // the first exception thrown by a task is rethrown here, after the whole batch is done
+    void run(std::vector<std::function<void()>> tasks) {
+        if (workers.empty()) {
+            for (auto& task : tasks) {
+                task();
+            }
+            return;
+        }
+        if (tasks.empty()) {
+            return;
+        }
+
+        {
+            // a worker still draining the previous batch may pick tasks up before they are announced
+            std::lock_guard lock{state_mutex};
+            pending = tasks.size();
+        }
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            auto& queue = *queues[i % queues.size()];
+            std::lock_guard lock{queue.mutex};
+            queue.tasks.push_back(std::move(tasks[i]));
+        }
+        std::unique_lock lock{state_mutex};
+        ++batch;
+        batch_started.notify_all();
+        batch_finished.wait(lock, [this] { return pending == 0; });
+
+        if (auto error = std::exchange(first_error, nullptr)) {
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    struct worker_queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<worker_queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex state_mutex;
+    std::condition_variable batch_started;
+    std::condition_variable batch_finished;
+    size_t batch = 0;
+    size_t pending = 0;
+    bool stopping = false;
+    std::exception_ptr first_error;
+
+    bool take(size_t self, std::function<void()>& task) {
+        {
+            auto& own = *queues[self];
+            std::lock_guard lock{own.mutex};
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (size_t offset = 1; offset < queues.size(); ++offset) {
+            auto& victim = *queues[(self + offset) % queues.size()];
+            std::lock_guard lock{victim.mutex};
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work(size_t self) {
+        size_t seen_batch = 0;
+        while (true) {
+            {
+                std::unique_lock lock{state_mutex};
+                batch_started.wait(lock, [&] { return stopping || batch != seen_batch; });
+                if (stopping) {
+                    return;
+                }
+                seen_batch = batch;
+            }
+
+            std::function<void()> task;
+            while (take(self, task)) {
+                std::exception_ptr error;
+                try {
+                    task();
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                std::lock_guard lock{state_mutex};
+                if (error && !first_error) {
+                    first_error = error;
+                }
+                if (--pending == 0) {
+                    batch_finished.notify_all();
+                }
+            }
+        }
+    }
+};
+
+} // namespace common
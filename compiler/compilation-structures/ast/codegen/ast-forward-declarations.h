@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 namespace codegen::ast {
 
 class visitor;
@@ -35,4 +37,28 @@ class constructor_call_expression;
 class member_expression;
 class grouping_expression;
 
+// one per concrete node class, stored in entity::kind
+enum class node_kind : uint8_t {
+    program,
+    block,
+    class_declaration,
+    field_declaration,
+    variable_declaration,
+    parameter_declaration,
+    method_declaration,
+    constructor_declaration,
+    variable_assignment,
+    field_assignment,
+    while_statement,
+    if_statement,
+    return_statement,
+    literal_expression,
+    this_expression,
+    identifier_expression,
+    method_call_expression,
+    constructor_call_expression,
+    member_expression,
+    grouping_expression,
+};
+
 } // namespace codegen::ast
@@ -1,24 +1,31 @@
 #include "compiler/compilation-structures/ast/codegen/ast.h"
 
 #include <utility>
+#include <variant>
 
 namespace codegen::ast {
 
 // program
-program::program(std::vector<std::unique_ptr<class_declaration>> cls)
-    : classes(std::move(cls)) {}
-program::~program() = default;
+program::program()
+    : entity(static_kind),
+      classes(common::arena_allocator<std::unique_ptr<class_declaration>>{nodes.resource()}) {}
+program::~program() {
+    for (auto& cls : classes) {
+        cls.release();
+    }
+}
 void program::accept(visitor& v) {
     v.visit(*this);
 }
 
 // class_declaration
-class_declaration::class_declaration(std::string name,
+class_declaration::class_declaration(common::symbol_id name,
                                      class_declaration* base_class,
-                                     std::vector<std::unique_ptr<field_declaration>> fields,
-                                     std::vector<std::unique_ptr<method_declaration>> methods,
-                                     std::vector<std::unique_ptr<constructor_declaration>> constructors)
-    : name(std::move(name)),
+                                     common::arena_vector<std::unique_ptr<field_declaration>> fields,
+                                     common::arena_vector<std::unique_ptr<method_declaration>> methods,
+                                     common::arena_vector<std::unique_ptr<constructor_declaration>> constructors)
+    : declaration(static_kind),
+      name(std::move(name)),
       base_class(base_class),
       fields(std::move(fields)),
       methods(std::move(methods)),
@@ -29,8 +36,9 @@ void class_declaration::accept(visitor& v) {
 }
 
 // field_declaration
-field_declaration::field_declaration(std::string name, std::unique_ptr<expression> init, class_declaration* type, class_declaration* owner)
-    : name(std::move(name)),
+field_declaration::field_declaration(common::symbol_id name, std::unique_ptr<expression> init, class_declaration* type, class_declaration* owner)
+    : statement(static_kind),
+      name(std::move(name)),
       initializer(std::move(init)),
       type(type),
       class_owner(owner) {}
@@ -40,12 +48,13 @@ void field_declaration::accept(visitor& v) {
 }
 
 // method_declaration
-method_declaration::method_declaration(std::string name,
-                                       std::vector<std::unique_ptr<parameter_declaration>> params,
+method_declaration::method_declaration(common::symbol_id name,
+                                       common::arena_vector<std::unique_ptr<parameter_declaration>> params,
                                        class_declaration* ret_type,
                                        std::optional<std::variant<std::unique_ptr<block>, std::unique_ptr<expression>>> body,
                                        class_declaration* owner)
-    : name(std::move(name)),
+    : declaration(static_kind),
+      name(std::move(name)),
       parameters(std::move(params)),
       return_type(ret_type),
       body(std::move(body)),
@@ -56,8 +65,9 @@ void method_declaration::accept(visitor& v) {
 }
 
 // constructor_declaration
-constructor_declaration::constructor_declaration(std::vector<std::unique_ptr<parameter_declaration>> params, std::unique_ptr<block> body)
-    : parameters(std::move(params)),
+constructor_declaration::constructor_declaration(common::arena_vector<std::unique_ptr<parameter_declaration>> params, std::unique_ptr<block> body)
+    : declaration(static_kind),
+      parameters(std::move(params)),
       body(std::move(body)) {}
 constructor_declaration::~constructor_declaration() = default;
 void constructor_declaration::accept(visitor& v) {
@@ -65,8 +75,9 @@ void constructor_declaration::accept(visitor& v) {
 }
 
 // parameter_declaration
-parameter_declaration::parameter_declaration(std::string n, class_declaration* t)
-    : name(std::move(n)),
+parameter_declaration::parameter_declaration(common::symbol_id n, class_declaration* t)
+    : declaration(static_kind),
+      name(std::move(n)),
       type(t) {}
 parameter_declaration::~parameter_declaration() = default;
 void parameter_declaration::accept(visitor& v) {
@@ -74,8 +85,9 @@ void parameter_declaration::accept(visitor& v) {
 }
 
 // variable_declaration
-variable_declaration::variable_declaration(std::string name, std::unique_ptr<expression> init, class_declaration* type)
-    : name(std::move(name)),
+variable_declaration::variable_declaration(common::symbol_id name, std::unique_ptr<expression> init, class_declaration* type)
+    : statement(static_kind),
+      name(std::move(name)),
       initializer(std::move(init)),
       type(type) {}
 variable_declaration::~variable_declaration() = default;
@@ -87,7 +99,8 @@ void variable_declaration::accept(visitor& v) {
 variable_assignment::variable_assignment(std::variant<variable_declaration*, parameter_declaration*, field_declaration*> target,
                                          std::unique_ptr<expression> value,
                                          class_declaration* expr_type)
-    : target(target),
+    : statement(static_kind),
+      target(target),
       value(std::move(value)),
       expression_type(expr_type) {}
 variable_assignment::~variable_assignment() = default;
@@ -97,7 +110,8 @@ void variable_assignment::accept(visitor& v) {
 
 // field_assignment
 field_assignment::field_assignment(std::unique_ptr<member_expression> target, std::unique_ptr<expression> value, class_declaration* expr_type)
-    : target(std::move(target)),
+    : statement(static_kind),
+      target(std::move(target)),
       value(std::move(value)),
       expression_type(expr_type) {}
 field_assignment::~field_assignment() = default;
@@ -107,7 +121,8 @@ void field_assignment::accept(visitor& v) {
 
 // while_statement
 while_statement::while_statement(std::unique_ptr<expression> cond, std::unique_ptr<block> body)
-    : condition(std::move(cond)),
+    : statement(static_kind),
+      condition(std::move(cond)),
       body(std::move(body)) {}
 while_statement::~while_statement() = default;
 void while_statement::accept(visitor& v) {
@@ -116,7 +131,8 @@ void while_statement::accept(visitor& v) {
 
 // if_statement
 if_statement::if_statement(std::unique_ptr<expression> cond, std::unique_ptr<block> t, std::unique_ptr<block> f)
-    : condition(std::move(cond)),
+    : statement(static_kind),
+      condition(std::move(cond)),
       true_branch(std::move(t)),
       false_branch(std::move(f)) {}
 if_statement::~if_statement() = default;
@@ -126,7 +142,8 @@ void if_statement::accept(visitor& v) {
 
 // return_statement
 return_statement::return_statement(std::unique_ptr<expression> v, class_declaration* expr_type)
-    : value(std::move(v)),
+    : statement(static_kind),
+      value(std::move(v)),
       expression_type(expr_type) {}
 return_statement::~return_statement() = default;
 void return_statement::accept(visitor& v) {
@@ -135,14 +152,20 @@ void return_statement::accept(visitor& v) {
 
 // literal_expression
 literal_expression::literal_expression(int64_t v, class_declaration* type)
-    : type(type),
-      value(v) {}
+    : expression(static_kind),
+      value(v) {
+    this->type = type;
+}
 literal_expression::literal_expression(double v, class_declaration* type)
-    : type(type),
-      value(v) {}
+    : expression(static_kind),
+      value(v) {
+    this->type = type;
+}
 literal_expression::literal_expression(bool v, class_declaration* type)
-    : type(type),
-      value(v) {}
+    : expression(static_kind),
+      value(v) {
+    this->type = type;
+}
 literal_expression::~literal_expression() = default;
 void literal_expression::accept(visitor& v) {
     v.visit(*this);
@@ -150,7 +173,9 @@ void literal_expression::accept(visitor& v) {
 
 // this_expression
 this_expression::this_expression(class_declaration* type)
-    : type(type) {}
+    : expression(static_kind) {
+    this->type = type;
+}
 this_expression::~this_expression() = default;
 void this_expression::accept(visitor& v) {
     v.visit(*this);
@@ -158,7 +183,10 @@ void this_expression::accept(visitor& v) {
 
 // identifier_expression
 identifier_expression::identifier_expression(std::variant<variable_declaration*, parameter_declaration*, field_declaration*> target)
-    : target(target) {}
+    : expression(static_kind),
+      target(target) {
+    type = std::visit([](auto* declaration) { return declaration->type; }, target);
+}
 identifier_expression::~identifier_expression() = default;
 void identifier_expression::accept(visitor& v) {
     v.visit(*this);
@@ -167,21 +195,26 @@ void identifier_expression::accept(visitor& v) {
 // method_call_expression
 method_call_expression::method_call_expression(std::unique_ptr<expression> obj,
                                                method_declaration* method,
-                                               std::vector<std::unique_ptr<expression>> args,
+                                               common::arena_vector<std::unique_ptr<expression>> args,
                                                class_declaration* ret_type)
-    : object(std::move(obj)),
+    : expression(static_kind),
+      object(std::move(obj)),
       method(method),
-      arguments(std::move(args)),
-      return_type(ret_type) {}
+      arguments(std::move(args)) {
+    type = ret_type;
+}
 method_call_expression::~method_call_expression() = default;
 void method_call_expression::accept(visitor& v) {
     v.visit(*this);
 }
 
 // constructor_call_expression
-constructor_call_expression::constructor_call_expression(constructor_declaration* ctor, std::vector<std::unique_ptr<expression>> args)
-    : constructor(ctor),
-      arguments(std::move(args)) {}
+constructor_call_expression::constructor_call_expression(constructor_declaration* ctor, common::arena_vector<std::unique_ptr<expression>> args)
+    : expression(static_kind),
+      constructor(ctor),
+      arguments(std::move(args)) {
+    type = ctor->class_owner;
+}
 constructor_call_expression::~constructor_call_expression() = default;
 void constructor_call_expression::accept(visitor& v) {
     v.visit(*this);
@@ -189,8 +222,11 @@ void constructor_call_expression::accept(visitor& v) {
 
 // member_expression
 member_expression::member_expression(std::unique_ptr<expression> obj, field_declaration* member)
-    : object(std::move(obj)),
-      member(member) {}
+    : expression(static_kind),
+      object(std::move(obj)),
+      member(member) {
+    type = member->type;
+}
 member_expression::~member_expression() = default;
 void member_expression::accept(visitor& v) {
     v.visit(*this);
@@ -198,15 +234,19 @@ void member_expression::accept(visitor& v) {
 
 // grouping_expression
 grouping_expression::grouping_expression(std::unique_ptr<expression> expr)
-    : inner(std::move(expr)) {}
+    : expression(static_kind),
+      inner(std::move(expr)) {
+    type = inner->type;
+}
 grouping_expression::~grouping_expression() = default;
 void grouping_expression::accept(visitor& v) {
     v.visit(*this);
 }
 
 // block
-block::block(std::vector<std::unique_ptr<entity>> items)
-    : items(std::move(items)) {}
+block::block(common::arena_vector<std::unique_ptr<entity>> items)
+    : entity(static_kind),
+      items(std::move(items)) {}
 block::~block() = default;
 void block::accept(visitor& v) {
     v.visit(*this);
@@ -3,76 +3,111 @@
 #include <cstdint>
 #include <memory>
 #include <optional>
-#include <string>
+#include <span>
+#include <type_traits>
 #include <variant>
-#include <vector>
 
+#include "compiler/common/arena.h"
+#include "compiler/common/interner.h"
 #include "compiler/compilation-structures/ast/codegen/ast-forward-declarations.h"
 #include "compiler/compilation-structures/ast/codegen/ast-visitor.h"
 
 namespace codegen::ast {
 
-struct entity {
+// nodes live in the arena of their program, see program::nodes
+struct entity : public common::arena_node {
+    // concrete class of the node, see node_cast
+    const node_kind kind;
+
+    explicit entity(node_kind kind) : kind(kind) {}
     virtual ~entity() = default;
     virtual void accept(visitor& visitor) = 0;
 };
 
-struct declaration : public entity {};
-struct statement : public entity {};
-struct expression : public entity {};
+struct declaration : public entity {
+    using entity::entity;
+};
+struct statement : public entity {
+    using entity::entity;
+};
+struct expression : public entity {
+    using entity::entity;
+
+    // static type of the value, set when the node is built
+    class_declaration* type = nullptr;
+};
 
 struct program : public entity {
-    std::vector<std::unique_ptr<class_declaration>> internal_classes;
-    std::vector<std::unique_ptr<class_declaration>> classes;
+    static constexpr node_kind static_kind = node_kind::program;
+
+    // memory of every other node of the tree; the semantic phases build the tree inside scopes of it
+    common::arena nodes;
+    // the built-in classes, shared by every program, see builtin::codegen_classes
+    std::span<class_declaration* const> internal_classes;
+    common::arena_vector<std::unique_ptr<class_declaration>> classes;
 
-    program() = default;
-    explicit program(std::vector<std::unique_ptr<class_declaration>> cls);
+    program();
+    // drops the whole tree with the arena, without running the node destructors
     ~program() override;
 
+    // the root is the only node on the heap, it owns the arena
+    static void* operator new(size_t size) {
+        return ::operator new(size);
+    }
+    static void operator delete(void* pointer) noexcept {
+        ::operator delete(pointer);
+    }
+
     void accept(visitor& visitor) override;
 };
 
 struct class_declaration : public declaration {
-    std::string name;
+    static constexpr node_kind static_kind = node_kind::class_declaration;
+
+    common::symbol_id name;
     class_declaration* base_class;
-    std::vector<std::unique_ptr<field_declaration>> fields;
-    std::vector<std::unique_ptr<method_declaration>> methods;
-    std::vector<std::unique_ptr<constructor_declaration>> constructors;
+    common::arena_vector<std::unique_ptr<field_declaration>> fields;
+    common::arena_vector<std::unique_ptr<method_declaration>> methods;
+    common::arena_vector<std::unique_ptr<constructor_declaration>> constructors;
 
-    class_declaration() = default;
-    explicit class_declaration(std::string name,
+    class_declaration() : declaration(static_kind) {}
+    explicit class_declaration(common::symbol_id name,
                                class_declaration* base_class,
-                               std::vector<std::unique_ptr<field_declaration>> fields,
-                               std::vector<std::unique_ptr<method_declaration>> methods,
-                               std::vector<std::unique_ptr<constructor_declaration>> constructors);
+                               common::arena_vector<std::unique_ptr<field_declaration>> fields,
+                               common::arena_vector<std::unique_ptr<method_declaration>> methods,
+                               common::arena_vector<std::unique_ptr<constructor_declaration>> constructors);
     ~class_declaration() override;
 
     void accept(visitor& visitor) override;
 };
 
 struct field_declaration : public statement {
-    std::string name;
+    static constexpr node_kind static_kind = node_kind::field_declaration;
+
+    common::symbol_id name;
     std::unique_ptr<expression> initializer;
     class_declaration* type;
     class_declaration* class_owner;
 
-    field_declaration() = default;
-    explicit field_declaration(std::string name, std::unique_ptr<expression> init, class_declaration* type, class_declaration* owner);
+    field_declaration() : statement(static_kind) {}
+    explicit field_declaration(common::symbol_id name, std::unique_ptr<expression> init, class_declaration* type, class_declaration* owner);
     ~field_declaration() override;
 
     void accept(visitor& visitor) override;
 };
 
 struct method_declaration : public declaration {
-    std::string name;
-    std::vector<std::unique_ptr<parameter_declaration>> parameters;
+    static constexpr node_kind static_kind = node_kind::method_declaration;
+
+    common::symbol_id name;
+    common::arena_vector<std::unique_ptr<parameter_declaration>> parameters;
     class_declaration* return_type;
     std::optional<std::variant<std::unique_ptr<block>, std::unique_ptr<expression>>> body;
     class_declaration* class_owner;
 
-    method_declaration() = default;
-    explicit method_declaration(std::string name,
-                                std::vector<std::unique_ptr<parameter_declaration>> params,
+    method_declaration() : declaration(static_kind) {}
+    explicit method_declaration(common::symbol_id name,
+                                common::arena_vector<std::unique_ptr<parameter_declaration>> params,
                                 class_declaration* ret_type,
                                 std::optional<std::variant<std::unique_ptr<block>, std::unique_ptr<expression>>> body,
                                 class_declaration* owner);
@@ -82,47 +117,55 @@ struct method_declaration : public declaration {
 };
 
 struct constructor_declaration : public declaration {
-    std::vector<std::unique_ptr<parameter_declaration>> parameters;
+    static constexpr node_kind static_kind = node_kind::constructor_declaration;
+
+    common::arena_vector<std::unique_ptr<parameter_declaration>> parameters;
     std::unique_ptr<constructor_call_expression> super_constructor;
     std::unique_ptr<block> body;
     class_declaration* class_owner;
 
-    constructor_declaration() = default;
-    explicit constructor_declaration(std::vector<std::unique_ptr<parameter_declaration>> params, std::unique_ptr<block> body);
+    constructor_declaration() : declaration(static_kind) {}
+    explicit constructor_declaration(common::arena_vector<std::unique_ptr<parameter_declaration>> params, std::unique_ptr<block> body);
     ~constructor_declaration() override;
 
     void accept(visitor& visitor) override;
 };
 
 struct parameter_declaration : public declaration {
-    std::string name;
+    static constexpr node_kind static_kind = node_kind::parameter_declaration;
+
+    common::symbol_id name;
     class_declaration* type;
 
-    parameter_declaration() = default;
-    explicit parameter_declaration(std::string n, class_declaration* t);
+    parameter_declaration() : declaration(static_kind) {}
+    explicit parameter_declaration(common::symbol_id n, class_declaration* t);
     ~parameter_declaration() override;
 
     void accept(visitor& visitor) override;
 };
 
 struct variable_declaration : public statement {
-    std::string name;
+    static constexpr node_kind static_kind = node_kind::variable_declaration;
+
+    common::symbol_id name;
     std::unique_ptr<expression> initializer;
     class_declaration* type;
 
-    variable_declaration() = default;
-    explicit variable_declaration(std::string name, std::unique_ptr<expression> init, class_declaration* type);
+    variable_declaration() : statement(static_kind) {}
+    explicit variable_declaration(common::symbol_id name, std::unique_ptr<expression> init, class_declaration* type);
     ~variable_declaration() override;
 
     void accept(visitor& visitor) override;
 };
 
 struct variable_assignment : public statement {
+    static constexpr node_kind static_kind = node_kind::variable_assignment;
+
     std::variant<variable_declaration*, parameter_declaration*, field_declaration*> target;
     std::unique_ptr<expression> value;
     class_declaration* expression_type;
 
-    variable_assignment() = default;
+    variable_assignment() : statement(static_kind) {}
     explicit variable_assignment(std::variant<variable_declaration*, parameter_declaration*, field_declaration*> target,
                                  std::unique_ptr<expression> value,
                                  class_declaration* expr_type);
@@ -131,11 +174,13 @@ struct variable_assignment : public statement {
 };
 
 struct field_assignment : public statement {
+    static constexpr node_kind static_kind = node_kind::field_assignment;
+
     std::unique_ptr<member_expression> target;
     std::unique_ptr<expression> value;
     class_declaration* expression_type;
 
-    field_assignment() = default;
+    field_assignment() : statement(static_kind) {}
     explicit field_assignment(std::unique_ptr<member_expression> target, std::unique_ptr<expression> value, class_declaration* expr_type);
     ~field_assignment() override;
     void accept(visitor& visitor) override;
@@ -143,10 +188,12 @@ struct field_assignment : public statement {
 
 struct while_statement : public statement {
 public:
+    static constexpr node_kind static_kind = node_kind::while_statement;
+
     std::unique_ptr<expression> condition;
     std::unique_ptr<block> body;
 
-    while_statement() = default;
+    while_statement() : statement(static_kind) {}
     while_statement(std::unique_ptr<expression> cond, std::unique_ptr<block> body);
     ~while_statement() override;
 
@@ -155,11 +202,13 @@ public:
 
 struct if_statement : public statement {
 public:
+    static constexpr node_kind static_kind = node_kind::if_statement;
+
     std::unique_ptr<expression> condition;
     std::unique_ptr<block> true_branch;
     std::unique_ptr<block> false_branch;
 
-    if_statement() = default;
+    if_statement() : statement(static_kind) {}
     if_statement(std::unique_ptr<expression> cond, std::unique_ptr<block> t, std::unique_ptr<block> f);
     ~if_statement() override;
 
@@ -167,10 +216,12 @@ public:
 };
 
 struct return_statement : public statement {
+    static constexpr node_kind static_kind = node_kind::return_statement;
+
     std::unique_ptr<expression> value;
     class_declaration* expression_type;
 
-    return_statement() = default;
+    return_statement() : statement(static_kind) {}
     explicit return_statement(std::unique_ptr<expression> v, class_declaration* expr_type);
     ~return_statement() override;
 
@@ -178,10 +229,11 @@ struct return_statement : public statement {
 };
 
 struct literal_expression : public expression {
-    class_declaration* type;
+    static constexpr node_kind static_kind = node_kind::literal_expression;
+
     std::variant<int64_t, double, bool> value;
 
-    literal_expression() = default;
+    literal_expression() : expression(static_kind) {}
     literal_expression(int64_t v, class_declaration* type);
     literal_expression(double v, class_declaration* type);
     literal_expression(bool v, class_declaration* type);
@@ -191,9 +243,9 @@ struct literal_expression : public expression {
 };
 
 struct this_expression : public expression {
-    class_declaration* type;
+    static constexpr node_kind static_kind = node_kind::this_expression;
 
-    this_expression() = default;
+    this_expression() : expression(static_kind) {}
     explicit this_expression(class_declaration* type);
     ~this_expression() override;
 
@@ -201,9 +253,11 @@ struct this_expression : public expression {
 };
 
 struct identifier_expression : public expression {
+    static constexpr node_kind static_kind = node_kind::identifier_expression;
+
     std::variant<variable_declaration*, parameter_declaration*, field_declaration*> target;
 
-    identifier_expression() = default;
+    identifier_expression() : expression(static_kind) {}
     explicit identifier_expression(std::variant<variable_declaration*, parameter_declaration*, field_declaration*> target);
     ~identifier_expression() override;
 
@@ -211,15 +265,16 @@ struct identifier_expression : public expression {
 };
 
 struct method_call_expression : public expression {
+    static constexpr node_kind static_kind = node_kind::method_call_expression;
+
     std::unique_ptr<expression> object;
     method_declaration* method;
-    std::vector<std::unique_ptr<expression>> arguments;
-    class_declaration* return_type;
+    common::arena_vector<std::unique_ptr<expression>> arguments;
 
-    method_call_expression() = default;
+    method_call_expression() : expression(static_kind) {}
     explicit method_call_expression(std::unique_ptr<expression> obj,
                                     method_declaration* method,
-                                    std::vector<std::unique_ptr<expression>> args,
+                                    common::arena_vector<std::unique_ptr<expression>> args,
                                     class_declaration* ret_type);
     ~method_call_expression() override;
 
@@ -227,21 +282,25 @@ struct method_call_expression : public expression {
 };
 
 struct constructor_call_expression : public expression {
+    static constexpr node_kind static_kind = node_kind::constructor_call_expression;
+
     constructor_declaration* constructor;
-    std::vector<std::unique_ptr<expression>> arguments;
+    common::arena_vector<std::unique_ptr<expression>> arguments;
 
-    constructor_call_expression() = default;
-    explicit constructor_call_expression(constructor_declaration* ctor, std::vector<std::unique_ptr<expression>> args);
+    constructor_call_expression() : expression(static_kind) {}
+    explicit constructor_call_expression(constructor_declaration* ctor, common::arena_vector<std::unique_ptr<expression>> args);
     ~constructor_call_expression() override;
 
     void accept(visitor& visitor) override;
 };
 
 struct member_expression : public expression {
+    static constexpr node_kind static_kind = node_kind::member_expression;
+
     std::unique_ptr<expression> object;
     field_declaration* member;
 
-    member_expression() = default;
+    member_expression() : expression(static_kind) {}
     member_expression(std::unique_ptr<expression> obj, field_declaration* member);
     ~member_expression() override;
 
@@ -250,9 +309,11 @@ struct member_expression : public expression {
 
 struct grouping_expression : public expression {
 public:
+    static constexpr node_kind static_kind = node_kind::grouping_expression;
+
     std::unique_ptr<expression> inner;
 
-    grouping_expression() = default;
+    grouping_expression() : expression(static_kind) {}
     explicit grouping_expression(std::unique_ptr<expression> expr);
     ~grouping_expression() override;
 
@@ -261,12 +322,22 @@ public:
 
 struct block : public entity {
 public:
-    std::vector<std::unique_ptr<entity>> items;
+    static constexpr node_kind static_kind = node_kind::block;
 
-    block() = default;
-    explicit block(std::vector<std::unique_ptr<entity>> items);
+    common::arena_vector<std::unique_ptr<entity>> items;
+
+    block() : entity(static_kind) {}
+    explicit block(common::arena_vector<std::unique_ptr<entity>> items);
     ~block() override;
 
     void accept(visitor& visitor) override;
 };
+
+// Downcast checked against the kind tag instead of RTTI; nullptr when `node` is null or another kind of node.
+template<typename T, typename Node>
+auto* node_cast(Node* node) noexcept {
+    using result = std::conditional_t<std::is_const_v<Node>, const T, T>;
+    return node != nullptr && node->kind == T::static_kind ? static_cast<result*>(node) : nullptr;
+}
+
 } // namespace codegen::ast
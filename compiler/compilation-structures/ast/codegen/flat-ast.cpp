@@ -0,0 +1,274 @@
+#include "compiler/compilation-structures/ast/codegen/flat-ast.h"
+
+#include <cassert>
+#include <stdexcept>
+#include <variant>
+
+#include "compiler/common/variant-helper.h"
+
+namespace codegen::ast::flat {
+
+namespace {
+
+// Numbers the declarations of the tree, then appends the nodes of every body in pre-order. A node's slot is taken
+// before its children are flattened, the children then fill it in.
+class flattener : public visitor {
+public:
+    explicit flattener(program& out) : out(out) {}
+
+    void visit(ast::program& node) override {
+        for (auto& cls : node.internal_classes) {
+            add_declarations(*cls);
+        }
+        out.internal_class_count = static_cast<uint32_t>(out.classes.size());
+        for (auto& cls : node.classes) {
+            add_declarations(*cls);
+        }
+
+        for (const auto& cls : out.classes) {
+            for (size_t i = 0; i < cls.declaration->fields.size(); ++i) {
+                out.fields[cls.first_field + i].initializer = flatten(cls.declaration->fields[i]->initializer.get());
+            }
+            for (size_t i = 0; i < cls.declaration->methods.size(); ++i) {
+                auto& method = *cls.declaration->methods[i];
+                if (method.body.has_value()) {
+                    out.methods[cls.first_method + i].body = std::visit([this](auto& body) { return flatten(body.get()); }, *method.body);
+                }
+            }
+            for (size_t i = 0; i < cls.declaration->constructors.size(); ++i) {
+                auto& ctor = *cls.declaration->constructors[i];
+                auto& entry = out.constructors[cls.first_constructor + i];
+                entry.super_call = flatten(ctor.super_constructor.get());
+                entry.body = flatten(ctor.body.get());
+            }
+        }
+    }
+
+    void visit(block& node) override {
+        auto index = add_node(node.kind, nullptr);
+        auto items = add_list(node.items.size());
+        for (size_t i = 0; i < node.items.size(); ++i) {
+            out.extra[items + 1 + i] = flatten(node.items[i].get());
+        }
+        out.lhs[index] = items;
+        last = index;
+    }
+
+    void visit(class_declaration&) override {}
+    void visit(field_declaration&) override {}
+    void visit(method_declaration&) override {}
+    void visit(constructor_declaration&) override {}
+    void visit(parameter_declaration&) override {}
+
+    void visit(variable_declaration& node) override {
+        auto variable = add_declaration(node, out.variables);
+        out.variables.push_back(&node);
+        auto index = add_node(node.kind, node.type);
+        out.lhs[index] = variable;
+        out.rhs[index] = flatten(node.initializer.get());
+        last = index;
+    }
+
+    void visit(variable_assignment& node) override {
+        auto index = add_node(node.kind, node.expression_type);
+        out.lhs[index] = target_of(node.target);
+        out.rhs[index] = flatten(node.value.get());
+        last = index;
+    }
+
+    void visit(field_assignment& node) override {
+        auto index = add_node(node.kind, node.expression_type);
+        out.lhs[index] = flatten(node.target.get());
+        out.rhs[index] = flatten(node.value.get());
+        last = index;
+    }
+
+    void visit(while_statement& node) override {
+        auto index = add_node(node.kind, nullptr);
+        out.lhs[index] = flatten(node.condition.get());
+        out.rhs[index] = flatten(node.body.get());
+        last = index;
+    }
+
+    void visit(if_statement& node) override {
+        auto index = add_node(node.kind, nullptr);
+        auto branches = static_cast<uint32_t>(out.extra.size());
+        out.extra.resize(branches + 2, none);
+        out.lhs[index] = flatten(node.condition.get());
+        out.rhs[index] = branches;
+        out.extra[branches] = flatten(node.true_branch.get());
+        out.extra[branches + 1] = flatten(node.false_branch.get());
+        last = index;
+    }
+
+    void visit(return_statement& node) override {
+        auto index = add_node(node.kind, node.expression_type);
+        out.lhs[index] = flatten(node.value.get());
+        last = index;
+    }
+
+    void visit(literal_expression& node) override {
+        auto index = add_node(node.kind, node.type);
+        std::visit(overloaded{[&](int64_t value) {
+                                  out.lhs[index] = static_cast<uint32_t>(literal_kind::integer);
+                                  out.rhs[index] = static_cast<uint32_t>(out.integers.size());
+                                  out.integers.push_back(value);
+                              },
+                              [&](double value) {
+                                  out.lhs[index] = static_cast<uint32_t>(literal_kind::real);
+                                  out.rhs[index] = static_cast<uint32_t>(out.reals.size());
+                                  out.reals.push_back(value);
+                              },
+                              [&](bool value) {
+                                  out.lhs[index] = static_cast<uint32_t>(literal_kind::boolean);
+                                  out.rhs[index] = value ? 1 : 0;
+                              }},
+                   node.value);
+        last = index;
+    }
+
+    void visit(this_expression& node) override {
+        last = add_node(node.kind, node.type);
+    }
+
+    void visit(identifier_expression& node) override {
+        auto index = add_node(node.kind, node.type);
+        out.lhs[index] = target_of(node.target);
+        last = index;
+    }
+
+    void visit(method_call_expression& node) override {
+        auto index = add_node(node.kind, node.type);
+        auto call = static_cast<uint32_t>(out.extra.size());
+        out.extra.push_back(out.index_of(node.method));
+        auto arguments = add_list(node.arguments.size());
+        out.lhs[index] = flatten(node.object.get());
+        out.rhs[index] = call;
+        for (size_t i = 0; i < node.arguments.size(); ++i) {
+            out.extra[arguments + 1 + i] = flatten(node.arguments[i].get());
+        }
+        last = index;
+    }
+
+    void visit(constructor_call_expression& node) override {
+        auto index = add_node(node.kind, node.type);
+        auto arguments = add_list(node.arguments.size());
+        out.lhs[index] = out.index_of(node.constructor);
+        out.rhs[index] = arguments;
+        for (size_t i = 0; i < node.arguments.size(); ++i) {
+            out.extra[arguments + 1 + i] = flatten(node.arguments[i].get());
+        }
+        last = index;
+    }
+
+    void visit(member_expression& node) override {
+        auto index = add_node(node.kind, node.type);
+        out.lhs[index] = flatten(node.object.get());
+        out.rhs[index] = out.index_of(node.member);
+        last = index;
+    }
+
+    void visit(grouping_expression& node) override {
+        auto index = add_node(node.kind, node.type);
+        out.lhs[index] = flatten(node.inner.get());
+        last = index;
+    }
+
+private:
+    program& out;
+    node_index last = none;
+
+    node_index flatten(entity* node) {
+        if (node == nullptr) {
+            return none;
+        }
+        node->accept(*this);
+        return last;
+    }
+
+    node_index add_node(node_kind kind, const class_declaration* type) {
+        auto index = static_cast<node_index>(out.kinds.size());
+        if (index == none) {
+            throw std::runtime_error{"Program has too many statements and expressions\n"};
+        }
+        out.kinds.push_back(kind);
+        out.lhs.push_back(none);
+        out.rhs.push_back(none);
+        out.types.push_back(type == nullptr ? none : out.index_of(type));
+        return index;
+    }
+
+    // the length is stored at the returned offset, the elements are left for the caller
+    uint32_t add_list(size_t length) {
+        auto offset = static_cast<uint32_t>(out.extra.size());
+        out.extra.push_back(static_cast<uint32_t>(length));
+        out.extra.resize(offset + 1 + length, none);
+        return offset;
+    }
+
+    template<typename Table>
+    uint32_t add_declaration(const entity& declaration, const Table& table) {
+        auto index = static_cast<uint32_t>(table.size());
+        assert(index < (1u << 30) && "declaration number doesn't fit a target");
+        out.declaration_indices.emplace(&declaration, index);
+        return index;
+    }
+
+    void add_parameters(const common::arena_vector<std::unique_ptr<parameter_declaration>>& parameters) {
+        for (const auto& parameter : parameters) {
+            add_declaration(*parameter, out.parameters);
+            out.parameters.push_back(parameter.get());
+        }
+    }
+
+    void add_declarations(class_declaration& cls) {
+        auto index = add_declaration(cls, out.classes);
+        out.classes.push_back({&cls,
+                               static_cast<uint32_t>(out.fields.size()),
+                               static_cast<uint32_t>(out.methods.size()),
+                               static_cast<uint32_t>(out.constructors.size())});
+        for (auto& field : cls.fields) {
+            add_declaration(*field, out.fields);
+            out.fields.push_back({field.get(), none});
+        }
+        for (auto& method : cls.methods) {
+            add_declaration(*method, out.methods);
+            out.methods.push_back({method.get(), static_cast<uint32_t>(out.parameters.size()), none});
+            add_parameters(method->parameters);
+        }
+        for (auto& ctor : cls.constructors) {
+            add_declaration(*ctor, out.constructors);
+            out.constructors.push_back({ctor.get(), index, static_cast<uint32_t>(out.parameters.size()), none, none});
+            add_parameters(ctor->parameters);
+        }
+    }
+
+    uint32_t target_of(const std::variant<variable_declaration*, parameter_declaration*, field_declaration*>& target) const {
+        return std::visit(overloaded{[this](variable_declaration* d) { return make_target(target_kind::variable, out.index_of(d)); },
+                                     [this](parameter_declaration* d) { return make_target(target_kind::parameter, out.index_of(d)); },
+                                     [this](field_declaration* d) { return make_target(target_kind::field, out.index_of(d)); }},
+                          target);
+    }
+};
+
+template<typename T>
+size_t capacity_bytes(const std::vector<T>& column) noexcept {
+    return column.capacity() * sizeof(T);
+}
+
+} // namespace
+
+size_t program::bytes_used() const noexcept {
+    return capacity_bytes(kinds) + capacity_bytes(lhs) + capacity_bytes(rhs) + capacity_bytes(types) + capacity_bytes(extra) +
+           capacity_bytes(integers) + capacity_bytes(reals) + capacity_bytes(classes) + capacity_bytes(fields) + capacity_bytes(methods) +
+           capacity_bytes(constructors) + capacity_bytes(parameters) + capacity_bytes(variables);
+}
+
+program flatten(ast::program& tree) {
+    program out;
+    flattener builder{out};
+    tree.accept(builder);
+    return out;
+}
+
+} // namespace codegen::ast::flat
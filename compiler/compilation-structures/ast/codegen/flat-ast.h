@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "compiler/compilation-structures/ast/codegen/ast.h"
+
+namespace codegen::ast::flat {
+
+// Position of a statement or expression in the node columns of a program.
+using node_index = uint32_t;
+// missing node, class or declaration
+inline constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+// What `lhs` and `rhs` of a node hold, by kind:
+//   block                        lhs: list of statements
+//   variable_declaration         lhs: variable, rhs: initializer or none
+//   variable_assignment          lhs: target, rhs: value
+//   field_assignment             lhs: member_expression written to, rhs: value
+//   while_statement              lhs: condition, rhs: body block
+//   if_statement                 lhs: condition, rhs: offset in extra of the true block and the false block or none
+//   return_statement             lhs: value or none
+//   literal_expression           lhs: literal_kind, rhs: index in integers or reals, 0 or 1 for a Boolean
+//   identifier_expression        lhs: target
+//   method_call_expression       lhs: object, rhs: offset in extra of the method followed by the list of arguments
+//   constructor_call_expression  lhs: constructor, rhs: list of arguments
+//   member_expression            lhs: object, rhs: field
+//   grouping_expression          lhs: inner expression
+// A list is an offset in extra where its length is stored, followed by the node indices.
+enum class literal_kind : uint32_t { integer, real, boolean };
+
+// variable, parameter or field an identifier or assignment refers to, in the top two bits of the target
+enum class target_kind : uint32_t { variable, parameter, field };
+
+constexpr uint32_t make_target(target_kind kind, uint32_t index) noexcept {
+    return static_cast<uint32_t>(kind) << 30 | index;
+}
+constexpr target_kind kind_of_target(uint32_t target) noexcept {
+    return static_cast<target_kind>(target >> 30);
+}
+constexpr uint32_t index_of_target(uint32_t target) noexcept {
+    return target & ((1u << 30) - 1);
+}
+
+struct class_entry {
+    class_declaration* declaration;
+    // members of the class are numbered consecutively, in declaration order
+    uint32_t first_field;
+    uint32_t first_method;
+    uint32_t first_constructor;
+};
+
+struct field_entry {
+    field_declaration* declaration;
+    node_index initializer;
+};
+
+struct method_entry {
+    method_declaration* declaration;
+    uint32_t first_parameter;
+    // a block, an expression for `=>` methods, none for built-in methods
+    node_index body;
+};
+
+struct constructor_entry {
+    constructor_declaration* declaration;
+    uint32_t owner;
+    uint32_t first_parameter;
+    node_index super_call;
+    node_index body;
+};
+
+// Statements and expressions of a codegen tree as columns indexed by node: no pointers, no virtual calls, and the nodes
+// of a body are contiguous and in pre-order, so a pass walks memory in order. Declarations stay in the tree and are
+// referred to by their number in the tables below; the tree has to outlive the flat program.
+struct program {
+    std::vector<node_kind> kinds;
+    std::vector<uint32_t> lhs;
+    std::vector<uint32_t> rhs;
+    // class of the value of an expression, declared class of a variable, class of an assigned or returned value
+    std::vector<uint32_t> types;
+    // lists and operands that don't fit lhs/rhs
+    std::vector<uint32_t> extra;
+    std::vector<int64_t> integers;
+    std::vector<double> reals;
+
+    // internal classes come first
+    std::vector<class_entry> classes;
+    uint32_t internal_class_count = 0;
+    std::vector<field_entry> fields;
+    std::vector<method_entry> methods;
+    std::vector<constructor_entry> constructors;
+    std::vector<parameter_declaration*> parameters;
+    std::vector<variable_declaration*> variables;
+
+    size_t size() const noexcept {
+        return kinds.size();
+    }
+
+    std::span<const uint32_t> list(uint32_t offset) const noexcept {
+        return {extra.data() + offset + 1, extra[offset]};
+    }
+
+    class_declaration* type(node_index node) const noexcept {
+        return types[node] == none ? nullptr : classes[types[node]].declaration;
+    }
+
+    // number of a class, field, method, constructor, parameter or variable in its table
+    uint32_t index_of(const entity* declaration) const {
+        return declaration_indices.at(declaration);
+    }
+
+    // heap bytes of the columns and tables
+    size_t bytes_used() const noexcept;
+
+    std::unordered_map<const entity*, uint32_t> declaration_indices;
+};
+
+program flatten(ast::program& tree);
+
+} // namespace codegen::ast::flat
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 namespace ast {
 
 class visitor;
@@ -35,4 +37,25 @@ class member_expression;
 class call_expression;
 class grouping_expression;
 
+// one per concrete node class, stored in entity::kind
+enum class node_kind : uint8_t {
+    program,
+    block,
+    class_declaration,
+    variable_declaration,
+    parameter_declaration,
+    method_declaration,
+    constructor_declaration,
+    assignment_statement,
+    while_statement,
+    if_statement,
+    return_statement,
+    literal_expression,
+    this_expression,
+    identifier_expression,
+    member_expression,
+    call_expression,
+    grouping_expression,
+};
+
 } // namespace ast
@@ -1,22 +1,21 @@
 #include "ast.h"
 
 #include <memory>
-#include <string>
 #include <utility>
-#include <vector>
 
 #include "ast-visitor.h"
 
 namespace ast {
 
 // class_declaration
-class_declaration::class_declaration(std::string name,
-                                     std::vector<std::string> type_parameters,
-                                     std::optional<std::string> base_class,
-                                     std::vector<std::unique_ptr<variable_declaration>> fields,
-                                     std::vector<std::unique_ptr<method_declaration>> methods,
-                                     std::vector<std::unique_ptr<constructor_declaration>> constructors)
-    : name(std::move(name)),
+class_declaration::class_declaration(common::symbol_id name,
+                                     common::arena_vector<common::symbol_id> type_parameters,
+                                     std::optional<common::symbol_id> base_class,
+                                     common::arena_vector<std::unique_ptr<variable_declaration>> fields,
+                                     common::arena_vector<std::unique_ptr<method_declaration>> methods,
+                                     common::arena_vector<std::unique_ptr<constructor_declaration>> constructors)
+    : declaration(static_kind),
+      name(std::move(name)),
       type_parameters(std::move(type_parameters)),
       base_class(std::move(base_class)),
       fields(std::move(fields)),
@@ -28,8 +27,9 @@ void class_declaration::accept(visitor& v) {
 }
 
 // variable_declaration
-variable_declaration::variable_declaration(std::string name, std::unique_ptr<expression> init)
-    : name(std::move(name)),
+variable_declaration::variable_declaration(common::symbol_id name, std::unique_ptr<expression> init)
+    : statement(static_kind),
+      name(std::move(name)),
       initializer(std::move(init)) {}
 variable_declaration::~variable_declaration() = default;
 void variable_declaration::accept(visitor& v) {
@@ -37,8 +37,9 @@ void variable_declaration::accept(visitor& v) {
 }
 
 // parameter_declaration
-parameter_declaration::parameter_declaration(std::string n, std::string t)
-    : name(std::move(n)),
+parameter_declaration::parameter_declaration(common::symbol_id n, common::symbol_id t)
+    : declaration(static_kind),
+      name(std::move(n)),
       type_name(std::move(t)) {}
 parameter_declaration::~parameter_declaration() = default;
 void parameter_declaration::accept(visitor& v) {
@@ -46,11 +47,12 @@ void parameter_declaration::accept(visitor& v) {
 }
 
 // method_declaration
-method_declaration::method_declaration(std::string name,
-                                       std::vector<std::unique_ptr<parameter_declaration>> params,
-                                       std::optional<std::string> ret,
+method_declaration::method_declaration(common::symbol_id name,
+                                       common::arena_vector<std::unique_ptr<parameter_declaration>> params,
+                                       std::optional<common::symbol_id> ret,
                                        std::optional<std::variant<std::unique_ptr<block>, std::unique_ptr<expression>>> body)
-    : name(std::move(name)),
+    : declaration(static_kind),
+      name(std::move(name)),
       parameters(std::move(params)),
       return_type(std::move(ret)),
       body(std::move(body)) {}
@@ -60,10 +62,11 @@ void method_declaration::accept(visitor& v) {
 }
 
 // constructor_declaration
-constructor_declaration::constructor_declaration(std::vector<std::unique_ptr<parameter_declaration>> params,
-                                                 std::optional<std::vector<std::unique_ptr<expression>>> super_params,
+constructor_declaration::constructor_declaration(common::arena_vector<std::unique_ptr<parameter_declaration>> params,
+                                                 std::optional<common::arena_vector<std::unique_ptr<expression>>> super_params,
                                                  std::unique_ptr<block> body)
-    : parameters(std::move(params)),
+    : declaration(static_kind),
+      parameters(std::move(params)),
       super_parameters(std::move(super_params)),
       body(std::move(body)) {}
 constructor_declaration::~constructor_declaration() = default;
@@ -72,8 +75,9 @@ void constructor_declaration::accept(visitor& v) {
 }
 
 // assignment_statement
-assignment_statement::assignment_statement(std::string t, std::unique_ptr<expression> v)
-    : target(std::move(t)),
+assignment_statement::assignment_statement(common::symbol_id t, std::unique_ptr<expression> v)
+    : statement(static_kind),
+      target(std::move(t)),
       value(std::move(v)) {}
 assignment_statement::~assignment_statement() = default;
 void assignment_statement::accept(visitor& v) {
@@ -82,7 +86,8 @@ void assignment_statement::accept(visitor& v) {
 
 // while_statement
 while_statement::while_statement(std::unique_ptr<expression> cond, std::unique_ptr<block> body)
-    : condition(std::move(cond)),
+    : statement(static_kind),
+      condition(std::move(cond)),
       body(std::move(body)) {}
 while_statement::~while_statement() = default;
 void while_statement::accept(visitor& v) {
@@ -91,7 +96,8 @@ void while_statement::accept(visitor& v) {
 
 // if_statement
 if_statement::if_statement(std::unique_ptr<expression> cond, std::unique_ptr<block> t, std::unique_ptr<block> f)
-    : condition(std::move(cond)),
+    : statement(static_kind),
+      condition(std::move(cond)),
       true_branch(std::move(t)),
       false_branch(std::move(f)) {}
 if_statement::~if_statement() = default;
@@ -101,7 +107,8 @@ void if_statement::accept(visitor& v) {
 
 // return_statement
 return_statement::return_statement(std::unique_ptr<expression> v)
-    : value(std::move(v)) {}
+    : statement(static_kind),
+      value(std::move(v)) {}
 return_statement::~return_statement() = default;
 void return_statement::accept(visitor& v) {
     v.visit(*this);
@@ -109,13 +116,16 @@ void return_statement::accept(visitor& v) {
 
 // literal_expression
 literal_expression::literal_expression(int64_t v)
-    : type(type::integer),
+    : expression(static_kind),
+      type(type::integer),
       value(v) {}
 literal_expression::literal_expression(double v)
-    : type(type::real),
+    : expression(static_kind),
+      type(type::real),
       value(v) {}
 literal_expression::literal_expression(bool v)
-    : type(type::boolean),
+    : expression(static_kind),
+      type(type::boolean),
       value(v) {}
 literal_expression::~literal_expression() = default;
 void literal_expression::accept(visitor& v) {
@@ -129,16 +139,18 @@ void this_expression::accept(visitor& v) {
 }
 
 // identifier_expression
-identifier_expression::identifier_expression(std::string n)
-    : name(std::move(n)) {}
+identifier_expression::identifier_expression(common::symbol_id n)
+    : expression(static_kind),
+      name(std::move(n)) {}
 identifier_expression::~identifier_expression() = default;
 void identifier_expression::accept(visitor& v) {
     v.visit(*this);
 }
 
 // member_expression
-member_expression::member_expression(std::unique_ptr<expression> obj, std::string mem)
-    : object(std::move(obj)),
+member_expression::member_expression(std::unique_ptr<expression> obj, common::symbol_id mem)
+    : expression(static_kind),
+      object(std::move(obj)),
       member(std::move(mem)) {}
 member_expression::~member_expression() = default;
 void member_expression::accept(visitor& v) {
@@ -146,8 +158,9 @@ void member_expression::accept(visitor& v) {
 }
 
 // call_expression
-call_expression::call_expression(std::unique_ptr<expression> c, std::vector<std::unique_ptr<expression>> args)
-    : callee(std::move(c)),
+call_expression::call_expression(std::unique_ptr<expression> c, common::arena_vector<std::unique_ptr<expression>> args)
+    : expression(static_kind),
+      callee(std::move(c)),
       arguments(std::move(args)) {}
 call_expression::~call_expression() = default;
 void call_expression::accept(visitor& v) {
@@ -156,24 +169,31 @@ void call_expression::accept(visitor& v) {
 
 // grouping_expression
 grouping_expression::grouping_expression(std::unique_ptr<expression> expr)
-    : inner(std::move(expr)) {}
+    : expression(static_kind),
+      inner(std::move(expr)) {}
 grouping_expression::~grouping_expression() = default;
 void grouping_expression::accept(visitor& v) {
     v.visit(*this);
 }
 
 // block
-block::block(std::vector<std::unique_ptr<entity>> items)
-    : items(std::move(items)) {}
+block::block(common::arena_vector<std::unique_ptr<entity>> items)
+    : entity(static_kind),
+      items(std::move(items)) {}
 block::~block() = default;
 void block::accept(visitor& v) {
     v.visit(*this);
 }
 
 // program
-program::program(std::vector<std::unique_ptr<class_declaration>> cls)
-    : classes(std::move(cls)) {}
-program::~program() = default;
+program::program()
+    : entity(static_kind),
+      classes(common::arena_allocator<std::unique_ptr<class_declaration>>{nodes.resource()}) {}
+program::~program() {
+    for (auto& cls : classes) {
+        cls.release();
+    }
+}
 void program::accept(visitor& v) {
     v.visit(*this);
 }
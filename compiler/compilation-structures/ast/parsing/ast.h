@@ -3,46 +3,75 @@
 #include <cstdint>
 #include <memory>
 #include <optional>
-#include <string>
+#include <type_traits>
 #include <variant>
-#include <vector>
 
 #include "ast-forward-declarations.h"
+#include "compiler/common/arena.h"
+#include "compiler/common/interner.h"
 #include "compiler/compilation-structures/common.h"
 
+namespace structures {
+class type;
+struct method_symbol;
+struct variable_symbol;
+} // namespace structures
+
 namespace ast {
 
-class entity {
+// nodes live in the arena of their program, see program::nodes
+class entity : public common::arena_node {
 public:
+    // concrete class of the node, see node_cast
+    const node_kind kind;
     common::span span{};
 
+    explicit entity(node_kind kind) : kind(kind) {}
     virtual ~entity() = default;
     virtual void accept(visitor& visitor) = 0;
 };
 
-class declaration : public entity {};
-class statement : public entity {};
-class expression : public entity {};
+class declaration : public entity {
+public:
+    using entity::entity;
+};
+class statement : public entity {
+public:
+    using entity::entity;
+};
+class expression : public entity {
+public:
+    using entity::entity;
+
+    // set by the first successful type inference of this node and reused by every later phase
+    mutable const structures::type* inferred_type = nullptr;
+    // for calls, the method or constructor the call resolved to
+    mutable structures::method_symbol* resolved_method = nullptr;
+    // for identifiers and member accesses, the variable, parameter or field they name
+    mutable structures::variable_symbol* resolved_variable = nullptr;
+};
 
 // |------------|
 // |Declarations|
 // |------------|
 class class_declaration : public declaration {
 public:
-    std::string name;
-    std::vector<std::string> type_parameters;
-    std::optional<std::string> base_class;
-    std::vector<std::unique_ptr<variable_declaration>> fields;
-    std::vector<std::unique_ptr<method_declaration>> methods;
-    std::vector<std::unique_ptr<constructor_declaration>> constructors;
-
-    class_declaration() = default;
-    class_declaration(std::string name,
-                      std::vector<std::string> type_parameters,
-                      std::optional<std::string> base_class,
-                      std::vector<std::unique_ptr<variable_declaration>> fields,
-                      std::vector<std::unique_ptr<method_declaration>> methods,
-                      std::vector<std::unique_ptr<constructor_declaration>> constructors);
+    static constexpr node_kind static_kind = node_kind::class_declaration;
+
+    common::symbol_id name;
+    common::arena_vector<common::symbol_id> type_parameters;
+    std::optional<common::symbol_id> base_class;
+    common::arena_vector<std::unique_ptr<variable_declaration>> fields;
+    common::arena_vector<std::unique_ptr<method_declaration>> methods;
+    common::arena_vector<std::unique_ptr<constructor_declaration>> constructors;
+
+    class_declaration() : declaration(static_kind) {}
+    class_declaration(common::symbol_id name,
+                      common::arena_vector<common::symbol_id> type_parameters,
+                      std::optional<common::symbol_id> base_class,
+                      common::arena_vector<std::unique_ptr<variable_declaration>> fields,
+                      common::arena_vector<std::unique_ptr<method_declaration>> methods,
+                      common::arena_vector<std::unique_ptr<constructor_declaration>> constructors);
     ~class_declaration() override;
 
     void accept(visitor& visitor) override;
@@ -54,11 +83,13 @@ public:
  */
 class variable_declaration : public statement {
 public:
-    std::string name;
+    static constexpr node_kind static_kind = node_kind::variable_declaration;
+
+    common::symbol_id name;
     std::unique_ptr<expression> initializer;
 
-    variable_declaration() = default;
-    variable_declaration(std::string name, std::unique_ptr<expression> init);
+    variable_declaration() : statement(static_kind) {}
+    variable_declaration(common::symbol_id name, std::unique_ptr<expression> init);
     ~variable_declaration() override;
 
     void accept(visitor& visitor) override;
@@ -66,11 +97,13 @@ public:
 
 class parameter_declaration : public declaration {
 public:
-    std::string name;
-    std::string type_name;
+    static constexpr node_kind static_kind = node_kind::parameter_declaration;
+
+    common::symbol_id name;
+    common::symbol_id type_name;
 
-    parameter_declaration() = default;
-    parameter_declaration(std::string n, std::string t);
+    parameter_declaration() : declaration(static_kind) {}
+    parameter_declaration(common::symbol_id n, common::symbol_id t);
     ~parameter_declaration() override;
 
     void accept(visitor& visitor) override;
@@ -78,15 +111,19 @@ public:
 
 class method_declaration : public declaration {
 public:
-    std::string name;
-    std::vector<std::unique_ptr<parameter_declaration>> parameters;
-    std::optional<std::string> return_type;
+    static constexpr node_kind static_kind = node_kind::method_declaration;
+
+    common::symbol_id name;
+    common::arena_vector<std::unique_ptr<parameter_declaration>> parameters;
+    std::optional<common::symbol_id> return_type;
     std::optional<std::variant<std::unique_ptr<block>, std::unique_ptr<expression>>> body;
+    // declared symbol, set when the class body is collected
+    structures::method_symbol* symbol = nullptr;
 
-    method_declaration() = default;
-    method_declaration(std::string name,
-                       std::vector<std::unique_ptr<parameter_declaration>> params,
-                       std::optional<std::string> ret,
+    method_declaration() : declaration(static_kind) {}
+    method_declaration(common::symbol_id name,
+                       common::arena_vector<std::unique_ptr<parameter_declaration>> params,
+                       std::optional<common::symbol_id> ret,
                        std::optional<std::variant<std::unique_ptr<block>, std::unique_ptr<expression>>> body);
     ~method_declaration() override;
 
@@ -95,12 +132,16 @@ public:
 
 class constructor_declaration : public declaration {
 public:
-    std::vector<std::unique_ptr<parameter_declaration>> parameters;
-    std::optional<std::vector<std::unique_ptr<expression>>> super_parameters;
+    static constexpr node_kind static_kind = node_kind::constructor_declaration;
+
+    common::arena_vector<std::unique_ptr<parameter_declaration>> parameters;
+    std::optional<common::arena_vector<std::unique_ptr<expression>>> super_parameters;
     std::unique_ptr<block> body;
+    // declared symbol, set when the class body is collected
+    structures::method_symbol* symbol = nullptr;
 
-    constructor_declaration() = default;
-    constructor_declaration(std::vector<std::unique_ptr<parameter_declaration>> params, std::optional<std::vector<std::unique_ptr<expression>>> super_params, std::unique_ptr<block> body);
+    constructor_declaration() : declaration(static_kind) {}
+    constructor_declaration(common::arena_vector<std::unique_ptr<parameter_declaration>> params, std::optional<common::arena_vector<std::unique_ptr<expression>>> super_params, std::unique_ptr<block> body);
     ~constructor_declaration() override;
 
     void accept(visitor& visitor) override;
@@ -115,11 +156,13 @@ public:
  */
 class assignment_statement : public statement {
 public:
-    std::string target;
+    static constexpr node_kind static_kind = node_kind::assignment_statement;
+
+    common::symbol_id target;
     std::unique_ptr<expression> value;
 
-    assignment_statement() = default;
-    assignment_statement(std::string t, std::unique_ptr<expression> v);
+    assignment_statement() : statement(static_kind) {}
+    assignment_statement(common::symbol_id t, std::unique_ptr<expression> v);
     ~assignment_statement() override;
 
     void accept(visitor& visitor) override;
@@ -127,10 +170,12 @@ public:
 
 class while_statement : public statement {
 public:
+    static constexpr node_kind static_kind = node_kind::while_statement;
+
     std::unique_ptr<expression> condition;
     std::unique_ptr<block> body;
 
-    while_statement() = default;
+    while_statement() : statement(static_kind) {}
     while_statement(std::unique_ptr<expression> cond, std::unique_ptr<block> body);
     ~while_statement() override;
 
@@ -139,11 +184,13 @@ public:
 
 class if_statement : public statement {
 public:
+    static constexpr node_kind static_kind = node_kind::if_statement;
+
     std::unique_ptr<expression> condition;
     std::unique_ptr<block> true_branch;
     std::unique_ptr<block> false_branch;
 
-    if_statement() = default;
+    if_statement() : statement(static_kind) {}
     if_statement(std::unique_ptr<expression> cond, std::unique_ptr<block> t, std::unique_ptr<block> f);
     ~if_statement() override;
 
@@ -152,9 +199,11 @@ public:
 
 class return_statement : public statement {
 public:
+    static constexpr node_kind static_kind = node_kind::return_statement;
+
     std::unique_ptr<expression> value;
 
-    return_statement() = default;
+    return_statement() : statement(static_kind) {}
     explicit return_statement(std::unique_ptr<expression> v);
     ~return_statement() override;
 
@@ -166,10 +215,12 @@ public:
 // |-----------|
 class literal_expression : public expression {
 public:
+    static constexpr node_kind static_kind = node_kind::literal_expression;
+
     enum class type { integer, real, boolean } type;
     std::variant<int64_t, double, bool> value;
 
-    literal_expression() = default;
+    literal_expression() : expression(static_kind) {}
     literal_expression(int64_t v);
     literal_expression(double v);
     literal_expression(bool v);
@@ -180,7 +231,9 @@ public:
 
 class this_expression : public expression {
 public:
-    this_expression() = default;
+    static constexpr node_kind static_kind = node_kind::this_expression;
+
+    this_expression() : expression(static_kind) {}
     ~this_expression() override;
 
     void accept(visitor& visitor) override;
@@ -188,10 +241,12 @@ public:
 
 class identifier_expression : public expression {
 public:
-    std::string name;
+    static constexpr node_kind static_kind = node_kind::identifier_expression;
+
+    common::symbol_id name;
 
-    identifier_expression() = default;
-    explicit identifier_expression(std::string n);
+    identifier_expression() : expression(static_kind) {}
+    explicit identifier_expression(common::symbol_id n);
     ~identifier_expression() override;
 
     void accept(visitor& visitor) override;
@@ -203,11 +258,13 @@ public:
  */
 class member_expression : public expression {
 public:
+    static constexpr node_kind static_kind = node_kind::member_expression;
+
     std::unique_ptr<expression> object;
-    std::string member;
+    common::symbol_id member;
 
-    member_expression() = default;
-    member_expression(std::unique_ptr<expression> obj, std::string mem);
+    member_expression() : expression(static_kind) {}
+    member_expression(std::unique_ptr<expression> obj, common::symbol_id mem);
     ~member_expression() override;
 
     void accept(visitor& visitor) override;
@@ -215,11 +272,13 @@ public:
 
 class call_expression : public expression {
 public:
+    static constexpr node_kind static_kind = node_kind::call_expression;
+
     std::unique_ptr<expression> callee;
-    std::vector<std::unique_ptr<expression>> arguments;
+    common::arena_vector<std::unique_ptr<expression>> arguments;
 
-    call_expression() = default;
-    call_expression(std::unique_ptr<expression> c, std::vector<std::unique_ptr<expression>> args);
+    call_expression() : expression(static_kind) {}
+    call_expression(std::unique_ptr<expression> c, common::arena_vector<std::unique_ptr<expression>> args);
     ~call_expression() override;
 
     void accept(visitor& visitor) override;
@@ -227,9 +286,11 @@ public:
 
 class grouping_expression : public expression {
 public:
+    static constexpr node_kind static_kind = node_kind::grouping_expression;
+
     std::unique_ptr<expression> inner;
 
-    grouping_expression() = default;
+    grouping_expression() : expression(static_kind) {}
     explicit grouping_expression(std::unique_ptr<expression> expr);
     ~grouping_expression() override;
 
@@ -241,10 +302,12 @@ public:
 // |--------------|
 class block : public entity {
 public:
-    std::vector<std::unique_ptr<entity>> items;
+    static constexpr node_kind static_kind = node_kind::block;
+
+    common::arena_vector<std::unique_ptr<entity>> items;
 
-    block() = default;
-    explicit block(std::vector<std::unique_ptr<entity>> items);
+    block() : entity(static_kind) {}
+    explicit block(common::arena_vector<std::unique_ptr<entity>> items);
     ~block() override;
 
     void accept(visitor& visitor) override;
@@ -252,13 +315,32 @@ public:
 
 class program : public entity {
 public:
-    std::vector<std::unique_ptr<class_declaration>> classes;
+    static constexpr node_kind static_kind = node_kind::program;
 
-    program() = default;
-    explicit program(std::vector<std::unique_ptr<class_declaration>> cls);
+    // memory of every other node of the tree; the parser builds the tree inside a scope of it
+    common::arena nodes;
+    common::arena_vector<std::unique_ptr<class_declaration>> classes;
+
+    program();
+    // drops the whole tree with the arena, without running the node destructors
     ~program() override;
 
+    // the root is the only node on the heap, it owns the arena
+    static void* operator new(size_t size) {
+        return ::operator new(size);
+    }
+    static void operator delete(void* pointer) noexcept {
+        ::operator delete(pointer);
+    }
+
     void accept(visitor& visitor) override;
 };
 
+// Downcast checked against the kind tag instead of RTTI; nullptr when `node` is null or another kind of node.
+template<typename T, typename Node>
+auto* node_cast(Node* node) noexcept {
+    using result = std::conditional_t<std::is_const_v<Node>, const T, T>;
+    return node != nullptr && node->kind == T::static_kind ? static_cast<result*>(node) : nullptr;
+}
+
 } // namespace ast
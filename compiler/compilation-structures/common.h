@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <format>
+#include <string>
 
 namespace common {
 
@@ -11,6 +12,12 @@ struct span {
     size_t end_pos{};
 };
 
+// A problem found in the source. Only the driver formats it, with the location and the source line.
+struct diagnostic {
+    common::span span;
+    std::string message;
+};
+
 } // namespace common
 
 template<>
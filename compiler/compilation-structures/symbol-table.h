@@ -1,11 +1,14 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "compiler/common/interner.h"
 #include "compiler/compilation-structures/type-table.h"
 
 namespace structures {
@@ -18,18 +21,20 @@ enum class symbol_kind {
 
 struct symbol {
     // todo add span
-    std::string name;
+    common::symbol_id name;
     symbol_kind kind;
 
-    symbol(std::string n, symbol_kind k)
-        : name(std::move(n)),
+    symbol(common::symbol_id n, symbol_kind k)
+        : name(n),
           kind(k) {}
 
     virtual ~symbol() = default;
 };
 
-inline std::string mangle_method_name(const std::string& name, const std::vector<const type*>& param_types) {
-    std::string result = name + "(";
+// interned, so declarations and lookups of the same overload share one id
+inline common::symbol_id mangle_method_name(common::symbol_id name, const std::vector<const type*>& param_types) {
+    std::string result{name.view()};
+    result += "(";
     for (size_t i = 0; i < param_types.size(); ++i) {
         if (i > 0) {
             result += ", ";
@@ -37,12 +42,17 @@ inline std::string mangle_method_name(const std::string& name, const std::vector
         result += param_types[i]->toString();
     }
     result += ")";
-    return result;
+    return common::symbol_id{result};
 }
 
+struct class_symbol;
+
 struct symbol_table {
-    symbol_table(symbol_table* p)
-        : parent(p){};
+    // `inherited` is searched before the parent: the scope of a built-in base class, which every compilation shares
+    // and which therefore can't lead on to this program's scope
+    symbol_table(symbol_table* p, const symbol_table* inherited = nullptr)
+        : parent(p),
+          inherited(inherited){};
 
     symbol_table(const symbol_table&) = delete;
     symbol_table& operator=(const symbol_table&) = delete;
@@ -50,12 +60,23 @@ struct symbol_table {
     symbol_table& operator=(symbol_table&&) noexcept = default;
 
     void add(std::unique_ptr<symbol> symbol) {
-        symbols[symbol->name] = std::move(symbol);
+        symbols[symbol->name] = symbol.get();
+        owned.push_back(std::move(symbol));
+    }
+
+    // a symbol owned elsewhere, like the built-in classes
+    void add_external(symbol* symbol) {
+        symbols[symbol->name] = symbol;
     }
 
-    symbol* lookup(const std::string& name) const {
+    symbol* lookup(common::symbol_id name) const {
         if (auto it = symbols.find(name); it != symbols.end()) {
-            return it->second.get();
+            return it->second;
+        }
+        if (inherited != nullptr) {
+            if (auto* found = inherited->lookup(name)) {
+                return found;
+            }
         }
         if (parent != nullptr) {
             return parent->lookup(name);
@@ -64,10 +85,13 @@ struct symbol_table {
     }
 
     template<typename T>
-    T* typed_lookup(const std::string& name) const {
+    T* typed_lookup(common::symbol_id name) const {
         return dynamic_cast<T*>(lookup(name));
     }
 
+    // classes are only declared in the program scope, so they are looked up there without probing every enclosing scope
+    class_symbol* lookup_class(common::symbol_id name) const;
+
     auto begin() noexcept {
         return symbols.begin();
     }
@@ -77,27 +101,33 @@ struct symbol_table {
     }
 
 private:
-    std::unordered_map<std::string, std::unique_ptr<symbol>> symbols{};
+    std::unordered_map<common::symbol_id, symbol*> symbols{};
+    std::vector<std::unique_ptr<symbol>> owned{};
     symbol_table* parent;
+    const symbol_table* inherited;
 };
 
 struct variable_symbol : symbol {
     const structures::type* type;
 
-    variable_symbol(std::string name, const structures::type* type)
-        : symbol(std::move(name), symbol_kind::variable_symbol),
+    variable_symbol(common::symbol_id name, const structures::type* type)
+        : symbol(name, symbol_kind::variable_symbol),
           type(type) {}
 };
 
 struct method_symbol : symbol {
-    std::string original_name;
+    common::symbol_id original_name;
     std::optional<const structures::type *> return_type;
     std::vector<const structures::type *> parameter_types;
     std::unique_ptr<symbol_table> method_scope;
-
-    method_symbol(std::string mangled_name, std::string orig_name, symbol_table* parent_scope, std::optional<const structures::type *> ret_type, std::vector<const structures::type *> params_type)
-        : symbol(std::move(mangled_name), symbol_kind::method_symbol),
-          original_name(std::move(orig_name)),
+    // class declaring the method and the method's position in its methods or constructors, set by index_members
+    class_symbol* owner = nullptr;
+    size_t index = 0;
+    bool is_constructor = false;
+
+    method_symbol(common::symbol_id mangled_name, common::symbol_id orig_name, symbol_table* parent_scope, std::optional<const structures::type *> ret_type, std::vector<const structures::type *> params_type)
+        : symbol(mangled_name, symbol_kind::method_symbol),
+          original_name(orig_name),
           method_scope(std::make_unique<symbol_table>(parent_scope)),
           return_type(std::move(ret_type)),
           parameter_types(std::move(params_type)) {}
@@ -110,10 +140,84 @@ struct class_symbol : symbol {
     std::vector<variable_symbol *> fields;
     std::vector<method_symbol *> constructors;
 
-    class_symbol(std::string name, symbol_table* parent_scope, class_symbol* base_class)
-        : symbol(std::move(name), symbol_kind::class_symbol),
-          class_scope(std::make_unique<symbol_table>(parent_scope)),
+    class_symbol(common::symbol_id name, symbol_table* parent_scope, class_symbol* base_class, const symbol_table* inherited_scope = nullptr)
+        : symbol(name, symbol_kind::class_symbol),
+          class_scope(std::make_unique<symbol_table>(parent_scope, inherited_scope)),
           base_class(base_class) {}
+
+    static uint64_t overload_key(common::symbol_id name, size_t arity) noexcept {
+        return static_cast<uint64_t>(name.id()) << 32 | arity;
+    }
+
+    // Candidates for a call of `name` with `arity` arguments, inherited ones included: the class's own methods in
+    // declaration order, then those of its base that it doesn't override, and so on up the hierarchy. The first one the
+    // arguments fit is the one the call resolves to.
+    const std::vector<method_symbol*>& overloads(common::symbol_id name, size_t arity) const {
+        static const std::vector<method_symbol*> no_overloads;
+        auto it = method_table.find(overload_key(name, arity));
+        return it == method_table.end() ? no_overloads : it->second;
+    }
+
+    // constructors taking `arity` arguments, in declaration order
+    const std::vector<method_symbol*>& constructor_overloads(size_t arity) const {
+        static const std::vector<method_symbol*> no_overloads;
+        auto it = constructor_table.find(arity);
+        return it == constructor_table.end() ? no_overloads : it->second;
+    }
+
+    // Builds the overload tables once the members of the class and of its bases are collected; they aren't changed
+    // afterwards, so the method checks read them concurrently.
+    void index_members() {
+        if (members_indexed) {
+            return;
+        }
+        members_indexed = true;
+        for (size_t i = 0; i < methods.size(); ++i) {
+            methods[i]->owner = this;
+            methods[i]->index = i;
+            method_table[overload_key(methods[i]->original_name, methods[i]->parameter_types.size())].push_back(methods[i]);
+        }
+        for (size_t i = 0; i < constructors.size(); ++i) {
+            constructors[i]->owner = this;
+            constructors[i]->index = i;
+            constructors[i]->is_constructor = true;
+            constructor_table[constructors[i]->parameter_types.size()].push_back(constructors[i]);
+        }
+        if (base_class == nullptr) {
+            return;
+        }
+        base_class->index_members();
+        for (const auto& [key, inherited] : base_class->method_table) {
+            auto& candidates = method_table[key];
+            auto own = candidates.size();
+            for (auto* method : inherited) {
+                // an override has the same mangled name and always matches first
+                auto overridden = std::ranges::any_of(candidates.begin(), candidates.begin() + own, [method](const method_symbol* candidate) {
+                    return candidate->name == method->name;
+                });
+                if (!overridden) {
+                    candidates.push_back(method);
+                }
+            }
+        }
+    }
+
+private:
+    std::unordered_map<uint64_t, std::vector<method_symbol*>> method_table;
+    std::unordered_map<size_t, std::vector<method_symbol*>> constructor_table;
+    bool members_indexed = false;
 };
 
+inline class_symbol* symbol_table::lookup_class(common::symbol_id name) const {
+    const auto* scope = this;
+    while (scope->parent != nullptr) {
+        scope = scope->parent;
+    }
+    auto it = scope->symbols.find(name);
+    if (it == scope->symbols.end() || it->second->kind != symbol_kind::class_symbol) {
+        return nullptr;
+    }
+    return static_cast<class_symbol*>(it->second);
+}
+
 } // namespace structures
@@ -1,7 +1,9 @@
 #include "compiler/compilation-structures/type-table.h"
 
+#include <algorithm>
 #include <cassert>
 #include <format>
+#include <mutex>
 #include <stdexcept>
 
 #include "compiler/compilation-structures/ast/parsing/ast.h"
@@ -22,27 +24,16 @@ std::string format_argument_types(const std::vector<const structures::type*>& ty
 }
 
 structures::method_symbol*
-find_method_in_hierarchy(structures::class_symbol* class_symbol, const std::string& name, const std::vector<const structures::type*>& argument_types) {
-    auto* current = class_symbol;
-    structures::method_symbol* best_match = nullptr;
-
-    while (current != nullptr && best_match == nullptr) {
-        for (auto* method : current->methods) {
-            if (method->original_name != name)
-                continue;
-            if (method->parameter_types.size() != argument_types.size())
-                continue;
-            if (structures::type::isSubTypeList(argument_types, method->parameter_types)) {
-                best_match = method;
-                break;
-            }
+find_method_in_hierarchy(structures::class_symbol* class_symbol, common::symbol_id name, const std::vector<const structures::type*>& argument_types) {
+    for (auto* method : class_symbol->overloads(name, argument_types.size())) {
+        if (structures::type::isSubTypeList(argument_types, method->parameter_types)) {
+            return method;
         }
-        current = current->base_class;
     }
-    return best_match;
+    return nullptr;
 }
 
-structures::variable_symbol* find_field_in_hierarchy(structures::class_symbol* class_symbol, const std::string& name) {
+structures::variable_symbol* find_field_in_hierarchy(structures::class_symbol* class_symbol, common::symbol_id name) {
     auto* current = class_symbol;
     while (current != nullptr) {
         if (auto* field = current->class_scope->typed_lookup<structures::variable_symbol>(name)) {
@@ -55,16 +46,25 @@ structures::variable_symbol* find_field_in_hierarchy(structures::class_symbol* c
 
 const structures::type* infer_expression(const ast::expression* expression, structures::type::infer_context context);
 
-void resolve_constructor_call(structures::class_symbol* target_class, const std::vector<const structures::type*>& argument_types) {
+const structures::type* fail(const ast::expression* expression, structures::type::infer_context context, std::string message) {
+    context.diagnostics->push_back({expression->span, std::move(message)});
+    return context.type_table->getError();
+}
+
+bool any_error(const std::vector<const structures::type*>& types) {
+    return std::ranges::any_of(types, [](const structures::type* type) { return type->isError(); });
+}
+
+const structures::type* infer_constructor_call(const ast::call_expression* call_expr,
+                                               structures::class_symbol* target_class,
+                                               const std::vector<const structures::type*>& argument_types,
+                                               structures::type::infer_context context) {
     if (target_class->constructors.empty()) {
-        throw std::runtime_error{std::format("Class '{}' has no constructors defined\n", target_class->name)};
+        return fail(call_expr, context, std::format("Class '{}' has no constructors defined", target_class->name));
     }
 
     structures::method_symbol* matching_constructor = nullptr;
-    for (const auto& ctor : target_class->constructors) {
-        if (argument_types.size() != ctor->parameter_types.size()) {
-            continue;
-        }
+    for (auto* ctor : target_class->constructor_overloads(argument_types.size())) {
         bool types_match = true;
         for (size_t i = 0; i < argument_types.size(); ++i) {
             if (!structures::type::isSubtype(argument_types[i], ctor->parameter_types[i])) {
@@ -74,8 +74,9 @@ void resolve_constructor_call(structures::class_symbol* target_class, const std:
         }
         if (types_match) {
             if (matching_constructor != nullptr) {
-                throw std::runtime_error{
-                    std::format("Ambiguous constructor call for class '{}': multiple overloads match the argument types\n", target_class->name)};
+                return fail(call_expr,
+                            context,
+                            std::format("Ambiguous constructor call for class '{}': multiple overloads match the argument types", target_class->name));
             }
             matching_constructor = ctor;
         }
@@ -84,29 +85,14 @@ void resolve_constructor_call(structures::class_symbol* target_class, const std:
     if (matching_constructor == nullptr) {
         std::string error_msg = std::format("No matching constructor for '{}'\n", target_class->name);
         error_msg += std::format("  Argument types: {}\n", format_argument_types(argument_types));
-        error_msg += "  Available constructors:\n";
+        error_msg += "  Available constructors:";
         for (const auto& ctor : target_class->constructors) {
-            error_msg += std::format("    {}{}\n", target_class->name, format_argument_types(ctor->parameter_types));
-        }
-        throw std::runtime_error{error_msg};
-    }
-}
-
-void validate_method_call(structures::method_symbol* method, const std::vector<const structures::type*>& argument_types) {
-    if (argument_types.size() != method->parameter_types.size()) {
-        throw std::runtime_error{
-            std::format("Method '{}': expected {} argument(s), got {}\n", method->original_name, method->parameter_types.size(), argument_types.size())};
-    }
-
-    for (size_t i = 0; i < argument_types.size(); ++i) {
-        if (!structures::type::isSubtype(argument_types[i], method->parameter_types[i])) {
-            throw std::runtime_error{std::format("Method '{}': argument {} type mismatch - expected '{}', found '{}'\n",
-                                                 method->original_name,
-                                                 i + 1,
-                                                 method->parameter_types[i]->toString(),
-                                                 argument_types[i]->toString())};
+            error_msg += std::format("\n    {}{}", target_class->name, format_argument_types(ctor->parameter_types));
         }
+        return fail(call_expr, context, std::move(error_msg));
     }
+    call_expr->resolved_method = matching_constructor;
+    return context.type_table->resolveType(target_class->name);
 }
 
 const structures::type* infer_call_expression(const ast::call_expression* call_expr, structures::type::infer_context context) {
@@ -114,111 +100,132 @@ const structures::type* infer_call_expression(const ast::call_expression* call_e
     for (const auto& arg : call_expr->arguments) {
         argument_types.push_back(infer_expression(arg.get(), context));
     }
+    // the failing argument is already recorded, no overload can be picked without its type
+    if (any_error(argument_types)) {
+        return context.type_table->getError();
+    }
 
-    if (auto* ident_expr = dynamic_cast<ast::identifier_expression*>(call_expr->callee.get())) {
+    if (auto* ident_expr = ast::node_cast<ast::identifier_expression>(call_expr->callee.get())) {
         if (auto* target_class = context.symbol_table->typed_lookup<structures::class_symbol>(ident_expr->name)) {
-            resolve_constructor_call(target_class, argument_types);
-            return context.type_table->resolveType(target_class->name);
+            return infer_constructor_call(call_expr, target_class, argument_types, context);
         }
-        throw std::runtime_error{std::format("Undefined constructor or function '{}'\n", ident_expr->name)};
+        return fail(call_expr, context, std::format("Undefined constructor or function '{}'", ident_expr->name));
     }
 
-    if (auto* member_expr = dynamic_cast<ast::member_expression*>(call_expr->callee.get())) {
-        if (auto* obj_ident = dynamic_cast<ast::identifier_expression*>(member_expr->object.get()); obj_ident && obj_ident->name == member_expr->member) {
+    if (auto* member_expr = ast::node_cast<ast::member_expression>(call_expr->callee.get())) {
+        if (auto* obj_ident = ast::node_cast<ast::identifier_expression>(member_expr->object.get()); obj_ident && obj_ident->name == member_expr->member) {
             // Constructor call: ClassName(args)
             auto* target_class = context.symbol_table->typed_lookup<structures::class_symbol>(obj_ident->name);
             if (target_class == nullptr) {
-                throw std::runtime_error{std::format("Unknown type '{}' for constructor call\n", obj_ident->name)};
+                return fail(call_expr, context, std::format("Unknown type '{}' for constructor call", obj_ident->name));
             }
-            assert(target_class != nullptr);
-            resolve_constructor_call(target_class, argument_types);
-            return context.type_table->resolveType(target_class->name);
+            return infer_constructor_call(call_expr, target_class, argument_types, context);
         }
 
         auto object_type = infer_expression(member_expr->object.get(), context);
+        if (object_type->isError()) {
+            return object_type;
+        }
 
         const auto* class_type = dynamic_cast<const structures::class_type*>(object_type);
         if (class_type == nullptr) {
-            throw std::runtime_error{"Cannot call method on non-class type\n"};
+            return fail(call_expr, context, "Cannot call method on non-class type");
         }
 
-        auto* object_class = context.symbol_table->typed_lookup<structures::class_symbol>(class_type->name);
+        auto* object_class = context.symbol_table->lookup_class(class_type->name);
         assert(object_class != nullptr);
 
         if (object_class->name == member_expr->member) {
-            resolve_constructor_call(object_class, argument_types);
-            return class_type;
+            return infer_constructor_call(call_expr, object_class, argument_types, context);
         }
 
         auto* method = find_method_in_hierarchy(object_class, member_expr->member, argument_types);
         if (method == nullptr) {
-            throw std::runtime_error{std::format("method '{}' with arguments '{}' not found in class '{}'\n",
-                                                 member_expr->member,
-                                                 format_argument_types(argument_types),
-                                                 class_type->name)};
+            return fail(call_expr,
+                        context,
+                        std::format("method '{}' with arguments '{}' not found in class '{}'",
+                                    member_expr->member,
+                                    format_argument_types(argument_types),
+                                    class_type->name));
         }
+        call_expr->resolved_method = method;
 
         if (method->return_type.has_value()) {
             return method->return_type.value();
         }
-        return context.type_table->resolveType("Unit");
+        return context.type_table->resolveType(common::well_known::unit);
     }
 
-    throw std::runtime_error{"Unsupported call expression type\n"};
+    return fail(call_expr, context, "Unsupported call expression type");
 }
 
-const structures::type* infer_expression(const ast::expression* expression, structures::type::infer_context context) {
-    if (auto* literal = dynamic_cast<const ast::literal_expression*>(expression)) {
-        switch (literal->type) {
+const structures::type* infer_uncached_expression(const ast::expression* expression, structures::type::infer_context context) {
+    switch (expression->kind) {
+    case ast::node_kind::literal_expression: {
+        switch (static_cast<const ast::literal_expression*>(expression)->type) {
         case ast::literal_expression::type::integer:
-            return context.type_table->resolveType("Integer");
+            return context.type_table->resolveType(common::well_known::integer);
         case ast::literal_expression::type::real:
-            return context.type_table->resolveType("Real");
+            return context.type_table->resolveType(common::well_known::real);
         case ast::literal_expression::type::boolean:
-            return context.type_table->resolveType("Boolean");
+            return context.type_table->resolveType(common::well_known::boolean);
         default:
-            throw std::runtime_error{"Unknown literal type\n"};
+            return fail(expression, context, "Unknown literal type");
         }
     }
 
-    if (dynamic_cast<const ast::this_expression*>(expression)) {
+    case ast::node_kind::this_expression:
         return context.type_table->resolveType(context.class_symbol->name);
-    }
 
-    if (auto* ident = dynamic_cast<const ast::identifier_expression*>(expression)) {
+    case ast::node_kind::identifier_expression: {
+        auto* ident = static_cast<const ast::identifier_expression*>(expression);
         if (auto* var = context.symbol_table->typed_lookup<structures::variable_symbol>(ident->name)) {
+            ident->resolved_variable = var;
             return var->type;
         }
-        if (auto* cls = context.symbol_table->typed_lookup<structures::class_symbol>(ident->name)) {
-            throw std::runtime_error{std::format("{} is class name and can't be used in expression\n", ident->name)};
-            ;
+        if (context.symbol_table->typed_lookup<structures::class_symbol>(ident->name) != nullptr) {
+            return fail(expression, context, std::format("{} is class name and can't be used in expression", ident->name));
         }
-        throw std::runtime_error{std::format("Undefined variable '{}'\n", ident->name)};
+        return fail(expression, context, std::format("Undefined variable '{}'", ident->name));
     }
 
-    if (auto* member = dynamic_cast<const ast::member_expression*>(expression)) {
+    case ast::node_kind::member_expression: {
+        auto* member = static_cast<const ast::member_expression*>(expression);
         auto object_type = infer_expression(member->object.get(), context);
+        if (object_type->isError()) {
+            return object_type;
+        }
         if (const auto* cls_type = dynamic_cast<const structures::class_type*>(object_type)) {
-            auto* cls = context.symbol_table->typed_lookup<structures::class_symbol>(cls_type->name);
+            auto* cls = context.symbol_table->lookup_class(cls_type->name);
             assert(cls != nullptr);
             auto* field = find_field_in_hierarchy(cls, member->member);
             if (field == nullptr) {
-                throw std::runtime_error{std::format("Cannot find field '{}' in class '{}'\n", member->member, cls_type->name)};
+                return fail(expression, context, std::format("Cannot find field '{}' in class '{}'", member->member, cls_type->name));
             }
+            member->resolved_variable = field;
             return field->type;
         }
-        throw std::runtime_error{"Accessing fields on non-class types is not supported\n"};
+        return fail(expression, context, "Accessing fields on non-class types is not supported");
     }
 
-    if (auto* call = dynamic_cast<const ast::call_expression*>(expression)) {
-        return infer_call_expression(call, context);
-    }
+    case ast::node_kind::call_expression:
+        return infer_call_expression(static_cast<const ast::call_expression*>(expression), context);
+
+    case ast::node_kind::grouping_expression:
+        return infer_expression(static_cast<const ast::grouping_expression*>(expression)->inner.get(), context);
 
-    if (auto* group = dynamic_cast<const ast::grouping_expression*>(expression)) {
-        return infer_expression(group->inner.get(), context);
+    default:
+        return fail(expression, context, "Unsupported expression type for type inference");
     }
+}
 
-    throw std::runtime_error{"Unsupported expression type for type inference\n"};
+// every phase infers an expression in the same scope, so the first result is kept on the node; otherwise nested calls
+// are re-inferred once per enclosing call and statement. A kept error type isn't recorded again.
+const structures::type* infer_expression(const ast::expression* expression, structures::type::infer_context context) {
+    if (expression->inferred_type == nullptr) {
+        expression->inferred_type = infer_uncached_expression(expression, context);
+    }
+    return expression->inferred_type;
 }
 
 } // namespace
@@ -233,16 +240,11 @@ bool type::isSubtype(const type* sub, const type* super) {
         return true;
     }
 
-    if (auto* sub_cls = dynamic_cast<const class_type*>(sub)) {
-        if (auto* super_cls = dynamic_cast<const class_type*>(super)) {
-            ast::class_declaration* current = sub_cls->declaration;
-            while (current && current->base_class) {
-                if (*current->base_class == super_cls->name) {
-                    return true;
-                }
-                break;
-            }
-        }
+    // built-in classes are only subtypes of themselves, their values aren't represented like those of their bases
+    if (sub->kind == type_kind::Class && super->kind == type_kind::Class) {
+        auto* sub_cls = static_cast<const class_type*>(sub);
+        auto* super_cls = static_cast<const class_type*>(super);
+        return sub_cls->declaration != nullptr && super_cls->preorder <= sub_cls->preorder && sub_cls->preorder < super_cls->subtree_end;
     }
     return false;
 }
@@ -270,9 +272,12 @@ const type* type::inferExpressionType(const ast::expression* expression, type::i
 type_table::type_table() {
     owned_types_.push_back(std::make_unique<primitive_type>(type_kind::Unknown));
     unknown_type_ = owned_types_.back().get();
+    owned_types_.push_back(std::make_unique<primitive_type>(type_kind::Error));
+    error_type_ = owned_types_.back().get();
 }
 
-const class_type* type_table::getClass(const std::string& name) const {
+const class_type* type_table::getClass(common::symbol_id name) const {
+    std::shared_lock lock{mutex_};
     auto it = class_types_.find(name);
     if (it != class_types_.end()) {
         return it->second;
@@ -280,29 +285,86 @@ const class_type* type_table::getClass(const std::string& name) const {
     return nullptr;
 }
 
-const class_type* type_table::addClass(const std::string& name, ast::class_declaration* decl) {
+const class_type* type_table::addClass(common::symbol_id name, ast::class_declaration* decl) {
+    std::unique_lock lock{mutex_};
     if (class_types_.find(name) != class_types_.end()) {
         return nullptr;
     }
 
     auto class_type = std::make_unique<structures::class_type>(name, decl);
-    const structures::class_type* ptr = class_type.get();
+    auto* ptr = class_type.get();
     owned_types_.push_back(std::move(class_type));
     class_types_[name] = ptr;
     return ptr;
 }
 
-const type* type_table::resolveType(const std::string& name) const {
-    auto it = class_types_.find(name);
-    if (it != class_types_.end()) {
-        return it->second;
+void type_table::addBuiltinClass(class_type* type) {
+    std::unique_lock lock{mutex_};
+    class_types_[type->name] = type;
+}
+
+const type* type_table::resolveType(common::symbol_id name) const {
+    {
+        std::shared_lock lock{mutex_};
+        auto it = class_types_.find(name);
+        if (it != class_types_.end()) {
+            return it->second;
+        }
     }
 
     throw std::runtime_error{std::format("Unknown type '{}'\n", name)};
 }
 
-bool type_table::isPrimitiveTypeName(const std::string& name) {
-    return name == "Integer" || name == "Boolean" || name == "Real" || name == "Unit" || name == "AnyRef" || name == "AnyValue" || name == "ArrayInteger" || name == "IO";
+void type_table::numberHierarchy(symbol_table& symbols) {
+    std::unique_lock lock{mutex_};
+    auto is_builtin = [this](const class_symbol* cls) { return class_types_.at(cls->name)->declaration == nullptr; };
+
+    // the built-in classes are already numbered, the user classes derived directly from one are the roots
+    std::unordered_map<const class_symbol*, std::vector<const class_symbol*>> subclasses;
+    std::vector<const class_symbol*> roots;
+    for (auto& [name, symbol] : symbols) {
+        if (symbol->kind == symbol_kind::class_symbol) {
+            auto* cls = static_cast<const class_symbol*>(symbol);
+            if (!is_builtin(cls)) {
+                (is_builtin(cls->base_class) ? roots : subclasses[cls->base_class]).push_back(cls);
+            }
+        }
+    }
+
+    // first number not yet taken in the slots of each built-in class
+    std::unordered_map<const class_symbol*, uint32_t> next_slot;
+    // without recursion, an inheritance chain can be as long as the program
+    std::vector<std::pair<const class_symbol*, size_t>> path;
+    for (auto* root : roots) {
+        auto* base = class_types_.at(root->base_class->name);
+        auto [slot, _] = next_slot.try_emplace(root->base_class, base->preorder + 1);
+        uint32_t next = slot->second;
+        class_types_.at(root->name)->preorder = next++;
+        path.emplace_back(root, 0);
+        while (!path.empty()) {
+            auto [cls, visited] = path.back();
+            auto it = subclasses.find(cls);
+            if (it != subclasses.end() && visited < it->second.size()) {
+                auto* subclass = it->second[visited];
+                path.back().second++;
+                class_types_.at(subclass->name)->preorder = next++;
+                path.emplace_back(subclass, 0);
+            } else {
+                class_types_.at(cls->name)->subtree_end = next;
+                path.pop_back();
+            }
+        }
+        if (next - base->preorder - 1 > class_type::builtin_subclass_slots) {
+            throw std::runtime_error{std::format("too many classes derived from '{}'", base->name)};
+        }
+        slot->second = next;
+    }
+}
+
+bool type_table::isPrimitiveTypeName(common::symbol_id name) {
+    using namespace common::well_known;
+    static const common::symbol_id primitive_names[] = {integer, boolean, real, unit, any_ref, any_value, array_integer, io};
+    return std::ranges::find(primitive_names, name) != std::end(primitive_names);
 }
 
 } // namespace structures
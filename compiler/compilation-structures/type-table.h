@@ -1,12 +1,16 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <stdexcept>
 
+#include "compiler/common/interner.h"
 #include "compiler/compilation-structures/ast/parsing/ast-forward-declarations.h"
+#include "compiler/compilation-structures/common.h"
 
 namespace structures {
 
@@ -34,6 +38,9 @@ public:
         structures::type_table * type_table;
         structures::class_symbol * class_symbol;
         structures::symbol_table * symbol_table;
+        // an expression inference can't type is recorded here and gets the error type, and so does every expression
+        // containing it, so each failure is recorded once however far it propagates
+        std::vector<common::diagnostic> * diagnostics;
     };
 
     const type_kind kind;
@@ -77,13 +84,21 @@ public:
 
 class class_type : public type {
 public:
-    std::string name;
+    common::symbol_id name;
     ast::class_declaration* declaration;
+    // number in a depth-first walk of the class hierarchy; the classes derived from this one, itself included, are
+    // numbered from preorder up to subtree_end
+    uint32_t preorder = 0;
+    uint32_t subtree_end = 0;
 
-    class_type(std::string n, ast::class_declaration* decl)
-        : type(type_kind::Class), name(std::move(n)), declaration(decl) {}
+    // The built-in classes are numbered once for every compilation. The numbers right after a built-in class are kept
+    // for the user classes derived from it, so they fall inside the range of the class and of its built-in bases.
+    static constexpr uint32_t builtin_subclass_slots = 1u << 26;
 
-    std::string toString() const { return name; }
+    class_type(common::symbol_id n, ast::class_declaration* decl)
+        : type(type_kind::Class), name(n), declaration(decl) {}
+
+    std::string toString() const { return name.str(); }
 };
 
 class type_table {
@@ -97,23 +112,33 @@ public:
     type_table& operator=(type_table&&) = delete;
 
     const type* getUnknown() const {return unknown_type_;}
+    const type* getError() const {return error_type_;}
     
-    const class_type* getClass(const std::string& name) const;
+    const class_type* getClass(common::symbol_id name) const;
     
-    const class_type* addClass(const std::string& name,
+    const class_type* addClass(common::symbol_id name,
                                             ast::class_declaration* decl = nullptr);
+    // a class type owned elsewhere and already numbered, like those of the built-in classes
+    void addBuiltinClass(class_type* type);
     
-    const type* resolveType(const std::string& name) const;
+    const type* resolveType(common::symbol_id name) const;
+
+    // numbers the classes of the symbol table once they are all collected, see class_type::preorder
+    void numberHierarchy(symbol_table& symbols);
     
-    static bool isPrimitiveTypeName(const std::string& name);
+    static bool isPrimitiveTypeName(common::symbol_id name);
 
 private:
 
     const type* unknown_type_;
+    const type* error_type_;
 
     std::vector<std::unique_ptr<type>> owned_types_;
 
-    std::unordered_map<std::string, const class_type*> class_types_;
+    std::unordered_map<common::symbol_id, class_type*> class_types_;
+
+    // lookups come from the method checks running in parallel, classes are only added by the earlier serial phases
+    mutable std::shared_mutex mutex_;
 };
 
 
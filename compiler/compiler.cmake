@@ -30,6 +30,7 @@ set(COMPILER_COMPILATION_STRUCTURES
         ${COMPILER_DIR}/compilation-structures/type-table.cpp
         ${COMPILER_DIR}/compilation-structures/ast/parsing/ast.cpp
         ${COMPILER_DIR}/compilation-structures/ast/codegen/ast.cpp
+        ${COMPILER_DIR}/compilation-structures/ast/codegen/flat-ast.cpp
 )
 
 set(COMPILER_PARSER
@@ -37,7 +38,10 @@ set(COMPILER_PARSER
 )
 
 set(COMPILER_CODEGEN
+        ${COMPILER_DIR}/codegen/bytecode/bytecode-compiler.cpp
+        ${COMPILER_DIR}/codegen/bytecode/interpreter.cpp
         ${COMPILER_DIR}/codegen/llvm/llvm-codegen.cpp
+        ${COMPILER_DIR}/codegen/llvm/llvm-jit.cpp
 )
 
 set(COMPILER_SOURCES
@@ -61,5 +65,29 @@ target_include_directories(compiler PRIVATE
 separate_arguments(LLVM_DEFINITIONS_LIST NATIVE_COMMAND ${LLVM_DEFINITIONS})
 target_compile_definitions(compiler PRIVATE ${LLVM_DEFINITIONS_LIST})
 
-llvm_map_components_to_libnames(LLVM_LIBS core support irreader native nativecodegen)
+llvm_map_components_to_libnames(LLVM_LIBS core support irreader native nativecodegen passes orcjit codegen transformutils)
 target_link_libraries(compiler PRIVATE ${LLVM_LIBS})
+
+# lexer and parser throughput, see compiler/benchmarks/frontend-bench.cpp; needs no LLVM
+add_executable(frontend-bench
+        ${COMPILER_DIR}/benchmarks/frontend-bench.cpp
+        ${COMPILER_PARSER}
+        ${COMPILER_DIR}/compilation-structures/ast/parsing/ast.cpp
+)
+
+target_compile_options(frontend-bench PUBLIC -std=c++23)
+
+target_include_directories(frontend-bench PRIVATE
+        ${CMAKE_CURRENT_LIST_DIR}/..
+)
+
+# compares the lexer with compiler/lexer/reference-lexer.h; tests/run-tests.py runs it when it sits next to the compiler
+add_executable(lexer-differential
+        ${CMAKE_CURRENT_LIST_DIR}/../tests/lexer-differential.cpp
+)
+
+target_compile_options(lexer-differential PUBLIC -std=c++23)
+
+target_include_directories(lexer-differential PRIVATE
+        ${CMAKE_CURRENT_LIST_DIR}/..
+)
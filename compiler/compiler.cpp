@@ -1,34 +1,226 @@
+#include <charconv>
+#include <cstdint>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
+#include <optional>
 #include <string>
+#include <string_view>
 
 #include "compiler/analysis/print/ast-print.h"
 #include "compiler/analysis/print/codegen-ast-print.h"
+#include "compiler/analysis/semantic/error.h"
 #include "compiler/analysis/semantic/semantic-check.h"
+#include "compiler/codegen/bytecode/bytecode-compiler.h"
+#include "compiler/codegen/bytecode/interpreter.h"
 #include "compiler/codegen/llvm/llvm-codegen.h"
+#include "compiler/codegen/llvm/llvm-jit.h"
+#include "compiler/common/source-manager.h"
 #include "compiler/lexer/lexer.h"
 #include "compiler/parser/parser.h"
 
+namespace {
+
+struct driver_options {
+    std::string input_file;
+    bool run = false;
+    bool interpret = false;
+    bool tiered = false;
+    uint32_t tier_threshold = 1000;
+    size_t threads = 1;
+    bool memory_stats = false;
+    codegen::llvm_ir::codegen_options codegen;
+};
+
+void print_usage() {
+    std::cout << "Usage: ./compiler [options] <input_file>\n"
+                 "Options:\n"
+                 "  --run                        compile in memory with the JIT and run the program instead of writing .ll/.o\n"
+                 "  --interp                     run the program in the bytecode interpreter, without LLVM\n"
+                 "  --tiered                     interpret the program and JIT-compile hot methods\n"
+                 "  --tier-threshold=<n>         calls plus loop iterations before a method is compiled (default 1000)\n"
+                 "  --profile-generate[=<file>]  instrument the object file, the program writes <file> (default_%m.profraw) at exit\n"
+                 "  --profile-use=<file>         optimize the object file using an indexed profile (.profdata)\n"
+                 "  --devirt-guards=<n>          test up to <n> likely receiver classes before a virtual call (default 0)\n"
+                 "  --type-switch-threshold=<n>  dispatch virtual calls with at most <n> receiver classes without the vtable (default 0)\n"
+                 "  --customize-budget=<n>       clone inherited methods into subclasses, up to <n> instructions in total (default 0)\n"
+                 "  -j <n>                       check method bodies and emit the object file on <n> threads (default 1)\n"
+                 "  --memory-stats               print the memory taken by the parse tree, the codegen tree and its flat form,\n"
+                 "                               and with --tiered how many functions were lowered to IR\n";
+}
+
+// values that don't fit T are rejected, not truncated
+template<typename T = size_t>
+std::optional<T> parse_count(std::string_view text) {
+    T value{};
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc{} || ptr != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+template<typename T>
+bool parse_count_option(std::string_view arg, T& out) {
+    auto value = parse_count<T>(arg.substr(arg.find('=') + 1));
+    if (!value.has_value()) {
+        std::cerr << "Invalid value for '" << arg << "'\n";
+        return false;
+    }
+    out = *value;
+    return true;
+}
+
+std::optional<driver_options> parse_arguments(int argc, char* argv[]) {
+    driver_options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg{argv[i]};
+        if (arg == "--run") {
+            options.run = true;
+        } else if (arg == "--interp") {
+            options.interpret = true;
+        } else if (arg == "--tiered") {
+            options.tiered = true;
+        } else if (arg == "--memory-stats") {
+            options.memory_stats = true;
+        } else if (arg.starts_with("--tier-threshold=")) {
+            if (!parse_count_option(arg, options.tier_threshold)) {
+                return std::nullopt;
+            }
+        } else if (arg == "--profile-generate") {
+            options.codegen.profile_generate = "";
+        } else if (arg.starts_with("--profile-generate=")) {
+            options.codegen.profile_generate = std::string(arg.substr(arg.find('=') + 1));
+        } else if (arg.starts_with("--profile-use=")) {
+            options.codegen.profile_use = std::string(arg.substr(arg.find('=') + 1));
+        } else if (arg.starts_with("--devirt-guards=")) {
+            if (!parse_count_option(arg, options.codegen.max_devirt_guards)) {
+                return std::nullopt;
+            }
+        } else if (arg.starts_with("--type-switch-threshold=")) {
+            if (!parse_count_option(arg, options.codegen.type_switch_threshold)) {
+                return std::nullopt;
+            }
+        } else if (arg.starts_with("--customize-budget=")) {
+            if (!parse_count_option(arg, options.codegen.customize_budget)) {
+                return std::nullopt;
+            }
+        } else if (arg.starts_with("-j")) {
+            auto count = arg.size() > 2 ? parse_count(arg.substr(2)) : i + 1 < argc ? parse_count(argv[++i]) : std::nullopt;
+            if (!count.has_value() || *count == 0) {
+                std::cerr << "-j expects a positive thread count\n";
+                return std::nullopt;
+            }
+            options.threads = *count;
+            options.codegen.codegen_threads = *count;
+        } else if (arg.starts_with("-") || !options.input_file.empty()) {
+            std::cerr << "Unknown argument '" << arg << "'\n";
+            return std::nullopt;
+        } else {
+            options.input_file = arg;
+        }
+    }
+    if (options.input_file.empty()) {
+        return std::nullopt;
+    }
+    if (options.codegen.profile_generate.has_value() && options.codegen.profile_use.has_value()) {
+        std::cerr << "--profile-generate and --profile-use are mutually exclusive\n";
+        return std::nullopt;
+    }
+    if (options.run + options.interpret + options.tiered > 1) {
+        std::cerr << "--run, --interp and --tiered are mutually exclusive\n";
+        return std::nullopt;
+    }
+    if (options.tier_threshold == 0) {
+        std::cerr << "--tier-threshold must be positive\n";
+        return std::nullopt;
+    }
+    if ((options.run || options.tiered) && options.codegen.profile_generate.has_value()) {
+        std::cerr << "--profile-generate needs the profile runtime and cannot be used with --run or --tiered\n";
+        return std::nullopt;
+    }
+    if (options.codegen.profile_use.has_value() && !std::filesystem::exists(*options.codegen.profile_use)) {
+        std::cerr << "Profile file '" << *options.codegen.profile_use << "' does not exist\n";
+        return std::nullopt;
+    }
+    return options;
+}
+
+int run_interpreter(codegen::bytecode::interpreter& vm) {
+    try {
+        return vm.run();
+    } catch (std::exception& e) {
+        std::cerr << "Runtime error : \n" << e.what() << "\n";
+        return 1;
+    }
+}
+
+// lowers the program and hands the module over; the codegen ends here, so nothing is left referring to the context
+std::pair<std::unique_ptr<::llvm::LLVMContext>, std::unique_ptr<::llvm::Module>> emit_module(
+    const std::string& module_name, const codegen::ast::flat::program& program, const codegen::llvm_ir::codegen_options& options) {
+    codegen::llvm_ir::llvm_codegen ir_gen{module_name, "Main", options};
+    ir_gen.emit(program);
+    return std::move(ir_gen).release_module();
+}
+
+} // namespace
+
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cout << "Usage: ./compiler <input_file>\n";
+    auto options = parse_arguments(argc, argv);
+    if (!options.has_value()) {
+        print_usage();
         return 1;
     }
 
-    std::ifstream s(argv[1]);
-    std::string file_content((std::istreambuf_iterator<char>(s)), std::istreambuf_iterator<char>());
+    // owns the source text; tokens and diagnostics keep views into it until the end of main
+    common::source_manager sources;
 
     try {
-        auto tokens_res = lexer::tokenize_text(file_content);
-        auto parser = parser::parser(tokens_res);
+        auto file_content = sources.load(options->input_file);
+        auto parser = parser::parser(lexer::token_stream{file_content});
         auto parsing_ast = parser.parse();
-        auto semantic_ast = analysis::semantic::check_program(parsing_ast, argv[1], file_content);
+        auto checked = analysis::semantic::check_program(parsing_ast, options->threads);
+        if (!checked.diagnostics.empty()) {
+            analysis::semantic::error_formatter errors{options->input_file, file_content};
+            std::cerr << "Compilation error : \n" << errors.format(checked.diagnostics);
+            return 1;
+        }
+        auto& semantic_ast = checked.program;
+        if (options->memory_stats) {
+            std::cerr << "parse tree: " << parsing_ast->nodes.bytes_reserved() / 1024 << " KiB\n"
+                      << "codegen tree: " << semantic_ast->nodes.bytes_reserved() / 1024 << " KiB\n";
+        }
+        // nothing refers to the parse tree after the semantic phases, its arena goes away in one piece
+        parsing_ast.reset();
 
-        codegen::llvm_ir::llvm_codegen ir_gen{std::string(argv[1])};
-        ir_gen.emit(*semantic_ast);
+        if (options->interpret) {
+            auto program = codegen::bytecode::bytecode_compiler{"Main"}.compile(*semantic_ast);
+            codegen::bytecode::interpreter vm{*program};
+            return run_interpreter(vm);
+        }
+        if (options->tiered) {
+            auto program = codegen::bytecode::bytecode_compiler{"Main"}.compile(*semantic_ast);
+            codegen::llvm_ir::tiered_jit tier{*program, codegen::ast::flat::flatten(*semantic_ast), options->input_file, options->codegen};
+            codegen::bytecode::interpreter vm{*program, &tier, options->tier_threshold};
+            auto status = run_interpreter(vm);
+            if (options->memory_stats) {
+                std::cerr << "lowered to IR: " << tier.lowered_functions() << " of " << tier.declared_functions() << " functions\n";
+            }
+            return status;
+        }
 
-        std::filesystem::path input_path(argv[1]);
+        auto flat_ast = codegen::ast::flat::flatten(*semantic_ast);
+        if (options->memory_stats) {
+            std::cerr << "flat codegen nodes: " << flat_ast.size() << ", " << flat_ast.bytes_used() / 1024 << " KiB\n";
+        }
+        if (options->run) {
+            auto [context, module] = emit_module(options->input_file, flat_ast, options->codegen);
+            return codegen::llvm_ir::run_module(std::move(context), std::move(module));
+        }
+
+        codegen::llvm_ir::llvm_codegen ir_gen{options->input_file, "Main", options->codegen};
+        ir_gen.emit(flat_ast);
+
+        std::filesystem::path input_path(options->input_file);
         auto ir_path = input_path;
         ir_path.replace_extension(".ll");
         auto obj_path = input_path;
@@ -41,6 +233,7 @@ int main(int argc, char* argv[]) {
             std::cerr << "Failed to write object file to " << obj_path.string() << "\n";
         }
     } catch (std::exception& e) {
-        std::cerr << "Compilation error : \n" << e.what();
+        std::cerr << "Compilation error : \n" << e.what() << "\n";
+        return 1;
     }
 }
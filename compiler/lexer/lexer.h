@@ -1,13 +1,20 @@
 #pragma once
 
 #include <algorithm>
-#include <cctype>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <charconv>
 #include <cstddef>
-#include <optional>
-#include <string>
+#include <cstdint>
+#include <cstring>
 #include <string_view>
-#include <unordered_map>
-#include <vector>
+#include <system_error>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "compiler/lexer/token.h"
 
@@ -15,278 +22,290 @@ namespace lexer {
 
 namespace impl_ {
 
-inline const std::unordered_map<std::string_view, token_type> keywords = {
+// Keywords are placed by (2 * first + 3 * last character) % 32, which is collision-free for this set; a hit is confirmed
+// by comparing the whole word.
+inline constexpr std::array<std::pair<std::string_view, token_type>, 16> keyword_list = {{
     {"class", token_type::tok_kw_class},   {"extends", token_type::tok_kw_extends}, {"is", token_type::tok_kw_is},         {"var", token_type::tok_kw_var},
     {"method", token_type::tok_kw_method}, {"if", token_type::tok_kw_if},           {"then", token_type::tok_kw_then},     {"else", token_type::tok_kw_else},
     {"while", token_type::tok_kw_while},   {"loop", token_type::tok_kw_loop},       {"return", token_type::tok_kw_return}, {"end", token_type::tok_kw_end},
-    {"this", token_type::tok_kw_this},     {"true", token_type::tok_kw_true},       {"false", token_type::tok_kw_false},   {"super", token_type::tok_kw_super}};
+    {"this", token_type::tok_kw_this},     {"true", token_type::tok_kw_true},       {"false", token_type::tok_kw_false},   {"super", token_type::tok_kw_super}}};
 
-inline bool is_identifier_char(char c, bool first_char = false) noexcept {
-    if (first_char) {
-        return std::isalpha(c) != 0 || c == '_';
-    }
-    return std::isalnum(c) != 0 || c == '_';
+constexpr size_t keyword_hash(std::string_view word) noexcept {
+    return (2 * static_cast<unsigned char>(word.front()) + 3 * static_cast<unsigned char>(word.back())) % 32;
 }
 
-inline bool is_digit(char c) noexcept {
-    return std::isdigit(static_cast<unsigned char>(c));
-}
+inline constexpr auto keyword_table = [] {
+    std::array<std::pair<std::string_view, token_type>, 32> table{};
+    table.fill({"", token_type::tok_identifier});
+    for (const auto& keyword : keyword_list) {
+        table[keyword_hash(keyword.first)] = keyword;
+    }
+    return table;
+}();
 
-struct lexeme_parser {
+static_assert(std::ranges::all_of(keyword_list, [](const auto& keyword) { return keyword_table[keyword_hash(keyword.first)] == keyword; }),
+              "keyword_hash maps two keywords to the same slot");
 
-    lexeme_parser(std::string_view text) noexcept
-        : text(text),
-          line_num{1},
-          column_num{} {}
+// `word` is not empty
+inline token_type find_keyword(std::string_view word) noexcept {
+    const auto& slot = keyword_table[keyword_hash(word)];
+    return slot.first == word ? slot.second : token_type::tok_identifier;
+}
 
-    token take_next_token() noexcept {
-        skip_whitespace();
-        skip_comment();
+// Character classes as the C locale defines them; whitespace leaves out '\n', which is a token.
+enum char_class : uint8_t {
+    identifier_start = 1 << 0,
+    identifier_char = 1 << 1,
+    digit = 1 << 2,
+    space = 1 << 3,
+};
 
-        if (auto ident_token_opt{try_identificator_or_keyword()}; ident_token_opt.has_value()) {
-            return *ident_token_opt;
+inline constexpr auto char_classes = [] {
+    std::array<uint8_t, 256> classes{};
+    for (int c = 0; c < 256; ++c) {
+        bool is_letter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        bool is_digit = c >= '0' && c <= '9';
+        if (is_letter || c == '_') {
+            classes[c] |= identifier_start;
         }
-
-        if (auto num_token_opt{try_number()}; num_token_opt.has_value()) {
-            return *num_token_opt;
+        if (is_letter || is_digit || c == '_') {
+            classes[c] |= identifier_char;
         }
-
-        auto symbol_opt{take_next_symbol()};
-
-        if (!symbol_opt.has_value()) {
-            return token{.type = token_type::tok_eof, .span = {.line_num = line_num, .start_pos = column_num, .end_pos = column_num + 1}, .value = ""};
+        if (is_digit) {
+            classes[c] |= digit;
         }
-
-        char symbol{*symbol_opt};
-
-        switch (symbol) {
-        case '(':
-            return token{.type = token_type::tok_open_par, .span{.line_num = line_num, .start_pos = column_num, .end_pos = column_num + 1}, .value = "("};
-        case ')':
-            return token{.type = token_type::tok_close_par, .span{.line_num = line_num, .start_pos = column_num, .end_pos = column_num + 1}, .value = ")"};
-        case ':':
-            if (auto next_symbol{peek_next_symbol().value_or(' ')}; next_symbol == '=') {
-                std::ignore = take_next_symbol();
-                return token{
-                    .type = token_type::tok_assignment, .span{.line_num = line_num, .start_pos = column_num - 1, .end_pos = column_num + 1}, .value = ":="};
-            } else {
-                return token{.type = token_type::tok_colon, .span{.line_num = line_num, .start_pos = column_num, .end_pos = column_num + 1}, .value = ":"};
-            }
-        case '.':
-            return token{.type = token_type::tok_dot, .span{.line_num = line_num, .start_pos = column_num, .end_pos = column_num + 1}, .value = "."};
-        case ',':
-            return token{.type = token_type::tok_comma, .span{.line_num = line_num, .start_pos = column_num, .end_pos = column_num + 1}, .value = ","};
-        case '=':
-            if (auto next_symbol{peek_next_symbol().value_or(' ')}; next_symbol == '>') {
-                std::ignore = take_next_symbol();
-                return token{
-                    .type = token_type::tok_fat_arrow, .span{.line_num = line_num, .start_pos = column_num - 1, .end_pos = column_num + 1}, .value = "=>"};
-            } else {
-                return token{.type = token_type::tok_unknown, .span{.line_num = line_num, .start_pos = column_num, .end_pos = column_num + 1}, .value = ""};
-            }
-        case '\n':
-            return token{.type = token_type::tok_new_line, .span{.line_num = line_num, .start_pos = column_num, .end_pos = column_num + 1}, .value = "\\n"};
+        if (c == ' ' || c == '\t' || c == '\v' || c == '\f' || c == '\r') {
+            classes[c] |= space;
         }
-
-        return token{.type = token_type::tok_unknown, .span{.line_num = line_num, .start_pos = column_num, .end_pos = column_num + 1}, .value = ""};
     }
+    return classes;
+}();
 
-  private:
-    void skip_whitespace() noexcept {
-        for (auto next_symbol{peek_next_symbol()}; next_symbol.has_value() && std::isspace(*next_symbol) && *next_symbol != '\n';
-             next_symbol = peek_next_symbol()) {
-            std::ignore = take_next_symbol();
-        }
-    }
+inline bool has_class(char c, char_class cls) noexcept {
+    return (char_classes[static_cast<unsigned char>(c)] & cls) != 0;
+}
 
-    void skip_comment() noexcept {
-        if (auto next_symbol{peek_next_symbol()}; next_symbol.has_value() && *next_symbol == '/') {
-            if (auto next_next_symbol{peek_next_symbol(1)}; next_next_symbol.has_value() && *next_next_symbol == '/') {
-                take_next_symbol();
-                take_next_symbol();
-                while (true) {
-                    auto current_symbol{peek_next_symbol()};
-                    if (!current_symbol.has_value() || *current_symbol == '\n') {
-                        break;
-                    }
-                    take_next_symbol();
-                }
-            }
-        }
+inline size_t skip_class(std::string_view text, size_t pos, char_class cls) noexcept {
+    while (pos < text.size() && has_class(text[pos], cls)) {
+        ++pos;
     }
+    return pos;
+}
 
-    std::optional<token> try_identificator_or_keyword() {
-        auto symbol_opt{peek_next_symbol()};
+#if defined(__SSE2__)
+// 16 bytes at a time while a full block is left; bytes >= 0x80 compare as negative and fall outside every range
+inline __m128i byte_in_range(__m128i chunk, char low, char high) noexcept {
+    return _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8(static_cast<char>(low - 1))), _mm_cmplt_epi8(chunk, _mm_set1_epi8(static_cast<char>(high + 1))));
+}
 
-        if (!symbol_opt.has_value()) {
-            return token{.type = token_type::tok_eof, .span = {.line_num = line_num, .start_pos = column_num, .end_pos = column_num + 1}, .value = ""};
+template<typename Classify>
+size_t skip_blocks(std::string_view text, size_t pos, Classify classify) noexcept {
+    while (pos + 16 <= text.size()) {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + pos));
+        auto mask = static_cast<uint32_t>(_mm_movemask_epi8(classify(chunk)));
+        if (mask != 0xFFFF) {
+            return pos + std::countr_one(mask);
         }
+        pos += 16;
+    }
+    return pos;
+}
+#endif
+
+inline size_t skip_identifier_chars(std::string_view text, size_t pos) noexcept {
+#if defined(__SSE2__)
+    pos = skip_blocks(text, pos, [](__m128i chunk) {
+        auto letter = byte_in_range(_mm_or_si128(chunk, _mm_set1_epi8(0x20)), 'a', 'z');
+        auto digit_or_underscore = _mm_or_si128(byte_in_range(chunk, '0', '9'), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('_')));
+        return _mm_or_si128(letter, digit_or_underscore);
+    });
+#endif
+    return skip_class(text, pos, identifier_char);
+}
 
-        char symbol{*symbol_opt};
+inline size_t skip_spaces(std::string_view text, size_t pos) noexcept {
+#if defined(__SSE2__)
+    // a single space is by far the most common case, don't start a block scan for it
+    if (pos + 1 < text.size() && has_class(text[pos + 1], space)) {
+        pos = skip_blocks(text, pos, [](__m128i chunk) {
+            auto control = _mm_andnot_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')), byte_in_range(chunk, '\t', '\r'));
+            return _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), control);
+        });
+    }
+#endif
+    return skip_class(text, pos, space);
+}
 
-        size_t start_col = column_num + 1;
-        if (is_identifier_char(symbol, true)) {
-            size_t length = 1;
+// Same tokens as reference::lexeme_parser, which tests/lexer-differential.cpp checks: identifier runs and whitespace are
+// scanned 16 bytes at a time, comments with memchr, keywords through a perfect hash and numbers with std::from_chars.
+// Produces one token per call, tok_eof once the source is exhausted; nothing is copied out of the source.
+struct lexeme_parser {
 
-            auto next_symbol{peek_next_symbol(length).value_or(' ')};
-            while (is_identifier_char(next_symbol)) {
-                length++;
-                next_symbol = peek_next_symbol(length).value_or(' ');
-            }
+    explicit lexeme_parser(std::string_view text) noexcept
+        : text(text) {}
 
-            auto ident_opt = take_sequence(length);
-            if (not ident_opt.has_value()) {
-                return token{.type = token_type::tok_eof, .span = {.line_num = line_num, .start_pos = start_col, .end_pos = column_num + 1}, .value = ""};
-            }
-            auto ident = *ident_opt;
-
-            if (auto it = keywords.find(ident); it != keywords.end()) {
-                return token{
-                    .type = it->second, .span = {.line_num = line_num, .start_pos = start_col, .end_pos = column_num + 1}, .value = std::string(ident)};
-            } else {
-                return token{.type = token_type::tok_identifier,
-                             .span = {.line_num = line_num, .start_pos = start_col, .end_pos = column_num + 1},
-                             .value = std::string(ident)};
-            }
+    // the value of a tok_int or tok_real is stored to `literal`
+    token take_next_token(literal_value& literal) noexcept {
+        pos = skip_spaces(text, pos);
+        if (peek() == '/' && peek(1) == '/') {
+            auto* end = static_cast<const char*>(std::memchr(text.data() + pos + 2, '\n', text.size() - pos - 2));
+            pos = end == nullptr ? text.size() : static_cast<size_t>(end - text.data());
         }
 
-        return std::nullopt;
-    }
-
-    std::optional<token> try_number() {
-        auto symbol_opt{peek_next_symbol()};
-
-        if (!symbol_opt.has_value()) {
-            return token{.type = token_type::tok_eof, .span = {.line_num = line_num, .start_pos = column_num, .end_pos = column_num + 1}, .value = ""};
+        if (pos >= text.size()) {
+            return make_token(token_type::tok_eof, pos, 0);
         }
 
-        char symbol{*symbol_opt};
-
-        size_t start_col = column_num + 1;
-        bool is_negative{};
-        if (symbol == '-') {
-            is_negative = true;
-            take_next_symbol();
-            symbol_opt = peek_next_symbol();
-            if (!symbol_opt.has_value()) {
-                return token{.type = token_type::tok_eof, .span = {.line_num = line_num, .start_pos = column_num, .end_pos = column_num + 1}, .value = ""};
-            }
-            symbol = *symbol_opt;
+        if (has_class(text[pos], identifier_start)) {
+            auto start = pos;
+            pos = skip_identifier_chars(text, pos + 1);
+            return make_token(find_keyword(text.substr(start, pos - start)), start, pos - start);
         }
 
-        if (is_digit(symbol)) {
-            size_t length = 1;
-
-            auto next_symbol{peek_next_symbol(length).value_or(' ')};
-            while (is_digit(next_symbol)) {
-                length++;
-                next_symbol = peek_next_symbol(length).value_or(' ');
-            }
+        if (has_class(text[pos], digit) || (text[pos] == '-' && has_class(peek(1), digit))) {
+            return take_number(literal);
+        }
 
-            auto separator{peek_next_symbol(length).value_or(' ')};
-            auto after_separator{peek_next_symbol(length + 1).value_or(' ')};
-            bool is_real(separator == '.' && is_digit(after_separator));
-
-            if (is_real) {
-                length++;
-                next_symbol = peek_next_symbol(length).value_or(' ');
-                while (is_digit(next_symbol)) {
-                    length++;
-                    next_symbol = peek_next_symbol(length).value_or(' ');
-                }
+        // a lone '-' is dropped together with whatever follows it
+        if (text[pos] == '-') {
+            ++pos;
+            if (pos >= text.size()) {
+                return make_token(token_type::tok_eof, pos, 0);
             }
+        }
 
-            auto num_opt = take_sequence(length);
-            if (not num_opt.has_value()) {
-                return token{.type = token_type::tok_eof, .span = {.line_num = line_num, .start_pos = start_col, .end_pos = column_num + 1}, .value = ""};
+        auto start = pos++;
+        switch (text[start]) {
+        case '(':
+            return make_token(token_type::tok_open_par, start, 1);
+        case ')':
+            return make_token(token_type::tok_close_par, start, 1);
+        case ':':
+            if (peek() == '=') {
+                ++pos;
+                return make_token(token_type::tok_assignment, start, 2);
             }
-            auto num = *num_opt;
-
-            if (is_real) {
-                auto value{is_negative ? -1 * std::stod(std::string(num)) : std::stod(std::string(num))};
-                return token{.type = token_type::tok_real,
-                             .span = {.line_num = line_num, .start_pos = start_col, .end_pos = column_num + 1},
-                             .value = value};
-            } else {
-                auto value{is_negative ? -1 * std::stoi(std::string(num)) : std::stoi(std::string(num))};
-                return token{.type = token_type::tok_int,
-                             .span = {.line_num = line_num, .start_pos = start_col, .end_pos = column_num + 1},
-                             .value = value};
+            return make_token(token_type::tok_colon, start, 1);
+        case '.':
+            return make_token(token_type::tok_dot, start, 1);
+        case ',':
+            return make_token(token_type::tok_comma, start, 1);
+        case '=':
+            if (peek() == '>') {
+                ++pos;
+                return make_token(token_type::tok_fat_arrow, start, 2);
             }
+            return make_token(token_type::tok_unknown, start, 1);
+        case '\n': {
+            auto new_line = make_token(token_type::tok_new_line, start, 1);
+            ++line;
+            line_start = pos;
+            return new_line;
         }
-
-        return std::nullopt;
-    }
-
-    std::optional<char> take_next_symbol() noexcept {
-        if (text.empty()) {
-            return std::nullopt;
         }
 
-        char symbol{text[0]};
+        return make_token(token_type::tok_unknown, start, 1);
+    }
 
-        if (symbol == '\n') {
-            line_num++;
-            column_num = 0;
-        } else {
-            column_num++;
-        }
+  private:
+    char peek(size_t ahead = 0) const noexcept {
+        return pos + ahead < text.size() ? text[pos + ahead] : '\0';
+    }
 
-        text.remove_prefix(1);
-        return symbol;
+    token make_token(token_type type, size_t offset, size_t length) const noexcept {
+        return token{.type = type,
+                     .offset = static_cast<uint32_t>(offset),
+                     .length = static_cast<uint32_t>(length),
+                     .line = static_cast<uint32_t>(line),
+                     .column = static_cast<uint32_t>(offset - line_start),
+                     .literal = 0};
     }
 
-    std::optional<std::string_view> take_sequence(size_t length) noexcept {
-        if (length > text.size()) {
-            return std::nullopt;
+    // a literal that doesn't fit Integer or Real becomes tok_unknown, the parser reports it as an unexpected token
+    token take_number(literal_value& literal) noexcept {
+        auto start = pos;
+        if (text[pos] == '-') {
+            ++pos;
         }
+        pos = skip_class(text, pos, digit);
 
-        std::string_view char_seq{text.substr(0, length)};
-
-        auto new_line_symbols{std::ranges::count(char_seq, '\n')};
-        if (new_line_symbols > 0) { // multi-line sequence
-            auto last_new_line_symbol{char_seq.find_last_of('\n')};
-
-            column_num = char_seq.size() - last_new_line_symbol + 1;
-            line_num += new_line_symbols;
-        } else { // one-line sequence
-            column_num += length;
+        bool is_real = peek() == '.' && has_class(peek(1), digit);
+        if (is_real) {
+            pos = skip_class(text, pos + 1, digit);
         }
 
-        text.remove_prefix(length);
-
-        return char_seq;
-    }
-
-    std::optional<char> peek_next_symbol(size_t pos = 0) noexcept {
-        if (pos >= text.size()) {
-            return std::nullopt;
+        const char* first = text.data() + start;
+        const char* last = text.data() + pos;
+        if (is_real) {
+            double value{};
+            if (auto [end, error] = std::from_chars(first, last, value); error == std::errc{} && end == last) {
+                literal = value;
+                return make_token(token_type::tok_real, start, pos - start);
+            }
+        } else {
+            int value{};
+            if (auto [end, error] = std::from_chars(first, last, value); error == std::errc{} && end == last) {
+                literal = value;
+                return make_token(token_type::tok_int, start, pos - start);
+            }
         }
-
-        return text[pos];
+        return make_token(token_type::tok_unknown, start, pos - start);
     }
 
     std::string_view text;
-    size_t line_num{1};
-    size_t column_num;
+    size_t pos{0};
+    size_t line{1};
+    size_t line_start{0};
 };
 
 } // namespace impl_
 
-inline std::vector<token> tokenize_text(std::string_view text) noexcept {
-    auto parser{impl_::lexeme_parser(text)};
+// Pull-based token source of the parser. Tokens are lexed when the parser first reaches them and only the last `window`
+// ones are kept, which covers its one token of lookahead and one step back; memory doesn't grow with the source.
+// The stream keeps a view of the source, which has to outlive it.
+class token_stream {
+public:
+    static constexpr size_t window = 8;
+
+    explicit token_stream(std::string_view source) noexcept
+        : source(source),
+          lexer(source) {}
+
+    // token number `index` of the source, tok_eof past the end
+    const token& at(size_t index) noexcept {
+        assert(index + window > lexed && "token already dropped from the lookahead window");
+        while (index >= lexed) {
+            pull();
+        }
+        return tokens[index % window];
+    }
 
-    // reserve?
-    std::vector<token> tokens;
+    std::string_view text(const token& tok) const noexcept {
+        return source.substr(tok.offset, tok.length);
+    }
 
-    while (true) {
-        auto token{parser.take_next_token()};
-        tokens.push_back(token);
+    // fewer than `window` literals are lexed while a token is in the window, so its slot is still intact
+    const literal_value& literal(const token& tok) const noexcept {
+        return literals[tok.literal % window];
+    }
 
-        if (token.type == token_type::tok_eof) {
-            return tokens;
+private:
+    void pull() noexcept {
+        literal_value value;
+        auto tok = lexer.take_next_token(value);
+        if (tok.type == token_type::tok_int || tok.type == token_type::tok_real) {
+            tok.literal = literals_lexed++;
+            literals[tok.literal % window] = value;
         }
+        tokens[lexed++ % window] = tok;
     }
-}
+
+    std::string_view source;
+    impl_::lexeme_parser lexer;
+    std::array<token, window> tokens{};
+    std::array<literal_value, window> literals{};
+    size_t lexed{0};
+    uint32_t literals_lexed{0};
+};
 
 } // namespace lexer
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "compiler/lexer/token.h"
+
+namespace lexer::reference {
+
+inline const std::unordered_map<std::string_view, token_type> keywords = {
+    {"class", token_type::tok_kw_class},   {"extends", token_type::tok_kw_extends}, {"is", token_type::tok_kw_is},         {"var", token_type::tok_kw_var},
+    {"method", token_type::tok_kw_method}, {"if", token_type::tok_kw_if},           {"then", token_type::tok_kw_then},     {"else", token_type::tok_kw_else},
+    {"while", token_type::tok_kw_while},   {"loop", token_type::tok_kw_loop},       {"return", token_type::tok_kw_return}, {"end", token_type::tok_kw_end},
+    {"this", token_type::tok_kw_this},     {"true", token_type::tok_kw_true},       {"false", token_type::tok_kw_false},   {"super", token_type::tok_kw_super}};
+
+inline bool is_identifier_char(char c, bool first_char = false) noexcept {
+    auto symbol = static_cast<unsigned char>(c);
+    if (first_char) {
+        return std::isalpha(symbol) != 0 || c == '_';
+    }
+    return std::isalnum(symbol) != 0 || c == '_';
+}
+
+inline bool is_digit(char c) noexcept {
+    return std::isdigit(static_cast<unsigned char>(c));
+}
+
+// Straightforward character-at-a-time lexer. The token stream uses the faster lexer in lexer.h, this one is kept as the
+// specification it is tested against (see tests/lexer-differential.cpp). Produces one token per call, tok_eof once the
+// source is exhausted.
+struct lexeme_parser {
+
+    explicit lexeme_parser(std::string_view text) noexcept
+        : text(text) {}
+
+    // the value of a tok_int or tok_real is stored to `literal`
+    token take_next_token(literal_value& literal) noexcept {
+        skip_whitespace();
+        skip_comment();
+
+        if (pos >= text.size()) {
+            return make_token(token_type::tok_eof, pos, 0);
+        }
+
+        if (is_identifier_char(text[pos], true)) {
+            return take_identifier_or_keyword();
+        }
+
+        if (is_digit(text[pos]) || (text[pos] == '-' && is_digit(peek(1)))) {
+            return take_number(literal);
+        }
+
+        // a lone '-' is dropped together with whatever follows it
+        if (text[pos] == '-') {
+            ++pos;
+            if (pos >= text.size()) {
+                return make_token(token_type::tok_eof, pos, 0);
+            }
+        }
+
+        auto start = pos++;
+        switch (text[start]) {
+        case '(':
+            return make_token(token_type::tok_open_par, start, 1);
+        case ')':
+            return make_token(token_type::tok_close_par, start, 1);
+        case ':':
+            if (peek() == '=') {
+                ++pos;
+                return make_token(token_type::tok_assignment, start, 2);
+            }
+            return make_token(token_type::tok_colon, start, 1);
+        case '.':
+            return make_token(token_type::tok_dot, start, 1);
+        case ',':
+            return make_token(token_type::tok_comma, start, 1);
+        case '=':
+            if (peek() == '>') {
+                ++pos;
+                return make_token(token_type::tok_fat_arrow, start, 2);
+            }
+            return make_token(token_type::tok_unknown, start, 1);
+        case '\n': {
+            auto new_line = make_token(token_type::tok_new_line, start, 1);
+            ++line;
+            line_start = pos;
+            return new_line;
+        }
+        }
+
+        return make_token(token_type::tok_unknown, start, 1);
+    }
+
+  private:
+    char peek(size_t ahead = 0) const noexcept {
+        return pos + ahead < text.size() ? text[pos + ahead] : '\0';
+    }
+
+    token make_token(token_type type, size_t offset, size_t length) const noexcept {
+        return token{.type = type,
+                     .offset = static_cast<uint32_t>(offset),
+                     .length = static_cast<uint32_t>(length),
+                     .line = static_cast<uint32_t>(line),
+                     .column = static_cast<uint32_t>(offset - line_start),
+                     .literal = 0};
+    }
+
+    void skip_whitespace() noexcept {
+        while (pos < text.size() && text[pos] != '\n' && std::isspace(static_cast<unsigned char>(text[pos]))) {
+            ++pos;
+        }
+    }
+
+    void skip_comment() noexcept {
+        if (peek() == '/' && peek(1) == '/') {
+            auto end = text.find('\n', pos + 2);
+            pos = end == std::string_view::npos ? text.size() : end;
+        }
+    }
+
+    token take_identifier_or_keyword() noexcept {
+        auto start = pos++;
+        while (pos < text.size() && is_identifier_char(text[pos])) {
+            ++pos;
+        }
+
+        auto ident = text.substr(start, pos - start);
+        auto type = token_type::tok_identifier;
+        if (auto it = keywords.find(ident); it != keywords.end()) {
+            type = it->second;
+        }
+        return make_token(type, start, pos - start);
+    }
+
+    token take_number(literal_value& literal) noexcept {
+        auto start = pos;
+        bool is_negative = text[pos] == '-';
+        if (is_negative) {
+            ++pos;
+        }
+
+        auto digits_start = pos;
+        while (pos < text.size() && is_digit(text[pos])) {
+            ++pos;
+        }
+
+        bool is_real = peek() == '.' && is_digit(peek(1));
+        if (is_real) {
+            ++pos;
+            while (pos < text.size() && is_digit(text[pos])) {
+                ++pos;
+            }
+        }
+
+        std::string digits{text.substr(digits_start, pos - digits_start)};
+        if (is_real) {
+            auto value{std::stod(digits)};
+            literal = is_negative ? -1 * value : value;
+            return make_token(token_type::tok_real, start, pos - start);
+        }
+        auto value{std::stoi(digits)};
+        literal = is_negative ? -1 * value : value;
+        return make_token(token_type::tok_int, start, pos - start);
+    }
+
+    std::string_view text;
+    size_t pos{0};
+    size_t line{1};
+    size_t line_start{0};
+};
+
+} // namespace lexer::reference
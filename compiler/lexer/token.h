@@ -1,8 +1,9 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <format>
-#include <string>
+#include <string_view>
 #include <variant>
 
 #include "compiler/compilation-structures/common.h"
@@ -44,23 +45,35 @@ enum class token_type : uint8_t {
     tok_unknown
 };
 
-using token_value = std::variant<int, double, std::string>;
-
+// Plain 24-byte record: the token's text is source.substr(offset, length), so identifiers and keywords are views into
+// the source buffer and nothing is allocated per token. The position is recorded while lexing, the line table is not
+// kept.
 struct token {
     token_type type;
-    common::span span;
-    token_value value;
+    uint32_t offset;
+    uint32_t length;
+    uint32_t line;
+    // 0-based
+    uint32_t column;
+    // tok_int and tok_real: number of the literal in the source, see token_stream::literal
+    uint32_t literal;
+};
 
-    template<typename T>
-    bool is() const noexcept {
-        return std::holds_alternative<T>(value);
-    }
+using literal_value = std::variant<int, double>;
 
-    template<typename T>
-    const T& as() const noexcept {
-        return std::get<T>(value);
+inline common::span span_of(const token& tok) noexcept {
+    size_t line = tok.line;
+    size_t column = tok.column;
+    switch (tok.type) {
+    case token_type::tok_new_line:
+        // reported at the start of the line it ends
+        return {.line_num = line + 1, .start_pos = 0, .end_pos = 1};
+    case token_type::tok_eof:
+        return {.line_num = line, .start_pos = column, .end_pos = column + 1};
+    default:
+        return {.line_num = line, .start_pos = column + 1, .end_pos = column + tok.length + 1};
     }
-};
+}
 
 namespace impl_ {
 inline constexpr std::string_view token_type_to_string(token_type type) noexcept {
@@ -139,22 +152,10 @@ struct std::formatter<lexer::token> {
 
     template<typename FmtContext>
     auto format(const lexer::token& token, FmtContext& ctx) const noexcept {
-        auto token_type = lexer::impl_::token_type_to_string(token.type);
-
-        return std::visit(
-            [&](const auto& val) -> decltype(auto) {
-                using ValueType = std::decay_t<decltype(val)>;
-
-                if constexpr (std::is_same_v<ValueType, int>) {
-                    return std::format_to(ctx.out(), "{{type = {}, span = {}, value = \"{}\"}}\n", token_type, token.span, val);
-                } else if constexpr (std::is_same_v<ValueType, double>) {
-                    return std::format_to(ctx.out(), "{{type = {}, span = {}, value = \"{}\"}}\n", token_type, token.span, val);
-                } else if constexpr (std::is_same_v<ValueType, std::string>) {
-                    return std::format_to(ctx.out(), "{{type = {}, span = {}, value = \"{}\"}}\n", token_type, token.span, val);
-                } else {
-                    return std::format_to(ctx.out(), "{{type = {}, span = {}, value = \"unknown_value\"}}\n", token_type, token.span);
-                }
-            },
-            token.value);
+        return std::format_to(ctx.out(),
+                              "{{type = {}, offset = {}, length = {}}}\n",
+                              lexer::impl_::token_type_to_string(token.type),
+                              token.offset,
+                              token.length);
     }
 };
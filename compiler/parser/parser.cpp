@@ -10,11 +10,11 @@
 
 namespace parser {
 
-parser::parser(std::vector<lexer::token> _tokens)
-    : tokens(std::move(_tokens)) {}
+parser::parser(lexer::token_stream _tokens)
+    : stream(std::move(_tokens)) {}
 
 void parser::advance() {
-    if (current < tokens.size())
+    if (!check(lexer::token_type::tok_eof))
         ++current;
 }
 
@@ -29,9 +29,8 @@ void parser::skip_newlines() {
     }
 }
 
-bool parser::check(lexer::token_type type) const {
-    // if (current >= tokens.size()) return false;
-    return tokens[current].type == type;
+bool parser::check(lexer::token_type type) {
+    return stream.at(current).type == type;
 }
 
 bool parser::match(lexer::token_type type) {
@@ -42,16 +41,15 @@ bool parser::match(lexer::token_type type) {
     return false;
 }
 
-lexer::token parser::peek() const {
-    if (current >= tokens.size())
-        return tokens.back(); // tok_eof
-    return tokens[current];
+// tokens are returned by value, the stream's window slides on as the parser advances
+lexer::token parser::peek() {
+    return stream.at(current);
 }
 
-lexer::token parser::previous() const {
+lexer::token parser::previous() {
     if (current == 0)
-        return tokens[0];
-    return tokens[current - 1];
+        return stream.at(0);
+    return stream.at(current - 1);
 }
 
 lexer::token parser::consume(lexer::token_type expected, std::string_view message) {
@@ -60,7 +58,11 @@ lexer::token parser::consume(lexer::token_type expected, std::string_view messag
         advance();
         return tok;
     }
-    throw parse_error(std::format("{} at line {} pos {}:{}\n", message, peek().span.line_num, peek().span.start_pos, peek().span.end_pos));
+    throw parse_error(std::format("{} at line {} pos {}:{}\n", message, lexer::span_of(peek()).line_num, lexer::span_of(peek()).start_pos, lexer::span_of(peek()).end_pos));
+}
+
+common::symbol_id parser::name_of(const lexer::token& tok) const {
+    return common::symbol_id{stream.text(tok)};
 }
 
 std::unique_ptr<ast::program> parser::parse() {
@@ -69,7 +71,8 @@ std::unique_ptr<ast::program> parser::parse() {
 
 std::unique_ptr<ast::program> parser::parse_program() {
     auto program = std::make_unique<ast::program>();
-    program->span = peek().span;
+    common::arena::scope nodes{program->nodes};
+    program->span = lexer::span_of(peek());
     skip_newlines();
     while (not check(lexer::token_type::tok_eof)) {
         // class
@@ -86,14 +89,14 @@ std::unique_ptr<ast::class_declaration> parser::parse_class_declaration() {
 
     // class name
     auto name_tok = consume(lexer::token_type::tok_identifier, "Expected class name");
-    class_decl->name = std::get<std::string>(name_tok.value);
-    class_decl->span = name_tok.span;
+    class_decl->name = name_of(name_tok);
+    class_decl->span = lexer::span_of(name_tok);
 
     // extends
     if (match(lexer::token_type::tok_kw_extends)) {
         // base class name
         auto base_tok = consume(lexer::token_type::tok_identifier, "Expected base class name");
-        class_decl->base_class = std::get<std::string>(base_tok.value);
+        class_decl->base_class = name_of(base_tok);
         // skip_newlines();
     }
 
@@ -105,15 +108,18 @@ std::unique_ptr<ast::class_declaration> parser::parse_class_declaration() {
     while (!check(lexer::token_type::tok_kw_end) && !check(lexer::token_type::tok_eof)) {
         auto member = parse_member_expression();
 
-        if (auto var_decl = dynamic_cast<ast::variable_declaration*>(member.get())) {
-            member.release();
-            class_decl->fields.push_back(std::unique_ptr<ast::variable_declaration>(var_decl));
-        } else if (auto method_decl = dynamic_cast<ast::method_declaration*>(member.get())) {
-            member.release();
-            class_decl->methods.push_back(std::unique_ptr<ast::method_declaration>(method_decl));
-        } else if (auto ctor_decl = dynamic_cast<ast::constructor_declaration*>(member.get())) {
-            member.release();
-            class_decl->constructors.push_back(std::unique_ptr<ast::constructor_declaration>(ctor_decl));
+        switch (member->kind) {
+        case ast::node_kind::variable_declaration:
+            class_decl->fields.push_back(std::unique_ptr<ast::variable_declaration>(static_cast<ast::variable_declaration*>(member.release())));
+            break;
+        case ast::node_kind::method_declaration:
+            class_decl->methods.push_back(std::unique_ptr<ast::method_declaration>(static_cast<ast::method_declaration*>(member.release())));
+            break;
+        case ast::node_kind::constructor_declaration:
+            class_decl->constructors.push_back(std::unique_ptr<ast::constructor_declaration>(static_cast<ast::constructor_declaration*>(member.release())));
+            break;
+        default:
+            break;
         }
 
         skip_newlines();
@@ -136,7 +142,7 @@ std::unique_ptr<ast::entity> parser::parse_member_expression() {
     if (match(lexer::token_type::tok_kw_this)) {
         return parse_constructor_declaration();
     }
-    throw parse_error(std::format("Expected class member definition at line {} pos {}:{}", peek().span.line_num, peek().span.start_pos, peek().span.end_pos));
+    throw parse_error(std::format("Expected class member definition at line {} pos {}:{}", lexer::span_of(peek()).line_num, lexer::span_of(peek()).start_pos, lexer::span_of(peek()).end_pos));
 }
 
 std::unique_ptr<ast::variable_declaration> parser::parse_variable_declaration() {
@@ -144,8 +150,8 @@ std::unique_ptr<ast::variable_declaration> parser::parse_variable_declaration()
 
     // var name
     auto name_tok = consume(lexer::token_type::tok_identifier, "Expected variable name");
-    var_decl->name = std::get<std::string>(name_tok.value);
-    var_decl->span = name_tok.span;
+    var_decl->name = name_of(name_tok);
+    var_decl->span = lexer::span_of(name_tok);
 
     // :
     consume(lexer::token_type::tok_colon, "Expected ':' after variable name");
@@ -155,8 +161,8 @@ std::unique_ptr<ast::variable_declaration> parser::parse_variable_declaration()
     return var_decl;
 }
 
-std::vector<std::unique_ptr<ast::parameter_declaration>> parser::parse_parameters() {
-    std::vector<std::unique_ptr<ast::parameter_declaration>> params;
+common::arena_vector<std::unique_ptr<ast::parameter_declaration>> parser::parse_parameters() {
+    common::arena_vector<std::unique_ptr<ast::parameter_declaration>> params;
 
     // (
     consume(lexer::token_type::tok_open_par, "Expected '(' after method name");
@@ -182,8 +188,8 @@ std::unique_ptr<ast::parameter_declaration> parser::parse_parameter() {
 
     // parameter type
     auto type = consume(lexer::token_type::tok_identifier, "Expected type name");
-    auto param = std::make_unique<ast::parameter_declaration>(std::get<std::string>(name.value), std::get<std::string>(type.value));
-    param->span = name.span;
+    auto param = std::make_unique<ast::parameter_declaration>(name_of(name), name_of(type));
+    param->span = lexer::span_of(name);
     return param;
 }
 
@@ -192,8 +198,8 @@ std::unique_ptr<ast::method_declaration> parser::parse_method_declaration() {
 
     // method name
     auto name_tok = consume(lexer::token_type::tok_identifier, "Expected method name");
-    method->name = std::get<std::string>(name_tok.value);
-    method->span = name_tok.span;
+    method->name = name_of(name_tok);
+    method->span = lexer::span_of(name_tok);
 
     // parameters
     method->parameters = parse_parameters();
@@ -201,7 +207,7 @@ std::unique_ptr<ast::method_declaration> parser::parse_method_declaration() {
     // return type
     if (match(lexer::token_type::tok_colon)) {
         auto ret_tok = consume(lexer::token_type::tok_identifier, "Expected return type identifier");
-        method->return_type = std::get<std::string>(ret_tok.value);
+        method->return_type = name_of(ret_tok);
         skip_newlines();
     }
 
@@ -226,7 +232,7 @@ std::unique_ptr<ast::method_declaration> parser::parse_method_declaration() {
 
 std::unique_ptr<ast::constructor_declaration> parser::parse_constructor_declaration() {
     auto ctor = std::make_unique<ast::constructor_declaration>();
-    ctor->span = previous().span; // 'this' keyword
+    ctor->span = lexer::span_of(previous()); // 'this' keyword
 
     // parameters
     ctor->parameters = parse_parameters();
@@ -253,8 +259,8 @@ std::unique_ptr<ast::constructor_declaration> parser::parse_constructor_declarat
 }
 
 std::unique_ptr<ast::block> parser::parse_block() {
-    std::vector<std::unique_ptr<ast::entity>> items;
-    auto block_span = peek().span;
+    common::arena_vector<std::unique_ptr<ast::entity>> items;
+    auto block_span = lexer::span_of(peek());
     while (true) {
         skip_newlines();
         if (match(lexer::token_type::tok_kw_var)) {
@@ -304,8 +310,8 @@ std::unique_ptr<ast::assignment_statement> parser::parse_assignment() {
     auto ident_tok = consume(lexer::token_type::tok_identifier, "Expected identifier in assignment");
 
     auto assign = std::make_unique<ast::assignment_statement>();
-    assign->target = std::get<std::string>(ident_tok.value);
-    assign->span = ident_tok.span;
+    assign->target = name_of(ident_tok);
+    assign->span = lexer::span_of(ident_tok);
 
     // :=
     consume(lexer::token_type::tok_assignment, "Expected ':=' in assignment");
@@ -317,7 +323,7 @@ std::unique_ptr<ast::assignment_statement> parser::parse_assignment() {
 
 std::unique_ptr<ast::while_statement> parser::parse_while() {
     auto while_stmt = std::make_unique<ast::while_statement>();
-    while_stmt->span = previous().span; // 'while' keyword
+    while_stmt->span = lexer::span_of(previous()); // 'while' keyword
 
     // expr
     while_stmt->condition = parse_expression();
@@ -335,7 +341,7 @@ std::unique_ptr<ast::while_statement> parser::parse_while() {
 
 std::unique_ptr<ast::if_statement> parser::parse_if() {
     auto if_stmt = std::make_unique<ast::if_statement>();
-    if_stmt->span = previous().span; // 'if' keyword
+    if_stmt->span = lexer::span_of(previous()); // 'if' keyword
 
     // expr
     if_stmt->condition = parse_expression();
@@ -359,7 +365,7 @@ std::unique_ptr<ast::if_statement> parser::parse_if() {
 
 std::unique_ptr<ast::return_statement> parser::parse_return() {
     auto ret_stmt = std::make_unique<ast::return_statement>();
-    ret_stmt->span = previous().span; // 'return' keyword
+    ret_stmt->span = lexer::span_of(previous()); // 'return' keyword
 
     if (not check(lexer::token_type::tok_kw_end) && not check(lexer::token_type::tok_new_line)) {
         // expr
@@ -373,7 +379,7 @@ std::unique_ptr<ast::expression> parser::parse_expression() {
     auto expr = parse_primary();
     while (match(lexer::token_type::tok_dot)) {
         auto member_tok = consume(lexer::token_type::tok_identifier, "Expected member name after '.'");
-        std::string member = std::get<std::string>(member_tok.value);
+        common::symbol_id member = name_of(member_tok);
 
         // method call
         if (match(lexer::token_type::tok_open_par)) {
@@ -382,14 +388,14 @@ std::unique_ptr<ast::expression> parser::parse_expression() {
 
             // call expr
             auto member_expr = std::make_unique<ast::member_expression>(std::move(expr), member);
-            member_expr->span = member_tok.span;
+            member_expr->span = lexer::span_of(member_tok);
             auto call_expr = std::make_unique<ast::call_expression>(std::move(member_expr), std::move(args));
-            call_expr->span = member_tok.span;
+            call_expr->span = lexer::span_of(member_tok);
             expr = std::move(call_expr);
         } else {
             // field access
             auto member_expr = std::make_unique<ast::member_expression>(std::move(expr), member);
-            member_expr->span = member_tok.span;
+            member_expr->span = lexer::span_of(member_tok);
             expr = std::move(member_expr);
         }
         skip_newlines();
@@ -401,40 +407,40 @@ std::unique_ptr<ast::expression> parser::parse_primary() {
     skip_newlines();
     if (match(lexer::token_type::tok_int)) {
         // int
-        int64_t val = std::get<int>(previous().value);
+        int64_t val = std::get<int>(stream.literal(previous()));
         auto lit = std::make_unique<ast::literal_expression>(val);
-        lit->span = previous().span;
+        lit->span = lexer::span_of(previous());
         return lit;
     }
     if (match(lexer::token_type::tok_real)) {
         // real
-        double val = std::get<double>(previous().value);
+        double val = std::get<double>(stream.literal(previous()));
         auto lit = std::make_unique<ast::literal_expression>(val);
-        lit->span = previous().span;
+        lit->span = lexer::span_of(previous());
         return lit;
     }
     if (match(lexer::token_type::tok_kw_true)) {
         // true
         auto lit = std::make_unique<ast::literal_expression>(true);
-        lit->span = previous().span;
+        lit->span = lexer::span_of(previous());
         return lit;
     }
     if (match(lexer::token_type::tok_kw_false)) {
         // false
         auto lit = std::make_unique<ast::literal_expression>(false);
-        lit->span = previous().span;
+        lit->span = lexer::span_of(previous());
         return lit;
     }
     if (match(lexer::token_type::tok_kw_this)) {
         // this
         auto this_expr = std::make_unique<ast::this_expression>();
-        this_expr->span = previous().span;
+        this_expr->span = lexer::span_of(previous());
         return this_expr;
     }
     if (match(lexer::token_type::tok_identifier)) {
         // identifier
-        auto ident_span = previous().span;
-        std::string id = std::get<std::string>(previous().value);
+        auto ident_span = lexer::span_of(previous());
+        common::symbol_id id = name_of(previous());
         auto expr = std::make_unique<ast::identifier_expression>(id);
         expr->span = ident_span;
         if (match(lexer::token_type::tok_open_par)) {
@@ -451,18 +457,18 @@ std::unique_ptr<ast::expression> parser::parse_primary() {
 
     // prioritization
     if (match(lexer::token_type::tok_open_par)) {
-        auto open_span = previous().span;
+        auto open_span = lexer::span_of(previous());
         auto inner = parse_expression();
         consume(lexer::token_type::tok_close_par, "Expected ')' after grouped expression");
         auto group = std::make_unique<ast::grouping_expression>(std::move(inner));
         group->span = open_span;
         return group;
     }
-    throw parse_error(std::format("Unexpected token at line {} pos {}:{}", peek().span.line_num, peek().span.start_pos, peek().span.end_pos));
+    throw parse_error(std::format("Unexpected token at line {} pos {}:{}", lexer::span_of(peek()).line_num, lexer::span_of(peek()).start_pos, lexer::span_of(peek()).end_pos));
 }
 
-std::vector<std::unique_ptr<ast::expression>> parser::parse_arguments() {
-    std::vector<std::unique_ptr<ast::expression>> args;
+common::arena_vector<std::unique_ptr<ast::expression>> parser::parse_arguments() {
+    common::arena_vector<std::unique_ptr<ast::expression>> args;
 
     if (not check(lexer::token_type::tok_close_par)) {
         do {
@@ -475,7 +481,7 @@ std::vector<std::unique_ptr<ast::expression>> parser::parse_arguments() {
     return args;
 }
 
-std::vector<std::string> parser::parse_type_arguments() {
+common::arena_vector<common::symbol_id> parser::parse_type_arguments() {
     // TODO: only if u wanna [] for collections
     return {};
 }
@@ -8,7 +8,7 @@
 #include <vector>
 
 #include "compiler/compilation-structures/ast/parsing/ast.h"
-#include "compiler/lexer/token.h"
+#include "compiler/lexer/lexer.h"
 
 namespace parser {
 
@@ -19,22 +19,24 @@ public:
 
 class parser {
 public:
-    explicit parser(std::vector<lexer::token> tokens);
+    // tokens are lexed as the parser reaches them; the stream's source must outlive the parser
+    explicit parser(lexer::token_stream tokens);
 
     std::unique_ptr<ast::program> parse();
 
 private:
-    std::vector<lexer::token> tokens;
+    lexer::token_stream stream;
     size_t current{0};
 
     void advance();
     void retreat();
     void skip_newlines();
-    bool check(lexer::token_type type) const;
+    bool check(lexer::token_type type);
     bool match(lexer::token_type type);
-    lexer::token peek() const;
-    lexer::token previous() const;
+    lexer::token peek();
+    lexer::token previous();
     lexer::token consume(lexer::token_type expected, std::string_view message);
+    common::symbol_id name_of(const lexer::token& tok) const;
 
     std::unique_ptr<ast::program> parse_program();
     std::unique_ptr<ast::block> parse_block();
@@ -42,7 +44,7 @@ private:
     std::unique_ptr<ast::entity> parse_member_expression();
     std::unique_ptr<ast::variable_declaration> parse_variable_declaration();
     std::unique_ptr<ast::method_declaration> parse_method_declaration();
-    std::vector<std::unique_ptr<ast::parameter_declaration>> parse_parameters();
+    common::arena_vector<std::unique_ptr<ast::parameter_declaration>> parse_parameters();
     std::unique_ptr<ast::parameter_declaration> parse_parameter();
     std::unique_ptr<ast::constructor_declaration> parse_constructor_declaration();
     std::unique_ptr<ast::entity> parse_statement();
@@ -52,8 +54,8 @@ private:
     std::unique_ptr<ast::return_statement> parse_return();
     std::unique_ptr<ast::expression> parse_expression();
     std::unique_ptr<ast::expression> parse_primary();
-    std::vector<std::unique_ptr<ast::expression>> parse_arguments();
-    std::vector<std::string> parse_type_arguments();
+    common::arena_vector<std::unique_ptr<ast::expression>> parse_arguments();
+    common::arena_vector<common::symbol_id> parse_type_arguments();
 };
 
 } // namespace parser
@@ -0,0 +1,103 @@
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "compiler/lexer/lexer.h"
+#include "compiler/lexer/reference-lexer.h"
+
+// Checks that the lexer produces exactly the tokens of the reference lexer, on the given files and on generated sources.
+//   ./lexer-differential [file.po]...
+
+namespace {
+
+// Every fragment holding a digit ends with a non-digit, so concatenations never form an integer outside Integer's
+// range: the reference lexer doesn't handle those.
+constexpr std::string_view fragments[] = {
+    "class",   "extends", "is",     "var",    "method", "if",     "then",        "else",  "while", "loop",  "return",
+    "end",     "this",    "true",   "false",  "super",  "classy", "end_",        "_",     "x",     "IO",    "Integer",
+    "a1 ",     "ifthen",  "Super",  "tis",    "wile",   "ene",    "returnValue",      "identifier_longer_than_a_block_of_sixteen_", "3 ", "42.",
+    "-7 ",     "3.25 ",   "-0.5.",  "0.0 ",   "12.x",   "1..",    "2147483647 ", "-",     "- ",    "--1 ",  "(",
+    ")",       ",",       ".",      ":",      ":=",     "=",      "=>",          "==",    "/",     "//",    "// note\n",
+    " ",       "    ",    "                    ",       "\t",     "\r\n",        "\n",    "\v",    "\f",    "@",
+    "\xc3\xa9", "#",      std::string_view{"\0", 1},
+};
+
+std::string generate_source(std::mt19937& random, size_t fragment_count) {
+    std::uniform_int_distribution<size_t> pick{0, std::size(fragments) - 1};
+    std::string source;
+    for (size_t i = 0; i < fragment_count; ++i) {
+        source += fragments[pick(random)];
+    }
+    return source;
+}
+
+bool same_literal(const lexer::literal_value& lhs, const lexer::literal_value& rhs) {
+    return lhs.index() == rhs.index() && lhs == rhs;
+}
+
+void print_token(std::ostream& out, const lexer::token& tok, std::string_view source) {
+    out << lexer::impl_::token_type_to_string(tok.type) << " '" << source.substr(tok.offset, tok.length) << "' at " << tok.line << ":" << tok.column
+        << " (offset " << tok.offset << ")";
+}
+
+// reports the first differing token
+bool check_source(std::string_view name, std::string_view source) {
+    lexer::impl_::lexeme_parser fast{source};
+    lexer::reference::lexeme_parser reference{source};
+
+    for (size_t index = 0;; ++index) {
+        lexer::literal_value fast_literal, reference_literal;
+        auto actual = fast.take_next_token(fast_literal);
+        auto expected = reference.take_next_token(reference_literal);
+
+        bool is_literal = expected.type == lexer::token_type::tok_int || expected.type == lexer::token_type::tok_real;
+        if (actual.type != expected.type || actual.offset != expected.offset || actual.length != expected.length || actual.line != expected.line ||
+            actual.column != expected.column || (is_literal && !same_literal(fast_literal, reference_literal))) {
+            std::cerr << name << ": token " << index << " differs\n  lexer:     ";
+            print_token(std::cerr, actual, source);
+            std::cerr << "\n  reference: ";
+            print_token(std::cerr, expected, source);
+            std::cerr << "\n";
+            return false;
+        }
+        if (expected.type == lexer::token_type::tok_eof) {
+            return true;
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t failures = 0;
+    size_t checked = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::ifstream s{argv[i]};
+        if (!s) {
+            std::cerr << "Cannot open '" << argv[i] << "'\n";
+            return 1;
+        }
+        std::string source((std::istreambuf_iterator<char>(s)), std::istreambuf_iterator<char>());
+        failures += check_source(argv[i], source) ? 0 : 1;
+        ++checked;
+    }
+
+    std::mt19937 random{20240601};
+    for (size_t i = 0; i < 2000; ++i) {
+        auto source = generate_source(random, 1 + i % 200);
+        failures += check_source("generated source " + std::to_string(i), source) ? 0 : 1;
+        ++checked;
+    }
+
+    if (failures != 0) {
+        std::cerr << failures << " of " << checked << " sources lexed differently\n";
+        return 1;
+    }
+    std::cout << "lexer matches the reference on " << checked << " sources\n";
+    return 0;
+}
@@ -4,11 +4,29 @@
 Runs all .po test files and validates:
 - Tests in 'negative' directories should produce compilation errors (non-empty stderr)
 - All other tests should compile successfully (empty stderr)
+
+A test file may start with '// key: value' comments:
+- errors: N        the compiler reports exactly N errors
+- flags: <flags>   the program prints the same under --run with and without
+                   <flags>; may be repeated. A bare --profile-use is given a
+                   profile collected from a --profile-generate build, which
+                   needs clang and llvm-profdata on PATH
+- tier-threshold: N  the program prints the same under --tiered with this
+                   threshold as under --interp
+- lowered: N       with tier-threshold, exactly N methods and constructors
+                   get lowered to IR on the way; the cold ones never do
+
+With --compare-modes every positive test is also run under --run and under
+--interp, and the two outputs must match.
 """
 
 import os
+import re
+import shlex
+import shutil
 import subprocess
 import sys
+import tempfile
 from pathlib import Path
 from dataclasses import dataclass
 
@@ -20,6 +38,7 @@ class TestResult:
     expected_error: bool
     had_error: bool
     stderr: str
+    reason: str = ""
 
 
 def find_test_files(tests_dir: Path) -> list[Path]:
@@ -32,6 +51,20 @@ def is_negative_test(file_path: Path) -> bool:
     return "negative" in file_path.parts
 
 
+def read_directives(test_file: Path) -> dict[str, list[str]]:
+    """Read the '// key: value' comments at the top of a test file."""
+    directives: dict[str, list[str]] = {}
+    with open(test_file, encoding="utf-8") as f:
+        for line in f:
+            line = line.strip()
+            if not line.startswith("//"):
+                break
+            key, sep, value = line[2:].partition(":")
+            if sep:
+                directives.setdefault(key.strip(), []).append(value.strip())
+    return directives
+
+
 def run_compiler(compiler_path: Path, test_file: Path) -> tuple[str, str]:
     """Run the compiler on a test file and return stdout and stderr."""
     result = subprocess.run(
@@ -43,6 +76,20 @@ def run_compiler(compiler_path: Path, test_file: Path) -> tuple[str, str]:
     return result.stdout, result.stderr
 
 
+def run_program(compiler_path: Path, test_file: Path, flags: list[str]) -> tuple[str, int]:
+    """Run a test program with the given driver flags and return what it printed and its exit code."""
+    try:
+        result = subprocess.run(
+            [str(compiler_path), *flags, str(test_file)],
+            capture_output=True,
+            text=True,
+            timeout=30
+        )
+    except subprocess.TimeoutExpired:
+        return "timeout", -1
+    return result.stdout, result.returncode
+
+
 def run_test(compiler_path: Path, test_file: Path) -> TestResult:
     """Run a single test and return the result."""
     expected_error = is_negative_test(test_file)
@@ -68,13 +115,22 @@ def run_test(compiler_path: Path, test_file: Path) -> TestResult:
         )
 
     passed = (expected_error == had_error)
+    reason = ""
+
+    expected_count = read_directives(test_file).get("errors", [None])[0]
+    if passed and expected_count is not None:
+        count = len(re.findall(r": error: ", stderr))
+        if count != int(expected_count):
+            passed = False
+            reason = f"Expected {expected_count} errors, got {count}"
 
     return TestResult(
         path=test_file,
         passed=passed,
         expected_error=expected_error,
         had_error=had_error,
-        stderr=stderr
+        stderr=stderr,
+        reason=reason
     )
 
 
@@ -151,7 +207,9 @@ def run_all_tests(compiler_path: Path, tests_dir: Path) -> tuple[int, int]:
                 except ValueError:
                     pass
 
-                if r.expected_error and not r.had_error:
+                if r.reason:
+                    print(f"  {rel_path} - {r.reason}")
+                elif r.expected_error and not r.had_error:
                     print(f"  {rel_path} - Expected error but compilation succeeded")
                 elif not r.expected_error and r.had_error:
                     print(f"  {rel_path} - Unexpected compilation error")
@@ -159,15 +217,149 @@ def run_all_tests(compiler_path: Path, tests_dir: Path) -> tuple[int, int]:
     return passed_count, total
 
 
+def run_lexer_differential(compiler_path: Path, tests_dir: Path) -> bool | None:
+    """Compare the lexer with the reference lexer on every test file, when lexer-differential is built next to the compiler."""
+    binary = compiler_path.parent / "lexer-differential"
+    if not binary.exists():
+        return None
+
+    result = subprocess.run(
+        [str(binary)] + [str(f) for f in find_test_files(tests_dir)],
+        capture_output=True,
+        text=True,
+        timeout=120
+    )
+    passed = result.returncode == 0
+    GREEN = "\033[92m"
+    RED = "\033[91m"
+    RESET = "\033[0m"
+    if passed:
+        print(f"{GREEN}PASS{RESET} [lexer] {result.stdout.strip()}")
+    else:
+        print(f"{RED}FAIL{RESET} [lexer] {result.stderr.strip()[:2000]}")
+    return passed
+
+
+def run_mode_comparison(compiler_path: Path, tests_dir: Path) -> bool:
+    """Run every positive test under --run and --interp and check that both print the same output."""
+    test_files = [f for f in find_test_files(tests_dir) if not is_negative_test(f)]
+    mismatches = [
+        f for f in test_files
+        if run_program(compiler_path, f, ["--run"]) != run_program(compiler_path, f, ["--interp"])
+    ]
+    GREEN = "\033[92m"
+    RED = "\033[91m"
+    RESET = "\033[0m"
+    if not mismatches:
+        print(f"{GREEN}PASS{RESET} [modes] {len(test_files)} programs print the same under --run and --interp")
+    else:
+        print(f"{RED}FAIL{RESET} [modes] output differs between --run and --interp:")
+        for f in mismatches:
+            print(f"  {f}")
+    return not mismatches
+
+
+def collect_profile(compiler_path: Path, test_file: Path, work_dir: Path) -> Path | None:
+    """Build the program with --profile-generate, run it and merge the profile; None when the tools are missing."""
+    clang = shutil.which("clang")
+    profdata = shutil.which("llvm-profdata")
+    if clang is None or profdata is None:
+        return None
+
+    source = work_dir / test_file.name
+    shutil.copy(test_file, source)
+    raw = work_dir / "default.profraw"
+    merged = work_dir / "default.profdata"
+    binary = work_dir / "program"
+    subprocess.run([str(compiler_path), f"--profile-generate={raw}", str(source)], check=True, timeout=30)
+    subprocess.run([clang, "-fprofile-generate", str(source.with_suffix(".o")), "-lgc", "-o", str(binary)],
+                   check=True, timeout=60)
+    subprocess.run([str(binary)], capture_output=True, timeout=30)
+    subprocess.run([profdata, "merge", "-o", str(merged), str(raw)], check=True, timeout=30)
+    return merged
+
+
+def run_flag_comparison(compiler_path: Path, tests_dir: Path) -> bool:
+    """Run the tests that declare '// flags: ...' under --run with and without those flags and compare the output."""
+    GREEN = "\033[92m"
+    RED = "\033[91m"
+    YELLOW = "\033[93m"
+    RESET = "\033[0m"
+    passed = True
+    for test_file in find_test_files(tests_dir):
+        for line in read_directives(test_file).get("flags", []):
+            flags = shlex.split(line)
+            with tempfile.TemporaryDirectory() as work_dir:
+                if "--profile-use" in flags:
+                    try:
+                        profile = collect_profile(compiler_path, test_file, Path(work_dir))
+                    except (subprocess.CalledProcessError, subprocess.TimeoutExpired) as e:
+                        print(f"{RED}FAIL{RESET} [flags] {test_file} {line} - collecting the profile failed: {e}")
+                        passed = False
+                        continue
+                    if profile is None:
+                        print(f"{YELLOW}SKIP{RESET} [flags] {test_file} {line} - needs clang and llvm-profdata")
+                        continue
+                    flags[flags.index("--profile-use")] = f"--profile-use={profile}"
+                expected = run_program(compiler_path, test_file, ["--run"])
+                actual = run_program(compiler_path, test_file, ["--run", *flags])
+            if expected == actual:
+                print(f"{GREEN}PASS{RESET} [flags] {test_file} {line}")
+            else:
+                print(f"{RED}FAIL{RESET} [flags] {test_file} {line} - output differs from the run without flags")
+                passed = False
+    return passed
+
+
+def run_tier_check(compiler_path: Path, tests_dir: Path) -> bool:
+    """Run the tests that declare '// tier-threshold: N' under --tiered and check their output and lowered functions."""
+    GREEN = "\033[92m"
+    RED = "\033[91m"
+    RESET = "\033[0m"
+    passed = True
+    for test_file in find_test_files(tests_dir):
+        directives = read_directives(test_file)
+        if "tier-threshold" not in directives:
+            continue
+        threshold = directives["tier-threshold"][0]
+        try:
+            result = subprocess.run(
+                [str(compiler_path), "--tiered", f"--tier-threshold={threshold}", "--memory-stats", str(test_file)],
+                capture_output=True,
+                text=True,
+                timeout=30
+            )
+        except subprocess.TimeoutExpired:
+            print(f"{RED}FAIL{RESET} [tiered] {test_file} - timeout")
+            passed = False
+            continue
+        reason = ""
+        if (result.stdout, result.returncode) != run_program(compiler_path, test_file, ["--interp"]):
+            reason = "output differs from --interp"
+        expected = directives.get("lowered", [None])[0]
+        lowered = re.search(r"lowered to IR: (\d+) of", result.stderr)
+        if not reason and expected is not None and (lowered is None or lowered.group(1) != expected):
+            reason = f"expected {expected} functions lowered, got {lowered.group(1) if lowered else 'none'}"
+        if reason:
+            print(f"{RED}FAIL{RESET} [tiered] {test_file} - {reason}")
+            passed = False
+        else:
+            print(f"{GREEN}PASS{RESET} [tiered] {test_file}")
+    return passed
+
+
 def main():
-    if len(sys.argv) < 2:
-        print("Usage: python run_tests.py <compiler_path> [tests_dir]")
+    options = [a for a in sys.argv[1:] if a.startswith("--")]
+    args = [a for a in sys.argv[1:] if not a.startswith("--")]
+    if not args:
+        print("Usage: python run_tests.py [--compare-modes] <compiler_path> [tests_dir]")
         print("Example: python run_tests.py ./build/compiler")
         print("         python run_tests.py ./build/compiler ./tests")
+        print("         python run_tests.py --compare-modes ./build/compiler")
         sys.exit(1)
 
-    compiler_path = Path(sys.argv[1])
-    tests_dir = Path(sys.argv[2]) if len(sys.argv) > 2 else Path(__file__).parent
+    compiler_path = Path(args[0])
+    tests_dir = Path(args[1]) if len(args) > 1 else Path(__file__).parent
 
     # Check if compiler exists
     if not compiler_path.exists():
@@ -180,8 +372,12 @@ def main():
         sys.exit(1)
 
     passed, total = run_all_tests(compiler_path, tests_dir)
+    lexer_passed = run_lexer_differential(compiler_path, tests_dir)
+    flags_passed = run_flag_comparison(compiler_path, tests_dir)
+    tier_passed = run_tier_check(compiler_path, tests_dir)
+    modes_passed = run_mode_comparison(compiler_path, tests_dir) if "--compare-modes" in options else True
 
-    sys.exit(0 if passed == total else 1)
+    sys.exit(0 if passed == total and lexer_passed is not False and flags_passed and tier_passed and modes_passed else 1)
 
 
 if __name__ == "__main__":